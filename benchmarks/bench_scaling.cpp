@@ -0,0 +1,145 @@
+/**
+ * @file    bench_scaling.cpp
+ * @author  Galena Group
+ * @brief   Evaluation time and memory of CSparseCircuit against the number of units, next to
+ *          CCircuitN at the sizes it is built for
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/CSparseCircuit.h"
+
+/**
+ * @brief   Time the evaluation of random valid circuits with CSparseCircuitT and print a CSV row
+ *
+ * @param   units       Units per circuit
+ * @param   count       Number of circuits
+ * @param   recycle     Probability that a link left over by the random tree goes to another unit
+ */
+template <class Index>
+static void run_sparse(int units, int count, double recycle)
+{
+    std::vector<std::vector<Index> > circuits(count);
+    std::vector<CSparseCircuitT<Index> > built(count);
+    long sweeps = 0;
+    int failures = 0;
+    std::size_t bytes = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        CRandom rng(units, 0, i);
+        Sparse_Random_Circuit(circuits[i], units, &rng, recycle);
+        built[i].Assign(circuits[i].data(), circuits[i].size());
+        bytes += built[i].Bytes();
+    }
+
+    // at least 0.2 s of evaluations, so small circuits are timed over many repeats
+    int repeats = 0;
+    double ns = 0;
+    auto begin = std::chrono::steady_clock::now();
+    do
+    {
+        for (int i = 0; i < count; i++)
+        {
+            double score = built[i].Evaluate_Circuit();
+            if (repeats == 0)
+            {
+                sweeps += built[i].Last_Iterations();
+                failures += score == -50000;
+            }
+        }
+        repeats++;
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    } while (ns < 2e8);
+
+    double per_eval = ns / ((double)repeats * count);
+    std::cout << "sparse," << 8 * sizeof(Index) << "," << units << "," << count << "," << per_eval << ","
+              << per_eval * count / ((double)sweeps * units) << "," << (double)sweeps / count << ","
+              << bytes / count << "," << failures << std::endl;
+}
+
+/**
+ * @brief   Time the same random valid circuits with CCircuitN and print a CSV row
+ *
+ * @param   count       Number of circuits
+ * @param   recycle     Probability that a link left over by the random tree goes to another unit
+ */
+template <int N>
+static void run_dense(int count, double recycle)
+{
+    std::vector<std::vector<int> > circuits(count);
+    long sweeps = 0;
+    int failures = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        std::vector<std::uint32_t> genes;
+        CRandom rng(N, 0, i);
+        Sparse_Random_Circuit(genes, N, &rng, recycle);
+        circuits[i].assign(genes.begin(), genes.end());
+    }
+
+    int repeats = 0;
+    double ns = 0;
+    auto begin = std::chrono::steady_clock::now();
+    do
+    {
+        for (int i = 0; i < count; i++)
+        {
+            CCircuitN<N> circuit(circuits[i].data());
+            double score = circuit.Evaluate_Circuit();
+            if (repeats == 0)
+            {
+                sweeps += circuit.Last_Iterations();
+                failures += score == -50000;
+            }
+        }
+        repeats++;
+        ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    } while (ns < 2e8);
+
+    double per_eval = ns / ((double)repeats * count);
+    std::cout << "dense,32," << N << "," << count << "," << per_eval << ","
+              << per_eval * count / ((double)sweeps * N) << "," << (double)sweeps / count << ","
+              << sizeof(CCircuitN<N>) << "," << failures << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<int> sizes;
+    int count = 20;
+    double recycle = 0.1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--circuits") == 0 && i + 1 < argc)
+            count = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--recycle") == 0 && i + 1 < argc)
+            recycle = std::atof(argv[++i]);
+        else
+            sizes.push_back(std::atoi(argv[i]));
+    }
+    if (sizes.empty())
+        sizes = {10, 32, 100, 316, 1000, 3162, 10000, 31622};
+
+    std::cout << "engine,index_bits,units,circuits,ns_per_eval,ns_per_unit_sweep,mean_sweeps,bytes,no_convergence"
+              << std::endl;
+
+    run_dense<num_units>(count, recycle);
+    run_dense<max_units>(count, recycle);
+    for (size_t k = 0; k < sizes.size(); k++)
+    {
+        if (sizes[k] <= CSparseCircuit16::Max_Units())
+            run_sparse<std::uint16_t>(sizes[k], count, recycle);
+        run_sparse<std::uint32_t>(sizes[k], count, recycle);
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file    bench_solver.cpp
+ * @author  Galena Group
+ * @brief   Compare the Newton, successive substitution and component solvers of
+ *          Evaluate_Circuit and the lockstep batch evaluator
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/CCircuitBatch.h"
+
+/**
+ * @brief   Random valid circuit vector, drawn the same way as create_parent
+ *
+ * @param   chromosome      Array of length 2 * num_units + 1 to fill
+ */
+static void random_valid_circuit(int *chromosome)
+{
+    do
+    {
+        chromosome[0] = rand() % num_units;
+        for (int i = 0; i < num_units; i++)
+        {
+            int conc, tails;
+            while ((conc = rand() % (num_units + 2)) == i)
+                ;
+            while ((tails = rand() % (num_units + 2)) == i || tails == conc)
+                ;
+            chromosome[i * 2 + 1] = conc;
+            chromosome[i * 2 + 2] = tails;
+        }
+    } while (!CCircuit(chromosome).Check_Validity());
+}
+
+/**
+ * @brief   Evaluate every circuit with one solver and report time and iterations
+ *
+ * @param   name            Label printed in the first column
+ * @param   circuits        Circuit vectors to evaluate
+ * @param   mode            Solver to benchmark
+ * @param   tolerance       Tolerance passed to Evaluate_Circuit
+ * @param   scores          Filled with the score of each circuit
+ */
+static void run(const char *name, std::vector<std::vector<int> > &circuits, Solver_Mode mode,
+                double tolerance, std::vector<double> &scores)
+{
+    const int repeats = 5;
+    long iterations = 0, updates = 0;
+    int failures = 0, fallbacks = 0;
+
+    scores.assign(circuits.size(), 0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+    {
+        for (size_t i = 0; i < circuits.size(); i++)
+        {
+            CCircuit circuit(circuits[i].data());
+            circuit.Set_Solver(mode);
+            scores[i] = circuit.Evaluate_Circuit(tolerance, 1000);
+            if (r == 0)
+            {
+                iterations += circuit.Last_Iterations();
+                updates += circuit.Last_Unit_Updates();
+                failures += scores[i] == -50000;
+                fallbacks += circuit.Fell_Back();
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count() / (repeats * circuits.size());
+
+    const char *solvers[3] = {"substitution", "newton", "components"};
+    std::cout << name << "," << solvers[mode] << "," << circuits.size() << "," << ns << ","
+              << (double)iterations / circuits.size() << "," << (double)updates / circuits.size() << ","
+              << failures << "," << fallbacks << std::endl;
+}
+
+/**
+ * @brief   Evaluate every circuit with CCircuitBatch and report time per circuit
+ *
+ * @param   name            Label printed in the first column
+ * @param   circuits        Circuit vectors to evaluate
+ * @param   tolerance       Tolerance passed to Evaluate_Circuits
+ * @param   scores          Filled with the score of each circuit
+ */
+static void run_batch(const char *name, std::vector<std::vector<int> > &circuits, double tolerance,
+                      std::vector<double> &scores)
+{
+    const int repeats = 5;
+    int failures = 0;
+
+    scores.assign(circuits.size(), 0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+    {
+        CCircuitBatch batch(circuits);
+        batch.Evaluate_Circuits(scores.data(), tolerance, 1000);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count() / (repeats * circuits.size());
+
+    for (size_t i = 0; i < circuits.size(); i++)
+        failures += scores[i] == -50000;
+    std::cout << name << ",batch," << circuits.size() << "," << ns << ",,," << failures << ",0" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int sample = argc > 1 ? atoi(argv[1]) : 1000;
+    std::vector<std::vector<int> > test2 = {
+        {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9, 10, 11, 10, 11, 10, 11, 10, 11},
+        {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11, 7, 11, 8, 11, 9, 11, 10, 11}};
+    std::vector<std::vector<int> > population(sample, std::vector<int>(2 * num_units + 1));
+    std::vector<double> substitution, newton, components, batch;
+
+    srand(42);
+    for (int i = 0; i < sample; i++)
+        random_valid_circuit(population[i].data());
+
+    // circuits whose substitution converges only after many sweeps
+    std::vector<std::vector<int> > recycle;
+    for (int i = 0; i < sample; i++)
+    {
+        CCircuit circuit(population[i].data());
+        if (circuit.Evaluate_Circuit() != -50000 && circuit.Last_Iterations() >= 100)
+            recycle.push_back(population[i]);
+    }
+
+    std::cout << "set,solver,circuits,ns_per_eval,mean_iterations,mean_unit_updates,no_convergence,fallbacks"
+              << std::endl;
+
+    const char *names[3] = {"test2", "population", "recycle"};
+    std::vector<std::vector<int> > *sets[3] = {&test2, &population, &recycle};
+    for (int k = 0; k < 3; k++)
+    {
+        run(names[k], *sets[k], SUBSTITUTION, 1e-6, substitution);
+        run(names[k], *sets[k], NEWTON, 1e-6, newton);
+        run(names[k], *sets[k], COMPONENTS, 1e-6, components);
+        run_batch(names[k], *sets[k], 1e-6, batch);
+
+        // compare only circuits both solvers converged on
+        double max_diff = 0;
+        int newton_only = 0;
+        for (size_t i = 0; i < substitution.size(); i++)
+        {
+            if (substitution[i] == -50000 || newton[i] == -50000)
+            {
+                newton_only += substitution[i] == -50000 && newton[i] != -50000;
+                continue;
+            }
+            max_diff = std::fmax(max_diff, std::fabs(substitution[i] - newton[i]));
+        }
+        double batch_diff = 0, components_diff = 0;
+        for (size_t i = 0; i < substitution.size(); i++)
+        {
+            batch_diff = std::fmax(batch_diff, std::fabs(substitution[i] - batch[i]));
+            components_diff = std::fmax(components_diff, std::fabs(substitution[i] - components[i]));
+        }
+
+        std::cout << "# " << names[k] << ": max score difference " << max_diff
+                  << ", converged only with newton " << newton_only
+                  << ", max batch difference " << batch_diff
+                  << ", max components difference " << components_diff << std::endl;
+    }
+    return 0;
+}
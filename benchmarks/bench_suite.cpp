@@ -0,0 +1,715 @@
+/**
+ * @file    bench_suite.cpp
+ * @author  Galena Group
+ * @brief   Microbenchmarks of the circuit model and the genetic algorithm stages, and
+ *          end-to-end runs, printed as CSV or JSON so two versions can be diffed
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/CFitnessCache.h"
+#include "../includes/CPopulation.h"
+#include "../includes/CRandom.h"
+#include "../includes/CRunLog.h"
+#include "../includes/CSelection.h"
+#include "../includes/Genetic_Algorithm.h"
+#include "../includes/Genetic_Algorithm_internal.h"
+
+using namespace std;
+
+/** Iterations histogram buckets: bucket b counts evaluations that took [2^b, 2^(b+1)) iterations */
+const int histogram_buckets = 11;
+
+/**
+ * @brief   Result of one benchmark, one row of the output
+ */
+struct bench_result
+{
+    /** Name of the benchmark */
+    string name;
+    /** Operations timed in the fastest repeat */
+    long ops = 0;
+    /** Nanoseconds per operation, fastest repeat */
+    double ns_per_op = 0;
+    /** Circuit evaluations per operation, 0 if the benchmark evaluates nothing */
+    double evals_per_op = 0;
+    /** Evaluations that did not converge */
+    long no_convergence = 0;
+    /** Evaluations by iterations to convergence */
+    long histogram[histogram_buckets] = {0};
+    /** Value derived from the results, so a change in behaviour shows up next to a change in speed */
+    double checksum = 0;
+};
+
+/**
+ * @brief   Count the iterations of one evaluation in the histogram
+ *
+ * @param   result          Benchmark result
+ * @param   score           Score returned by Evaluate_Circuit
+ * @param   iterations      Last_Iterations() after the evaluation
+ */
+static void record_iterations(bench_result &result, double score, int iterations)
+{
+    int bucket = 0;
+
+    if (score == -50000)
+    {
+        result.no_convergence++;
+        return;
+    }
+    while (bucket < histogram_buckets - 1 && (2 << bucket) <= iterations)
+        bucket++;
+    result.histogram[bucket]++;
+}
+
+/**
+ * @brief   Time a benchmark body several times and keep the fastest repeat
+ *
+ * @param   result      Benchmark result, ops is the number of operations of one call of body
+ * @param   repeats     Number of repeats
+ * @param   body        Runs the operations once; the first call may also fill the histogram
+ */
+template <typename Body>
+static void time_repeats(bench_result &result, int repeats, Body body)
+{
+    double best = 0;
+
+    for (int r = 0; r < repeats; r++)
+    {
+        auto begin = chrono::steady_clock::now();
+        body(r);
+        auto end = chrono::steady_clock::now();
+        double ns = chrono::duration<double, nano>(end - begin).count();
+
+        if (r == 0 || ns < best)
+            best = ns;
+    }
+    result.ns_per_op = best / result.ops;
+}
+
+/**
+ * @brief   Random valid circuit vectors by rejection sampling, as create_chromosome_set drew
+ *          candidates without Repair
+ *
+ * @param   count       Number of circuits
+ * @param   seed        Seed of the random streams
+ * @return  vector      Valid circuit vectors
+ */
+static vector<gene_array<NUM_UNIT> > random_valid_circuits(int count, unsigned long seed)
+{
+    vector<gene_array<NUM_UNIT> > circuits(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        CRandom rng(seed, 0, i);
+        do
+            random_chromosome<NUM_UNIT>(&circuits[i], &rng);
+        while (!CCircuitN<NUM_UNIT>(circuits[i].data()).Check_Validity());
+    }
+    return circuits;
+}
+
+/**
+ * @brief   CUnit::set_values over a sweep of feed rates
+ */
+static bench_result bench_set_values(int repeats)
+{
+    const int feeds = 1000;
+    bench_result result;
+    CUnit unit;
+
+    result.name = "unit_set_values";
+    result.ops = feeds;
+    time_repeats(result, repeats, [&](int r) {
+        double sum = 0;
+        for (int i = 0; i < feeds; i++)
+        {
+            unit.flow_conc = 1 + i;
+            unit.flow_tails = 10 + 3 * i;
+            unit.set_values();
+            sum += unit.conc_conc - unit.tails_tails;
+        }
+        result.checksum = sum;
+    });
+    return result;
+}
+
+/**
+ * @brief   CCircuitN::Evaluate_Circuit on a fixed set of circuits with one solver
+ */
+static bench_result bench_evaluate(const char *name, const vector<gene_array<NUM_UNIT> > &circuits, Solver_Mode mode,
+                                   int repeats)
+{
+    // small sets are swept several times so every repeat lasts long enough to time
+    int passes = max(1, 1000 / (int)circuits.size());
+    bench_result result;
+
+    result.name = name;
+    result.ops = (long)passes * circuits.size();
+    result.evals_per_op = 1;
+    time_repeats(result, repeats, [&](int r) {
+        double sum = 0;
+        for (int p = 0; p < passes; p++)
+        {
+            for (size_t i = 0; i < circuits.size(); i++)
+            {
+                CCircuitN<NUM_UNIT> circuit(circuits[i].data());
+                circuit.Set_Solver(mode);
+                double score = circuit.Evaluate_Circuit(TOLERANCE, MAX_ITERATIONS);
+                if (r == 0 && p == 0)
+                    record_iterations(result, score, circuit.Last_Iterations());
+                sum += score;
+            }
+        }
+        result.checksum = sum / passes;
+    });
+    return result;
+}
+
+/**
+ * @brief   CCircuitN::Evaluate_Circuit with a threshold on the same circuits as bench_evaluate,
+ *          as the genetic algorithm screens candidates, stopping only when the score cannot
+ *          beat it or, with estimate, also once it is estimated not to. The checksum is the
+ *          number of circuits that beat the threshold; without estimate it must match a full
+ *          evaluation, and with estimate a lower count means circuits were stopped wrongly.
+ */
+static bench_result bench_evaluate_threshold(const char *name, const vector<gene_array<NUM_UNIT> > &circuits,
+                                             Solver_Mode mode, double threshold, bool estimate, int repeats)
+{
+    int passes = max(1, 1000 / (int)circuits.size());
+    bench_result result;
+    CCircuitN<NUM_UNIT> circuit;
+
+    result.name = name;
+    result.ops = (long)passes * circuits.size();
+    result.evals_per_op = 1;
+    time_repeats(result, repeats, [&](int r) {
+        long kept = 0;
+        for (int p = 0; p < passes; p++)
+        {
+            for (size_t i = 0; i < circuits.size(); i++)
+            {
+                double score = Evaluate_Genes(gene_span<int>{circuits[i].data(), circuits[i].size()}, circuit, mode,
+                                              NULL, TOLERANCE, MAX_ITERATIONS, threshold, estimate);
+                if (r == 0 && p == 0)
+                    record_iterations(result, score, circuit.Last_Iterations());
+                kept += score > threshold;
+            }
+        }
+        result.checksum = (double)kept / passes;
+    });
+    return result;
+}
+
+/**
+ * @brief   Children of converging circuits that differ from their parent by one mutated
+ *          gene, and the steady state of the parent, for the warm start benchmarks
+ *
+ * @param   parents         Random valid circuits
+ * @param   children        Receives one valid child per converging parent
+ * @param   flows           Receives the steady state of each child's parent
+ */
+static void mutated_children(const vector<gene_array<NUM_UNIT> > &parents, vector<gene_array<NUM_UNIT> > &children,
+                             vector<array<double, 2 * NUM_UNIT> > &flows)
+{
+    for (size_t i = 0; i < parents.size(); i++)
+    {
+        CCircuitN<NUM_UNIT> parent(parents[i].data());
+        array<double, 2 * NUM_UNIT> parent_flows;
+
+        parent.Set_Solver(SOLVER);
+        if (parent.Evaluate_Circuit(TOLERANCE, MAX_ITERATIONS) == -50000)
+            continue;
+        parent.Get_Flows(parent_flows.data());
+
+        // the mutation of mutate: one gene set to any unit or outlet
+        CRandom rng(5, 0, i);
+        gene_array<NUM_UNIT> child;
+        do
+        {
+            child = parents[i];
+            child[rng.Uniform_Int(2 * NUM_UNIT + 1)] = rng.Uniform_Int(NUM_UNIT + 2);
+        } while (child == parents[i] || !CCircuitN<NUM_UNIT>(child.data()).Check_Validity());
+
+        children.push_back(child);
+        flows.push_back(parent_flows);
+    }
+}
+
+/**
+ * @brief   Evaluate_Circuit on mutated children, from the circuit feed or from the steady state of the parent
+ */
+static bench_result bench_evaluate_child(const char *name, const vector<gene_array<NUM_UNIT> > &children,
+                                         const vector<array<double, 2 * NUM_UNIT> > &flows, Solver_Mode mode,
+                                         bool warm, int repeats)
+{
+    bench_result result;
+
+    result.name = name;
+    result.ops = children.size();
+    result.evals_per_op = 1;
+    time_repeats(result, repeats, [&](int r) {
+        double sum = 0;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            CCircuitN<NUM_UNIT> circuit(children[i].data());
+            circuit.Set_Solver(mode);
+            if (warm)
+                circuit.Set_Initial_Flows(flows[i].data());
+            double score = circuit.Evaluate_Circuit(TOLERANCE, MAX_ITERATIONS);
+            if (r == 0)
+                record_iterations(result, score, circuit.Last_Iterations());
+            sum += score;
+        }
+        result.checksum = sum;
+    });
+    return result;
+}
+
+/**
+ * @brief   CCircuitN::Check_Validity on random chromosomes, most of which are invalid
+ */
+static bench_result bench_check_validity(int sample, int repeats)
+{
+    vector<gene_array<NUM_UNIT> > circuits(sample);
+    bench_result result;
+
+    for (int i = 0; i < sample; i++)
+    {
+        CRandom rng(1, 0, i);
+        random_chromosome<NUM_UNIT>(&circuits[i], &rng);
+    }
+
+    result.name = "check_validity";
+    result.ops = sample;
+    time_repeats(result, repeats, [&](int r) {
+        int valid = 0;
+        for (int i = 0; i < sample; i++)
+            valid += CCircuitN<NUM_UNIT>(circuits[i].data()).Check_Validity();
+        result.checksum = valid;
+    });
+    return result;
+}
+
+/**
+ * @brief   Validate_Genes on the same random chromosomes, read in place
+ */
+static bench_result bench_validate_genes(int sample, int repeats)
+{
+    vector<gene_array<NUM_UNIT> > circuits(sample);
+    bench_result result;
+
+    for (int i = 0; i < sample; i++)
+    {
+        CRandom rng(1, 0, i);
+        random_chromosome<NUM_UNIT>(&circuits[i], &rng);
+    }
+
+    result.name = "validate_genes";
+    result.ops = sample;
+    time_repeats(result, repeats, [&](int r) {
+        int valid = 0;
+        for (int i = 0; i < sample; i++)
+            valid += Validate_Genes<NUM_UNIT>(gene_span<int>{circuits[i].data(), circuits[i].size()});
+        result.checksum = valid;
+    });
+    return result;
+}
+
+/**
+ * @brief   Validate_Batch on the same random chromosomes packed into a CPopulation
+ */
+static bench_result bench_validate_batch(int sample, int repeats)
+{
+    CPopulationN<NUM_UNIT> circuits(sample);
+    unique_ptr<bool[]> valid(new bool[sample]);
+    bench_result result;
+
+    for (int i = 0; i < sample; i++)
+    {
+        gene_array<NUM_UNIT> circuit;
+        CRandom rng(1, 0, i);
+        random_chromosome<NUM_UNIT>(&circuit, &rng);
+        circuits.Set(i, circuit.data());
+    }
+
+    result.name = "validate_batch";
+    result.ops = sample;
+    time_repeats(result, repeats, [&](int r) {
+        result.checksum = Validate_Batch<NUM_UNIT>(circuits[0], sample, valid.get());
+    });
+    return result;
+}
+
+/**
+ * @brief   Drawing one valid parent: random chromosomes until one passes Check_Validity
+ */
+static bench_result bench_create_parent(int sample, int repeats)
+{
+    bench_result result;
+
+    result.name = "create_parent";
+    result.ops = sample;
+    time_repeats(result, repeats, [&](int r) {
+        vector<gene_array<NUM_UNIT> > circuits = random_valid_circuits(sample, 2);
+        result.checksum = circuits[sample - 1][0];
+    });
+    return result;
+}
+
+/**
+ * @brief   Drawing one valid parent with valid_chromosome: random genes, repaired if invalid
+ */
+static bench_result bench_generate_parent(int sample, int repeats)
+{
+    bench_result result;
+
+    result.name = "generate_parent";
+    result.ops = sample;
+    time_repeats(result, repeats, [&](int r) {
+        gene_array<NUM_UNIT> circuit;
+        long sum = 0;
+        for (int i = 0; i < sample; i++)
+        {
+            CRandom rng(2, 0, i);
+            valid_chromosome<NUM_UNIT>(&circuit, &rng);
+            sum += circuit[0];
+        }
+        result.checksum = sum;
+    });
+    return result;
+}
+
+/**
+ * @brief   create_chromosome_set: the whole initial population, cache cleared every repeat
+ */
+static bench_result bench_create_parent_set(int repeats)
+{
+    bench_result result;
+    long misses = 0;
+
+    result.name = "create_parent_set";
+    result.ops = NUM_PARENT;
+    time_repeats(result, repeats, [&](int r) {
+        CFitnessCacheN<NUM_UNIT> cache(CACHE_SIZE);
+        CPopulationN<NUM_UNIT> parent_set;
+        create_chromosome_set<NUM_UNIT>(&parent_set, NUM_PARENT, &cache, 3);
+        misses = cache.misses;
+        result.checksum = parent_set[NUM_PARENT - 1][0];
+    });
+    result.evals_per_op = (double)misses / result.ops;
+    return result;
+}
+
+/**
+ * @brief   CSelection on the fitness values of a seeded population: one Build and the
+ *          draws of one generation, 2 * NUM_CHILDREN, per simulated generation
+ */
+static bench_result bench_select_parent(const char *name, Selection_Mode mode, int repeats)
+{
+    const int generations = 50;
+    const int draws = 2 * NUM_CHILDREN;
+    CFitnessCacheN<NUM_UNIT> cache(CACHE_SIZE);
+    CPopulationN<NUM_UNIT> parent_set;
+    vector<double> score;
+    CSelection selection(mode, TOURNAMENT_SIZE);
+    bench_result result;
+
+    create_chromosome_set<NUM_UNIT>(&parent_set, NUM_PARENT, &cache, 3);
+    calculate_fitness_value(&score, parent_set, TOLERANCE, MAX_ITERATIONS, &cache);
+
+    result.name = name;
+    result.ops = generations * draws;
+    time_repeats(result, repeats, [&](int r) {
+        long sum = 0;
+        for (int g = 0; g < generations; g++)
+        {
+            selection.Build(score);
+            for (int i = 0; i < draws; i++)
+            {
+                CRandom rng(3, g + 1, i);
+                sum += selection.Select(&rng);
+            }
+        }
+        result.checksum = sum;
+    });
+    return result;
+}
+
+/**
+ * @brief   evolve_generation: generations of a seeded population, each repeat continuing the last
+ */
+static bench_result bench_generation(int repeats)
+{
+    const int generations = 20;
+    ga_population<NUM_UNIT> population(3);
+    long misses = 0;
+    int k = 0;
+    bench_result result;
+
+    create_chromosome_set<NUM_UNIT>(&population.parent_set, NUM_PARENT, &population.cache, population.seed);
+
+    result.name = "generation";
+    result.ops = generations;
+    time_repeats(result, repeats, [&](int r) {
+        long before = population.cache.misses;
+        for (int g = 0; g < generations; g++)
+            evolve_generation(population, k++);
+        misses = population.cache.misses - before;
+        result.checksum = population.the_max_value;
+    });
+    result.evals_per_op = (double)misses / result.ops;
+    return result;
+}
+
+/**
+ * @brief   A whole run of the genetic algorithm with a fixed seed, as genetic_algorithm runs it
+ */
+static bench_result bench_full_run(unsigned long seed, int repeats)
+{
+    bench_result result;
+    long misses = 0;
+
+    result.name = "full_run_seed_" + to_string(seed);
+    result.ops = 1;
+    time_repeats(result, repeats, [&](int r) {
+        ga_population<NUM_UNIT> population(seed);
+        create_chromosome_set<NUM_UNIT>(&population.parent_set, NUM_PARENT, &population.cache, seed);
+        for (int k = 0; k < MAX_EVOLUTIONS; k++)
+            evolve_generation(population, k);
+        misses = population.cache.misses;
+        result.checksum = population.finalsocre;
+    });
+    result.evals_per_op = misses;
+    return result;
+}
+
+/**
+ * @brief   Logging the best circuit of every generation of a run, as text lines the way Print
+ *          used to write them or through CRunLog. Every op is one generation; the file is
+ *          closed, so the time includes writing it out.
+ */
+static bench_result bench_run_log(bool binary, int repeats)
+{
+    const char *path = "bench_run_log.tmp";
+    gene_array<NUM_UNIT> circuit = random_valid_circuits(1, 5)[0];
+    unsigned char genes[2 * NUM_UNIT + 1];
+    bench_result result;
+
+    for (int i = 0; i < 2 * NUM_UNIT + 1; i++)
+        genes[i] = circuit[i];
+
+    result.name = binary ? "run_log_binary" : "run_log_text";
+    result.ops = MAX_EVOLUTIONS;
+    time_repeats(result, repeats, [&](int r) {
+        if (binary)
+        {
+            CRunLog log;
+            log.Open(path, NUM_UNIT, 5);
+            for (int k = 1; k <= MAX_EVOLUTIONS; k++)
+                log.Append(k, k * 0.1, k * 1e-4, 0, genes);
+            log.Close();
+        }
+        else
+        {
+            ofstream outfile(path);
+            for (int k = 1; k <= MAX_EVOLUTIONS; k++)
+            {
+                for (int i = 0; i < 2 * NUM_UNIT + 1; i++)
+                    outfile << (int)genes[i] << " ";
+                outfile << k * 0.1 << endl;
+            }
+        }
+    });
+
+    ifstream written(path, ios::binary | ios::ate);
+    result.checksum = written.tellg();
+    written.close();
+    remove(path);
+    return result;
+}
+
+/**
+ * @brief   Print the results as CSV, one row per benchmark
+ */
+static void print_csv(ostream &out, const vector<bench_result> &results)
+{
+    out.precision(10);
+    out << "name,ops,ns_per_op,evals_per_s,no_convergence,checksum";
+    for (int b = 0; b < histogram_buckets; b++)
+        out << ",iterations_" << (1 << b);
+    out << endl;
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const bench_result &r = results[i];
+        out << r.name << "," << r.ops << "," << r.ns_per_op << "," << r.evals_per_op * 1e9 / r.ns_per_op << ","
+            << r.no_convergence << "," << r.checksum;
+        for (int b = 0; b < histogram_buckets; b++)
+            out << "," << r.histogram[b];
+        out << endl;
+    }
+}
+
+/**
+ * @brief   Print the results as a JSON document
+ */
+static void print_json(ostream &out, const vector<bench_result> &results)
+{
+    out.precision(10);
+    out << "{\n  \"unit_num\": " << NUM_UNIT << ",\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const bench_result &r = results[i];
+        out << (i ? "," : "") << "\n    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+            << ", \"ns_per_op\": " << r.ns_per_op << ", \"evals_per_s\": " << r.evals_per_op * 1e9 / r.ns_per_op
+            << ", \"no_convergence\": " << r.no_convergence << ", \"checksum\": " << r.checksum
+            << ", \"iterations_histogram\": {";
+        for (int b = 0; b < histogram_buckets; b++)
+            out << (b ? ", " : "") << "\"" << (1 << b) << "\": " << r.histogram[b];
+        out << "}}";
+    }
+    out << "\n  ]\n}" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    bool json = false;
+    const char *filter = "";
+    const char *output = NULL;
+    int repeats = 5;
+    int sample = 1000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--json"))
+            json = true;
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            output = argv[++i];
+        else if (!strcmp(argv[i], "--repeats") && i + 1 < argc)
+            repeats = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--sample") && i + 1 < argc)
+            sample = max(1, atoi(argv[++i]));
+        else
+        {
+            cerr << "usage: " << argv[0] << " [--json] [--filter name] [--output file] [--repeats n] [--sample n]"
+                 << endl;
+            return 1;
+        }
+    }
+
+    // the test2 circuits are of 10 units
+    vector<gene_array<NUM_UNIT> > fixed;
+    #if NUM_UNIT == 10
+      fixed.push_back({0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9, 10, 11, 10, 11, 10, 11, 10, 11});
+      fixed.push_back({0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11, 7, 11, 8, 11, 9, 11, 10, 11});
+    #endif
+    vector<gene_array<NUM_UNIT> > population = random_valid_circuits(sample, 42);
+
+    // each entry runs only if its name contains the filter
+    vector<bench_result> results;
+    auto wanted = [filter](const string &name) { return name.find(filter) != string::npos; };
+
+    if (wanted("unit_set_values"))
+        results.push_back(bench_set_values(repeats));
+    if (!fixed.empty() && wanted("evaluate_test2_substitution"))
+        results.push_back(bench_evaluate("evaluate_test2_substitution", fixed, SUBSTITUTION, repeats));
+    if (!fixed.empty() && wanted("evaluate_test2_newton"))
+        results.push_back(bench_evaluate("evaluate_test2_newton", fixed, NEWTON, repeats));
+    if (!fixed.empty() && wanted("evaluate_test2_components"))
+        results.push_back(bench_evaluate("evaluate_test2_components", fixed, COMPONENTS, repeats));
+    if (wanted("evaluate_random_substitution"))
+        results.push_back(bench_evaluate("evaluate_random_substitution", population, SUBSTITUTION, repeats));
+    if (wanted("evaluate_random_newton"))
+        results.push_back(bench_evaluate("evaluate_random_newton", population, NEWTON, repeats));
+    if (wanted("evaluate_random_components"))
+        results.push_back(bench_evaluate("evaluate_random_components", population, COMPONENTS, repeats));
+    if (wanted("evaluate_threshold_substitution"))
+        results.push_back(bench_evaluate_threshold("evaluate_threshold_substitution", population, SUBSTITUTION, 50,
+                                                   false, repeats));
+    if (wanted("evaluate_threshold_newton"))
+        results.push_back(bench_evaluate_threshold("evaluate_threshold_newton", population, NEWTON, 50, false,
+                                                   repeats));
+    if (wanted("evaluate_estimate_substitution"))
+        results.push_back(bench_evaluate_threshold("evaluate_estimate_substitution", population, SUBSTITUTION, 50,
+                                                   true, repeats));
+    if (wanted("evaluate_estimate_newton"))
+        results.push_back(bench_evaluate_threshold("evaluate_estimate_newton", population, NEWTON, 50, true,
+                                                   repeats));
+
+    // children one mutation away from a converging parent, as the genetic algorithm breeds them
+    vector<gene_array<NUM_UNIT> > children;
+    vector<array<double, 2 * NUM_UNIT> > parent_flows;
+    mutated_children(population, children, parent_flows);
+
+    if (wanted("evaluate_child_cold_substitution"))
+        results.push_back(bench_evaluate_child("evaluate_child_cold_substitution", children, parent_flows,
+                                               SUBSTITUTION, false, repeats));
+    if (wanted("evaluate_child_warm_substitution"))
+        results.push_back(bench_evaluate_child("evaluate_child_warm_substitution", children, parent_flows,
+                                               SUBSTITUTION, true, repeats));
+    if (wanted("evaluate_child_cold_newton"))
+        results.push_back(bench_evaluate_child("evaluate_child_cold_newton", children, parent_flows,
+                                               NEWTON, false, repeats));
+    if (wanted("evaluate_child_warm_newton"))
+        results.push_back(bench_evaluate_child("evaluate_child_warm_newton", children, parent_flows,
+                                               NEWTON, true, repeats));
+    if (wanted("check_validity"))
+        results.push_back(bench_check_validity(sample * 10, repeats));
+    if (wanted("validate_genes"))
+        results.push_back(bench_validate_genes(sample * 10, repeats));
+    if (wanted("validate_batch"))
+        results.push_back(bench_validate_batch(sample * 10, repeats));
+    if (wanted("generate_parent"))
+        results.push_back(bench_generate_parent(sample * 10, repeats));
+    if (wanted("create_parent"))
+        results.push_back(bench_create_parent(sample / 10 + 1, repeats));
+    if (wanted("create_parent_set"))
+        results.push_back(bench_create_parent_set(repeats));
+    if (wanted("select_parent_roulette"))
+        results.push_back(bench_select_parent("select_parent_roulette", ROULETTE, repeats));
+    if (wanted("select_parent_tournament"))
+        results.push_back(bench_select_parent("select_parent_tournament", TOURNAMENT, repeats));
+    if (wanted("select_parent_rank"))
+        results.push_back(bench_select_parent("select_parent_rank", RANK, repeats));
+    if (wanted("generation"))
+        results.push_back(bench_generation(repeats));
+    if (wanted("run_log_text"))
+        results.push_back(bench_run_log(false, repeats));
+    if (wanted("run_log_binary"))
+        results.push_back(bench_run_log(true, repeats));
+    if (wanted("full_run"))
+        results.push_back(bench_full_run(7, 1));
+
+    ofstream file;
+    if (output != NULL)
+    {
+        file.open(output);
+        if (!file)
+        {
+            cerr << "cannot write " << output << endl;
+            return 1;
+        }
+    }
+    ostream &out = output != NULL ? file : cout;
+
+    if (json)
+        print_json(out, results);
+    else
+        print_csv(out, results);
+    return 0;
+}
@@ -0,0 +1,23 @@
+import json
+import sys
+
+
+if len(sys.argv) != 3:
+    print("usage: python3 compare.py before.json after.json")
+    sys.exit(1)
+
+with open(sys.argv[1]) as f:
+    before = {b["name"]: b for b in json.load(f)["benchmarks"]}
+with open(sys.argv[2]) as f:
+    after = {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+print("%-30s %14s %14s %9s  %s" % ("name", "before ns/op", "after ns/op", "change", "checksum"))
+for name, new in after.items():
+    if name not in before:
+        print("%-30s %14s %14.1f %9s" % (name, "-", new["ns_per_op"], "new"))
+        continue
+    old = before[name]
+    change = 100.0 * (new["ns_per_op"] - old["ns_per_op"]) / old["ns_per_op"]
+    # a different checksum means the benchmark no longer computes the same thing
+    same = "same" if old["checksum"] == new["checksum"] else "CHANGED"
+    print("%-30s %14.1f %14.1f %8.1f%%  %s" % (name, old["ns_per_op"], new["ns_per_op"], change, same))
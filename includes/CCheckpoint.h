@@ -0,0 +1,121 @@
+/**
+ * @file    CCheckpoint.h
+ * @author  Galena Group
+ * @brief   Header file for the CCheckpointWriter and CCheckpointReader classes
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Version of the checkpoint format */
+const std::uint32_t checkpoint_version = 3;
+
+/**
+* @brief    Start of a checkpoint file. The header is followed by size bytes of state, in
+*           the order the genetic algorithm wrote it and in the byte order of the machine
+*           that wrote it, so a checkpoint is resumed on the machine type that wrote it.
+*/
+struct checkpoint_header
+{
+    /** "GACHECKP" */
+    char magic[8];
+    /** checkpoint_version */
+    std::uint32_t version;
+    /** Units in the circuits of the run */
+    std::uint32_t unit_count;
+    /** Bytes of state after the header */
+    std::uint64_t size;
+    /** FNV-1a hash of the state, to refuse a damaged file */
+    std::uint64_t checksum;
+};
+
+static_assert(sizeof(checkpoint_header) == 32, "checkpoint header is not packed");
+
+/**
+* @brief    Collects the state of a run in memory and commits it to a file atomically: the
+*           file is written under a temporary name, flushed to the disk and renamed over the
+*           last checkpoint, so a run killed at any point leaves a complete checkpoint behind.
+*/
+class CCheckpointWriter
+{
+public:
+
+    // Append bytes to the state
+    void Write(const void *data, std::size_t bytes);
+
+    /**
+     * @brief   Append a value with no pointers to the state
+     *
+     * @param   value       Value to append
+     */
+    template <class T>
+    void Write_Value(const T &value)
+    {
+        this->Write(&value, sizeof(T));
+    }
+
+    // Append a string to the state, its length first
+    void Write_String(const std::string &text);
+
+    // Write the state to a file, replacing any checkpoint of that name only once it is complete
+    bool Commit(const char *path, int unit_count) const;
+
+    // Bytes of state collected
+    std::size_t Size() const;
+
+private:
+
+    /** State collected so far */
+    std::vector<unsigned char> state;
+};
+
+/**
+* @brief    Reads the state of a checkpoint back in the order it was written
+*/
+class CCheckpointReader
+{
+public:
+
+    // Read a checkpoint and check its header and checksum
+    bool Open(const char *path);
+
+    // Units in the circuits of the run
+    int Unit_Count() const;
+
+    // Take bytes from the state
+    bool Read(void *data, std::size_t bytes);
+
+    /**
+     * @brief   Take a value written with Write_Value from the state
+     *
+     * @param   value       Receives the value
+     * @return  bool        false if the state ran out
+     */
+    template <class T>
+    bool Read_Value(T &value)
+    {
+        return this->Read(&value, sizeof(T));
+    }
+
+    // Take a string written with Write_String from the state
+    bool Read_String(std::string &text);
+
+    // True if every byte of the state has been read
+    bool Done() const;
+
+private:
+
+    /** State of the checkpoint */
+    std::vector<unsigned char> state;
+    /** Bytes of state read so far */
+    std::size_t position = 0;
+    /** Units in the circuits of the run, 0 if no checkpoint is open */
+    int unit_count = 0;
+};
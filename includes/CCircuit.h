@@ -9,45 +9,162 @@
  * 
  */
 #pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 #include "CUnit.h"
 
-/** Number of units. This is constant and default value is 10 */
+/** Number of units of the default circuit, CCircuit. This is constant and default value is 10 */
 const int num_units = 10;
 
+/** Smallest circuit size built into the library */
+const int min_units = 4;
+/** Largest circuit size built into the library */
+const int max_units = 32;
+
+/** Applies X to every circuit size built into the library, min_units to max_units */
+#define FOR_EACH_UNIT_COUNT(X) \
+    X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) X(16) X(17) \
+    X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29) X(30) \
+    X(31) X(32)
+
+/** Maximum number of Newton steps before falling back to successive substitution */
+const int max_newton_steps = 50;
+/** Substitution sweeps run before switching to Newton's method */
+const int newton_start_sweeps = 10;
+/** Newton steps allowed without halving the residual before giving up */
+const int newton_stall_steps = 6;
+/** Largest rate at which the feed rates settle, change of one sweep over that of the sweep
+    before, for which an evaluation that may estimate its score trusts the estimate */
+const double threshold_max_rate = 0.9;
+/** Sweeps in a row that must settle below threshold_max_rate before that estimate is made */
+const int threshold_settled_sweeps = 4;
+/** Factor the distance left to the steady state is widened by in that estimate, since a rate
+    that oscillates can rise again after a few low sweeps */
+const double threshold_safety = 4;
+
+/** Steady-state solver used by CCircuit::Evaluate_Circuit */
+enum Solver_Mode
+{
+    /** Successive substitution of the feed rates until they stop changing */
+    SUBSTITUTION,
+    /** Newton's method on the mass balance once a few sweeps have not converged,
+        continuing with SUBSTITUTION if it diverges */
+    NEWTON,
+    /** SUBSTITUTION confined to the recycle loops: the circuit is split into strongly connected
+        components, units outside a loop are computed once from their settled feed and each loop
+        sweeps only its own units until they stop changing */
+    COMPONENTS
+};
+
+/** Chromosome of an N unit circuit packed one gene per byte, used as a compact key for a circuit */
+template <int N>
+using circuit_key = std::array<unsigned char, 2 * N + 1>;
+
+/** Key of the default circuit size */
+typedef circuit_key<num_units> chromosome_key;
+
 /**
-* @brief    Circuit made up of units connected to each other, constructed from chromosome array or vector
+* @brief    Non-owning view of a circuit vector: where its genes start and how many there are.
+*           Genes are int in a circuit vector and unsigned char in a CPopulation or a circuit_key.
 */
-class CCircuit
+template <class Gene>
+struct gene_span
+{
+    /** First gene */
+    const Gene *data;
+    /** Number of genes, 2 * N + 1 for an N unit circuit */
+    std::size_t size;
+};
+
+/**
+* @brief    Circuit made up of N units connected to each other, constructed from chromosome array or vector.
+*           The library is built for every N from min_units to max_units.
+*/
+template <int N>
+class CCircuitN
 {
 public:
 
-    // Constructor for CCircuit object from circuit vector
-    CCircuit(std::vector<int> chromosome, double tolerance = 1e-6, \
+    // Constructor for an empty CCircuitN object, to be filled by Assign
+    CCircuitN();
+
+    // Constructor for CCircuitN object from circuit vector
+    CCircuitN(const std::vector<int> &chromosome, double tolerance = 1e-6, \
             int max_iterations = 1000, int initial_conc = 10, \
             int initial_tails = 100);
 
-    // Constructor for CCircuit object from circuit vector stored as an integer array
-    CCircuit(int *chromosome, double tolerance = 1e-6, \
+    // Constructor for CCircuitN object from circuit vector stored as an integer array
+    CCircuitN(const int *chromosome, double tolerance = 1e-6, \
             int max_iterations = 1000, int initial_conc = 10, \
             int initial_tails = 100);
 
+    // Replace the circuit with the one viewed by genes
+    bool Assign(gene_span<int> genes);
+
+    // Replace the circuit with the one viewed by packed genes
+    bool Assign(gene_span<unsigned char> genes);
+
     // Check validity of circuit
     bool Check_Validity();
     
+    // Score a circuit based on its performance, to the tolerance it was constructed with
+    double Evaluate_Circuit();
+
     // Score a circuit based on its performance
-    double Evaluate_Circuit(double tolerance = 1e-6, int max_iterations = 1000);
+    double Evaluate_Circuit(double tolerance, int max_iterations = 1000);
+
+    // Choose the steady-state solver used by Evaluate_Circuit
+    void Set_Solver(Solver_Mode mode);
+
+    // Number of sweeps or Newton steps used by the last Evaluate_Circuit call
+    int Last_Iterations();
+
+    // Number of times the last Evaluate_Circuit call reset the feed of a unit close to 0
+    int Last_Clamps();
+
+    // Number of times the last Evaluate_Circuit call computed the streams of a unit
+    int Last_Unit_Updates();
+
+    // Strongly connected components of the circuit in the order material flows through them
+    int Components(std::uint32_t *components);
+
+    // Whether the last Evaluate_Circuit call fell back from Newton to substitution
+    bool Fell_Back();
+
+    // Whether waste piles up in the circuit, so that it has no steady state
+    bool Waste_Overflows();
+
+    // Stop the next evaluations as soon as the score cannot exceed threshold, or, if estimate, is estimated not to
+    void Set_Threshold(double threshold, bool estimate = false);
+
+    // Whether the last Evaluate_Circuit call stopped early at the threshold
+    bool Aborted();
+
+    // Sweeps the last Evaluate_Circuit call is projected to have skipped by stopping at the threshold
+    int Saved_Sweeps();
+
+    // Start the next evaluations from given feed rates instead of the circuit feed
+    void Set_Initial_Flows(const double *flows);
+
+    // Feed rates of every unit at the end of the last evaluation
+    void Get_Flows(double *flows);
+
+    // Relabel units into canonical order and write the resulting circuit vector
+    void Canonical_Form(int *canonical, int *order = NULL);
+
+    // Compact key shared by every relabelling of the same circuit
+    circuit_key<N> Canonical_Key();
 
 private:
 
-    /** Array of units of length num_units. Build up the circuit. */
-    CUnit units[num_units];
+    /** Array of units of length N. Build up the circuit. */
+    std::array<CUnit, N> units;
 
     /** Feed unit number */
     int start;
-    /** True if concentrate outlet is found */
-    bool conc_toend;
-    /** True if tailings outlet is found */
-    bool tails_toend;
 
     /** tolerance for error in concentrate flow an tailings flow */
     double tolerance;
@@ -58,13 +175,110 @@ private:
     double initial_conc;
     /** Initial value of tailings outlet */
     double initial_tails;
+
+    /** Steady-state solver used by Evaluate_Circuit */
+    Solver_Mode solver = SUBSTITUTION;
+    /** Sweeps or Newton steps used by the last evaluation */
+    int iterations = 0;
+    /** Times the last evaluation reset the feed of a unit close to 0 */
+    int clamps = 0;
+    /** True if the last evaluation fell back from Newton to substitution */
+    bool fell_back = false;
+    /** Times the last evaluation computed the streams of a unit */
+    int updates = 0;
+
+    /** True if components holds the decomposition of the current circuit */
+    bool decomposed = false;
+    /** Number of strongly connected components */
+    int component_num = 0;
+    /** Units of every strongly connected component, one bit per unit, upstream components first */
+    std::array<std::uint32_t, N> components;
+
+    /** Score an evaluation must be able to exceed to go on, -HUGE_VAL for none */
+    double threshold = -HUGE_VAL;
+    /** True if evaluations may also stop once the score is only estimated not to exceed threshold */
+    bool estimate_threshold = false;
+    /** True if the last evaluation stopped early at the threshold */
+    bool aborted = false;
+    /** Sweeps the last evaluation is projected to have skipped by stopping early */
+    int saved_sweeps = 0;
+
+    /** True if evaluations start from initial_flows */
+    bool warm_start = false;
+    /** Feed rates to start from, concentrate and tailings of unit 0, then of unit 1, ... */
+    std::array<double, 2 * N> initial_flows;
     
-    // Transfer data from circuit vector to a vector of units i.e. circuit
-    void vector2units(std::vector<int> chromosome);
+    // Transfer data from circuit vector stored as an array of int or of packed genes to a vector of units i.e. circuit
+    template <class Gene>
+    void vector2units(const Gene *chromosome);
+
+    // Circuit vector of the units
+    void units2vector(int *chromosome);
+
+    // Performance of the circuit from the streams computed by the last set_values call
+    double outlet_performance();
+
+    // Largest change of a feed rate in the last sweep
+    double feed_change();
+
+    // Highest score the circuit can reach if no feed rate is further than distance from the last one
+    double score_ceiling(double distance);
+
+    // Residual and Jacobian of the steady-state mass balance
+    void mass_balance(const double *x, double *residual, double *jacobian);
+
+    // Solve the steady-state mass balance with damped Newton's method
+    bool solve_newton(double tolerance, int max_iterations);
 
-    // Transfer data from circuit vector stored as an integer array to a vector of units i.e. circuit
-    void vector2units(int *chromosome);
+    // Split the circuit into strongly connected components in topological order
+    void decompose();
 
-    // Traverse circuit and mark units that have been passed
-    void mark_units(int unit_num);  
+    // Solve the circuit one strongly connected component at a time
+    double evaluate_components(double tolerance, int max_iterations);
+
+    // Successive substitution over the units of one recycle loop
+    bool solve_loop(std::uint32_t members, const double *inflow, double tolerance, int max_iterations);
 };
+
+/** Circuit of the default size */
+typedef CCircuitN<num_units> CCircuit;
+
+// Score the circuit viewed by genes, with scratch as the only working storage
+template <int N, class Gene>
+double Evaluate_Genes(gene_span<Gene> genes, CCircuitN<N> &scratch, Solver_Mode mode = SUBSTITUTION, \
+                      const double *initial_flows = NULL, double tolerance = 1e-6, int max_iterations = 1000, \
+                      double threshold = -HUGE_VAL, bool estimate = false);
+
+/**
+* @brief    Reachability of the units of a circuit, bit i for unit i
+*/
+struct circuit_reach
+{
+    /** Units reachable from the feed */
+    std::uint32_t from_feed;
+    /** Units with a route to the concentrate outlet */
+    std::uint32_t to_conc;
+    /** Units with a route to the tailings outlet */
+    std::uint32_t to_tails;
+    /** Every unit of the circuit */
+    std::uint32_t all;
+};
+
+// Check validity of the circuit viewed by genes
+template <int N, class Gene>
+bool Validate_Genes(gene_span<Gene> genes);
+
+// Which units are reachable from the feed and which have a route to each outlet
+template <int N, class Gene>
+circuit_reach Circuit_Reach(gene_span<Gene> genes);
+
+// Check validity of count circuit vectors stored back to back
+template <int N, class Gene>
+int Validate_Batch(const Gene *genes, int count, bool *valid);
+
+// Check validity of a circuit vector of any size built into the library
+bool Circuit_Validity(const std::vector<int> &chromosome);
+
+// Score a circuit vector of any size built into the library
+double Circuit_Performance(const std::vector<int> &chromosome, Solver_Mode mode = SUBSTITUTION, \
+                           double tolerance = 1e-6, int max_iterations = 1000);
@@ -0,0 +1,128 @@
+/**
+ * @file    CCircuitBatch.h
+ * @author  Galena Group
+ * @brief   Header file for the CCircuitBatch class
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <vector>
+#include "CCircuit.h"
+
+/** Number of circuits simulated in lockstep, one per lane of an AVX2 register of doubles */
+const int batch_lanes = 4;
+/** Number of circuits screened in lockstep, one per lane of an AVX2 register of floats */
+const int screen_lanes = 8;
+
+/**
+ * @brief   Operating conditions a circuit is scored under: the feed, the flotation kinetics
+ *          and the prices. The defaults are the constants of CUnit.h and the weights of
+ *          Evaluate_Circuit, so a default scenario scores a circuit as Evaluate_Circuit does.
+ */
+struct circuit_scenario
+{
+    /** Gormanium fed to the circuit */
+    double feed_conc = 10;
+    /** Waste fed to the circuit */
+    double feed_tails = 100;
+    /** Rate constant of gormanium */
+    double rate_conc = K_conc;
+    /** Rate constant of waste */
+    double rate_tails = K_tails;
+    /** Volume of a unit */
+    double volume = V;
+    /** Solids fraction of a unit */
+    double solids = phi;
+    /** Density of the solids */
+    double density = rho;
+    /** Value of a unit of gormanium in the concentrate */
+    double conc_price = 100;
+    /** Cost of a unit of waste in the concentrate */
+    double tails_cost = 500;
+    /** Weight of the scenario in the statistics, such as its probability */
+    double weight = 1;
+};
+
+/**
+ * @brief   Robust fitness of a circuit over a set of scenarios. A circuit that does not
+ *          converge in a scenario scores -50000 there, as in Evaluate_Circuit.
+ */
+struct scenario_statistics
+{
+    /** Mean score, weighted by the scenario weights */
+    double mean = 0;
+    /** Standard deviation of the scores about the mean, with the same weights */
+    double std_dev = 0;
+    /** Lowest score */
+    double worst = 0;
+    /** Highest score */
+    double best = 0;
+    /** Mean of the lowest scores that make up the tail fraction of the weight */
+    double tail_mean = 0;
+    /** Number of scenarios in which the circuit did not converge */
+    int failures = 0;
+};
+
+/**
+* @brief    Population of N unit circuits evaluated together. batch_lanes circuits are swept in
+*           lockstep with their flows stored as structure of arrays across the lanes. As soon
+*           as a lane's circuit converges or runs out of iterations the lane is refilled with
+*           the next circuit, so no lane waits for a slower neighbour. Scores match
+*           CCircuitN<N>::Evaluate_Circuit with the SUBSTITUTION solver. Screen_Circuits
+*           sweeps screen_lanes circuits at a time in single precision, for a rough score.
+*           Evaluate_Scenarios scores every circuit under a set of scenarios instead, with
+*           the lanes holding the scenarios of one circuit.
+*/
+template <int N>
+class CCircuitBatchN
+{
+public:
+
+    // Constructor for a batch from a set of circuit vectors
+    CCircuitBatchN(const std::vector<std::vector<int> > &chromosomes, int initial_conc = 10, \
+                  int initial_tails = 100);
+
+    // Constructor for a batch from count circuit vectors stored back to back in an integer array
+    CCircuitBatchN(const int *chromosomes, int count, int initial_conc = 10, \
+                  int initial_tails = 100);
+
+    // Score every circuit in the batch
+    void Evaluate_Circuits(double *scores, double tolerance = 1e-6, int max_iterations = 1000);
+
+    // Estimate the score of every circuit in the batch in single precision
+    void Screen_Circuits(double *scores, double tolerance = 1e-3, int max_iterations = 1000);
+
+    // Score every circuit in the batch under every scenario
+    void Evaluate_Scenarios(const std::vector<circuit_scenario> &scenarios, double *scores, \
+                            double tolerance = 1e-6, int max_iterations = 1000);
+
+    // Number of circuits in the batch
+    int Size();
+
+private:
+
+    /** Number of circuits */
+    int count;
+
+    /** Initial value of concentrate feed */
+    double initial_conc;
+    /** Initial value of tailings feed */
+    double initial_tails;
+
+    /** Circuit vectors stored back to back */
+    std::vector<int> chromosomes;
+
+    // Sweep the circuits Lanes at a time with feed rates of type Real
+    template <class Real, int Lanes>
+    void evaluate_lanes(double *scores, double tolerance, int max_iterations);
+};
+
+/** Batch of circuits of the default size */
+typedef CCircuitBatchN<num_units> CCircuitBatch;
+
+// Robust fitness of a circuit from its score in every scenario
+scenario_statistics Scenario_Statistics(const double *scores, const std::vector<circuit_scenario> &scenarios, \
+                                        double tail = 0.1);
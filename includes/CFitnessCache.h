@@ -0,0 +1,152 @@
+/**
+ * @file    CFitnessCache.h
+ * @author  Galena Group
+ * @brief   Header file for the CFitnessCache class
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "CCircuit.h"
+
+/**
+* @brief    Hash function for the keys of N unit circuits (FNV-1a over the packed genes)
+*/
+template <int N>
+struct circuit_key_hash
+{
+    std::size_t operator()(const circuit_key<N> &key) const;
+};
+
+/** Hash function for keys of the default circuit size */
+typedef circuit_key_hash<num_units> chromosome_key_hash;
+
+/**
+* @brief    What the fitness cache stores for one circuit
+*/
+template <int N>
+struct fitness_entry
+{
+    /** Fitness value */
+    double score;
+    /** True if flows holds the steady state of the circuit */
+    bool has_flows = false;
+    /** True if score is a single-precision estimate from screening, not an exact evaluation */
+    bool screened = false;
+    /** Feed rates of the units at the steady state, laid out as CCircuitN<N>::Get_Flows writes them.
+        Single precision is plenty for a starting guess. */
+    std::array<float, 2 * N> flows;
+};
+
+/**
+* @brief    Bounded fitness cache keyed by the chromosome of an N unit circuit. When full,
+*           the least recently used entry is evicted. Entries live in one array of slots,
+*           chained into hash buckets and into a list ordered by use, so once the cache is
+*           full an insert reuses the evicted slot and never allocates.
+*/
+template <int N>
+class CFitnessCacheN
+{
+public:
+
+    // Constructor for a cache holding at most capacity entries
+    CFitnessCacheN(std::size_t capacity = 50000);
+
+    // Look up the fitness value stored under a key
+    bool Find(const circuit_key<N> &key, double &score);
+
+    // Look up the fitness value of a chromosome
+    bool Find(const int *chromosome, double &score);
+
+    // Store the fitness value under a key
+    void Insert(const circuit_key<N> &key, double score);
+
+    // Store the fitness value of a chromosome
+    void Insert(const int *chromosome, double score);
+
+    // Store the fitness value and steady-state feed rates under a key
+    void Insert(const circuit_key<N> &key, double score, const double *flows);
+
+    // Store a score estimated by screening, to be replaced by an exact one when it matters
+    void Insert_Screened(const circuit_key<N> &key, double score);
+
+    // Check whether an exact score is stored under a key
+    bool Exact(const circuit_key<N> &key) const;
+
+    // Steady-state feed rates stored under a key
+    bool Find_Flows(const circuit_key<N> &key, double *flows);
+
+    // Remove every entry and reset the counters
+    void Clear();
+
+    // Copy out every entry, least recently used first
+    void Get_Entries(std::vector<circuit_key<N> > &keys, std::vector<fitness_entry<N> > &entries) const;
+
+    // Store an entry as Get_Entries copied it out, as the most recently used
+    void Insert_Entry(const circuit_key<N> &key, const fitness_entry<N> &entry);
+
+    // Pack a chromosome into a cache key
+    static circuit_key<N> Make_Key(const int *chromosome);
+
+    /** Number of lookups that found a stored value */
+    unsigned long hits = 0;
+    /** Number of lookups that did not find a stored value */
+    unsigned long misses = 0;
+    /** Number of entries dropped to stay within capacity */
+    unsigned long evictions = 0;
+
+    // Number of entries currently stored
+    std::size_t Size() const;
+
+private:
+
+    /**
+    * @brief    A stored entry, linked into the list ordered by use and into the chain of its bucket
+    */
+    struct slot
+    {
+        /** Key of the entry */
+        circuit_key<N> key;
+        /** What is stored under the key */
+        fitness_entry<N> entry;
+        /** Next more recently used slot, -1 for the most recently used */
+        int newer;
+        /** Next less recently used slot, -1 for the least recently used */
+        int older;
+        /** Next slot in the same bucket, -1 for the last */
+        int chain;
+    };
+
+    /** Maximum number of entries */
+    std::size_t capacity;
+
+    /** Every entry, growing to capacity slots */
+    std::vector<slot> slots;
+
+    /** First slot of every bucket, -1 if empty. The number of buckets is a power of two. */
+    std::vector<int> buckets;
+
+    /** Most recently used slot, -1 if empty */
+    int newest = -1;
+    /** Least recently used slot, the next to be evicted, -1 if empty */
+    int oldest = -1;
+
+    // Bucket of a key
+    int bucket(const circuit_key<N> &key) const;
+
+    // Slot holding a key, -1 if not stored
+    int find_slot(const circuit_key<N> &key) const;
+
+    // Take a slot out of the list ordered by use
+    void unlink(int s);
+
+    // Put a slot at the most recently used end of the list
+    void link_newest(int s);
+};
+
+/** Fitness cache for circuits of the default size */
+typedef CFitnessCacheN<num_units> CFitnessCache;
@@ -0,0 +1,142 @@
+/**
+ * @file    CMetrics.h
+ * @author  Galena Group
+ * @brief   Header file for the CMetrics class
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <chrono>
+#include <ostream>
+
+/** Phases of the genetic algorithm that CMetrics times */
+enum Metrics_Phase
+{
+    /** Anything outside the other phases: adding children, bookkeeping between generations */
+    PHASE_OTHER,
+    /** Drawing and repairing the circuits of the initial population */
+    PHASE_INIT,
+    /** Scoring the parents of a generation (step 2) */
+    PHASE_FITNESS,
+    /** Copying the best parent into the children (step 3) */
+    PHASE_ELITE,
+    /** Building the parent selection from the fitness values */
+    PHASE_SELECTION,
+    /** Drawing parents, crossover, mutation and repair of the children (steps 4 to 6) */
+    PHASE_BREEDING,
+    /** Checking candidates and finding their canonical form (step 7) */
+    PHASE_VALIDITY,
+    /** Looking candidates up in the fitness cache and evaluating the rest (step 7) */
+    PHASE_EVALUATION
+};
+
+/** Number of phases */
+const int phase_count = 8;
+
+/**
+* @brief    What became of the candidates drawn or bred, copied from the genetic algorithm
+*/
+struct candidate_metrics
+{
+    /** Candidates looked at */
+    unsigned long drawn = 0;
+    /** Candidates that were invalid and that repair made valid */
+    unsigned long repaired = 0;
+    /** Candidates still invalid */
+    unsigned long invalid = 0;
+    /** Valid candidates turned away for their score or as duplicates */
+    unsigned long rejected = 0;
+    /** Candidates that joined the population */
+    unsigned long accepted = 0;
+};
+
+/**
+* @brief    Phase timers and counters of a run of the genetic algorithm. The run is always in
+*           exactly one phase, and Enter charges the wall time since the last switch to the
+*           phase it leaves, so the phase times add up to the time since Start. The genetic
+*           algorithm only keeps metrics when Metrics is defined in Genetic_Algorithm.h.
+*/
+class CMetrics
+{
+public:
+
+    // Constructor for metrics with every counter 0
+    CMetrics();
+
+    // Reset every counter and start timing in PHASE_OTHER
+    void Start();
+
+    // Charge the time since the last switch to the current phase and switch to phase
+    Metrics_Phase Enter(Metrics_Phase phase);
+
+    // Count one evaluation of a circuit; safe to call from several threads
+    void Count_Evaluation(int sweeps, bool converged, int clamps, bool aborted);
+
+    // Start timing a generation
+    void Begin_Generation();
+
+    // Count a generation and its wall time
+    void End_Generation();
+
+    // Add the counters and times of another run, as for the islands of the island model
+    void Add(const CMetrics &other);
+
+    // Stop timing
+    void Stop();
+
+    // Seconds spent in a phase so far
+    double Seconds(Metrics_Phase phase) const;
+
+    // Seconds spent in all phases so far
+    double Elapsed() const;
+
+    // Write the metrics as a JSON object
+    void Write_JSON(std::ostream &out) const;
+
+    // Write the metrics as CSV, one metric per row
+    void Write_CSV(std::ostream &out) const;
+
+    // Write the metrics to a file, as CSV if its name ends in .csv and as JSON otherwise
+    bool Write(const char *path) const;
+
+    /** Circuits evaluated */
+    unsigned long evaluations = 0;
+    /** Sweeps or Newton steps of those evaluations */
+    unsigned long sweeps = 0;
+    /** Evaluations that did not converge and scored -50000 */
+    unsigned long failures = 0;
+    /** Times a unit with almost no feed had its feed rates reset to 1e-7 */
+    unsigned long clamps = 0;
+    /** Evaluations stopped once the score could not beat the threshold */
+    unsigned long aborted = 0;
+
+    /** Generations done */
+    unsigned long generations = 0;
+    /** Wall time of all generations, in seconds */
+    double generation_seconds = 0;
+    /** Wall time of the fastest generation, in seconds */
+    double fastest_generation = 0;
+    /** Wall time of the slowest generation, in seconds */
+    double slowest_generation = 0;
+
+    /** Candidates of the initial population */
+    candidate_metrics initial;
+    /** Children bred */
+    candidate_metrics children;
+
+private:
+
+    /** Phase the run is in */
+    Metrics_Phase current = PHASE_OTHER;
+    /** Seconds charged to each phase */
+    double seconds[phase_count];
+    /** True between Start and the end of the run; a phase is only being timed while running */
+    bool running = false;
+    /** When the run last switched phase */
+    std::chrono::steady_clock::time_point switched;
+    /** When the generation being timed began */
+    std::chrono::steady_clock::time_point generation_began;
+};
@@ -0,0 +1,69 @@
+/**
+ * @file    CPopulation.h
+ * @author  Galena Group
+ * @brief   Header file for the CPopulation class
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "CCircuit.h"
+
+/**
+* @brief    Set of chromosomes of N unit circuits stored back to back in one buffer, one gene
+*           per byte (genes are 0 to N + 1). Chromosome i is the 2 * N + 1 bytes at
+*           operator[](i), so reading or writing a chromosome never allocates, and
+*           Resize only allocates when the population grows past its largest size so far.
+*/
+template <int N>
+class CPopulationN
+{
+public:
+
+    /** Genes per chromosome */
+    static const int length = 2 * N + 1;
+
+    // Constructor for a population of size chromosomes, all genes 0
+    CPopulationN(int size = 0);
+
+    // Number of chromosomes
+    int Size() const;
+
+    // Change the number of chromosomes, keeping the first ones
+    void Resize(int size);
+
+    // Packed genes of chromosome i
+    unsigned char *operator[](int i);
+
+    // Packed genes of chromosome i
+    const unsigned char *operator[](int i) const;
+
+    // Unpack chromosome i into a circuit vector
+    void Get(int i, int *chromosome) const;
+
+    // Overwrite chromosome i with a circuit vector
+    void Set(int i, const int *chromosome);
+
+    // Overwrite chromosome i with packed genes
+    void Set(int i, const unsigned char *chromosome);
+
+    // Exchange the chromosomes of two populations without copying them
+    void Swap(CPopulationN<N> &other);
+
+    // Bytes of chromosome storage
+    std::size_t Bytes() const;
+
+private:
+
+    /** Number of chromosomes */
+    int size;
+    /** Genes of every chromosome, length bytes per chromosome */
+    std::vector<unsigned char> genes;
+};
+
+/** Population of circuits of the default size */
+typedef CPopulationN<num_units> CPopulation;
@@ -0,0 +1,41 @@
+/**
+ * @file    CRandom.h
+ * @author  Galena Group
+ * @brief   Header file for the CRandom class
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <cstdint>
+
+/**
+* @brief    Counter-based random number stream. The n-th number drawn is a pure function of
+*           (seed, generation, slot, n), so every slot of every generation has its own stream
+*           and the numbers a slot sees do not depend on which thread runs it or when.
+*/
+class CRandom
+{
+public:
+
+    // Constructor for the stream of one slot in one generation
+    CRandom(std::uint64_t seed, std::uint64_t generation = 0, std::uint64_t slot = 0);
+
+    // Next 64 random bits
+    std::uint64_t Next();
+
+    // Random integer in [0, n)
+    int Uniform_Int(int n);
+
+    // Random double in [0, 1)
+    double Uniform();
+
+private:
+
+    /** Key mixed from the seed, generation and slot */
+    std::uint64_t key;
+    /** Number of values drawn so far */
+    std::uint64_t counter = 0;
+};
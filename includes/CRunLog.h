@@ -0,0 +1,191 @@
+/**
+ * @file    CRunLog.h
+ * @author  Galena Group
+ * @brief   Header file for the CRunLog and CRunLogReader classes
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CCircuit.h"
+
+/** Version of the run log format */
+const std::uint32_t run_log_version = 1;
+
+/** Records the ring buffer of a CRunLog holds by default */
+const int run_log_capacity = 4096;
+
+/**
+* @brief    Start of a run log file. The file is this header followed by one record of
+*           record_size bytes per generation, in order, all in the byte order of the machine
+*           that wrote it. A record is the fields of run_log_record up to genes, then the
+*           2 * unit_count + 1 genes, then zeros up to a multiple of 8 bytes.
+*/
+struct run_log_header
+{
+    /** "GARUNLOG" */
+    char magic[8];
+    /** run_log_version */
+    std::uint32_t version;
+    /** Bytes per record, Run_Log_Record_Size(unit_count) */
+    std::uint32_t record_size;
+    /** Units in the logged circuits */
+    std::uint32_t unit_count;
+    /** Always 0 */
+    std::uint32_t reserved;
+    /** Seed of the run */
+    std::uint64_t seed;
+};
+
+/**
+* @brief    What a run log keeps of one generation
+*/
+struct run_log_record
+{
+    /** Generation, from 1 */
+    std::int32_t generation;
+    /** Generations since the best circuit last improved */
+    std::int32_t stalled;
+    /** Score of the best circuit so far */
+    double best_score;
+    /** Seconds since the initial population was drawn */
+    double elapsed;
+    /** Genes of the best circuit, one per byte; those past 2 * unit_count + 1 are 0 */
+    unsigned char genes[2 * max_units + 1];
+};
+
+static_assert(sizeof(run_log_header) == 32, "run log header is not packed");
+static_assert(offsetof(run_log_record, genes) == 24, "run log record is not packed");
+
+// Bytes per record of a log of circuits of unit_count units
+int Run_Log_Record_Size(int unit_count);
+
+/**
+* @brief    Writes a run log. Append copies a record into a ring buffer and returns; a writer
+*           thread drains the buffer to the file in blocks, so the generation loop never
+*           waits on the disk unless the buffer is full.
+*/
+class CRunLog
+{
+public:
+
+    // Constructor for a log that is not open, buffering up to capacity records once opened
+    CRunLog(int capacity = run_log_capacity);
+
+    // Destructor, closing the log
+    ~CRunLog();
+
+    CRunLog(const CRunLog &) = delete;
+    CRunLog &operator=(const CRunLog &) = delete;
+
+    // Create the file, write the header and start the writer thread
+    bool Open(const char *path, int unit_count, unsigned long seed, int keep = 0);
+
+    // Queue the record of a generation
+    void Append(int generation, double best_score, double elapsed, int stalled, const unsigned char *genes);
+
+    // Write every queued record, stop the writer thread and close the file
+    bool Close();
+
+    // True between a successful Open and Close
+    bool Is_Open() const;
+
+    // Number of records appended since Open
+    long Size() const;
+
+private:
+
+    /** File being written, NULL if the log is not open */
+    std::FILE *file = NULL;
+    /** Units in the logged circuits */
+    int unit_count = 0;
+    /** Bytes per record */
+    int record_size = 0;
+    /** Records the ring holds */
+    long capacity;
+    /** Queued records as they are written to the file, used as a ring of capacity records */
+    std::vector<unsigned char> ring;
+    /** Number of records appended since Open; the next goes to slot appended % capacity */
+    long appended = 0;
+    /** Number of records written to the file */
+    long written = 0;
+    /** True once Close asks the writer to finish */
+    bool closing = false;
+    /** True if a write to the file failed */
+    bool failed = false;
+
+    /** Guards appended, written, closing and failed */
+    std::mutex lock;
+    /** Signalled when a record is queued or the log closes */
+    std::condition_variable queued;
+    /** Signalled when records have been written */
+    std::condition_variable drained;
+    /** Drains the ring to the file */
+    std::thread writer;
+
+    // Body of the writer thread
+    void write_records();
+};
+
+/**
+* @brief    Reads a run log by mapping the file into memory, so a record of any generation is
+*           read in constant time without reading the ones before it. Records are copied out
+*           of the file, as the genes of a record end where the next record starts.
+*/
+class CRunLogReader
+{
+public:
+
+    // Constructor for a reader with no log open
+    CRunLogReader();
+
+    // Destructor, closing the log
+    ~CRunLogReader();
+
+    CRunLogReader(const CRunLogReader &) = delete;
+    CRunLogReader &operator=(const CRunLogReader &) = delete;
+
+    // Map a log and check its header
+    bool Open(const char *path);
+
+    // Unmap the log
+    void Close();
+
+    // Number of complete records
+    long Size() const;
+
+    // Header of the log
+    const run_log_header &Header() const;
+
+    // Record i, the record of generation i + 1
+    run_log_record operator[](long i) const;
+
+    // Generation of record i
+    int Generation(long i) const;
+
+    // Number of the record of a generation, -1 if the log does not hold it
+    long Find(int generation) const;
+
+    // Unpack the genes of record i into a circuit vector
+    void Get_Genes(long i, int *chromosome) const;
+
+private:
+
+    /** Start of the mapped file, NULL if no log is open */
+    const unsigned char *data = NULL;
+    /** Bytes mapped */
+    std::size_t bytes = 0;
+    /** Bytes per record */
+    std::size_t record_size = 0;
+    /** Number of complete records */
+    long size = 0;
+};
@@ -0,0 +1,61 @@
+/**
+ * @file    CSelection.h
+ * @author  Galena Group
+ * @brief   Header file for the CSelection class
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <vector>
+#include "CRandom.h"
+
+/** How CSelection picks a parent */
+enum Selection_Mode
+{
+    /** Probability proportional to the fitness value, shifted so the worst parent has weight 0
+        when any fitness value is not positive */
+    ROULETTE,
+    /** The fittest of tournament_size parents drawn uniformly, with replacement */
+    TOURNAMENT,
+    /** Probability proportional to the rank, 1 for the worst parent and n for the best */
+    RANK
+};
+
+/**
+* @brief    Parent selection for one generation. Build() does the O(n) or O(n log n) work once
+*           per generation, after which every Select() is O(log n) (O(tournament_size) for
+*           TOURNAMENT) and does not modify the object, so threads may share it.
+*/
+class CSelection
+{
+public:
+
+    // Constructor for a selection engine
+    CSelection(Selection_Mode mode = ROULETTE, int tournament_size = 2);
+
+    // Prepare the selection for the fitness values of one generation
+    void Build(const std::vector<double> &score);
+
+    // Index of a selected parent
+    int Select(CRandom *rng) const;
+
+    // Number of parents of the last Build
+    int Size() const;
+
+private:
+
+    /** Selection mode */
+    Selection_Mode mode;
+    /** Parents drawn per tournament */
+    int tournament_size;
+
+    /** Fitness values of the last Build, for TOURNAMENT */
+    std::vector<double> score;
+    /** Running sum of the weights, for ROULETTE and RANK */
+    std::vector<double> prefix_sum;
+    /** Parent of every prefix sum entry: the identity for ROULETTE, worst to best for RANK */
+    std::vector<int> order;
+};
@@ -0,0 +1,107 @@
+/**
+ * @file    CSparseCircuit.h
+ * @author  Galena Group
+ * @brief   Header file for the CSparseCircuit class
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CRandom.h"
+
+/**
+* @brief    Circuit of any number of units, from a few to tens of thousands, for flowsheets too
+*           large for CCircuitN. The circuit vector has the same layout as for CCircuitN: the
+*           feed unit, then the concentrate and tailings destination of every unit, with
+*           unit_num and unit_num + 1 for the outlets, held as Index. The links are also kept
+*           as compressed sparse rows of the streams feeding every unit, so a unit gathers its
+*           feed without looking at the rest of the circuit. Evaluate_Circuit sweeps the units
+*           Gauss-Seidel in depth-first order from the feed, which settles a feed-forward
+*           circuit in one sweep. A 16-bit Index holds circuits of up to 32767 units.
+*/
+template <class Index>
+class CSparseCircuitT
+{
+public:
+
+    // Constructor for an empty circuit, to be filled by Assign
+    CSparseCircuitT(int initial_conc = 10, int initial_tails = 100);
+
+    // Constructor for a circuit from a circuit vector
+    CSparseCircuitT(const std::vector<Index> &chromosome, int initial_conc = 10, int initial_tails = 100);
+
+    // Largest number of units the Index can describe
+    static int Max_Units();
+
+    // Replace the circuit with the one of a circuit vector
+    bool Assign(const Index *chromosome, std::size_t size);
+
+    // Number of units
+    int Units() const;
+
+    // Check validity of circuit
+    bool Check_Validity() const;
+
+    // Score a circuit based on its performance
+    double Evaluate_Circuit(double tolerance = 1e-8, int max_iterations = 1000);
+
+    // Number of sweeps used by the last Evaluate_Circuit call
+    int Last_Iterations() const;
+
+    // Bytes held by the circuit
+    std::size_t Bytes() const;
+
+private:
+
+    /** Number of units */
+    int unit_num = 0;
+    /** Feed unit number */
+    Index start = 0;
+
+    /** Initial value of concentrate feed */
+    double initial_conc;
+    /** Initial value of tailings feed */
+    double initial_tails;
+
+    /** Concentrate and tailings destination of every unit, 2 * unit_num values */
+    std::vector<Index> links;
+    /** Where the feeding streams of every unit start in feeders, unit_num + 1 values */
+    std::vector<std::uint32_t> feeder_offsets;
+    /** Streams feeding every unit: 2 * unit for the concentrate of unit, 2 * unit + 1 for its tailings */
+    std::vector<Index> feeders;
+    /** Units in the order they are swept */
+    std::vector<Index> order;
+
+    /** Concentrate and tailings feed rate of every unit, 2 * unit_num values */
+    std::vector<double> feed;
+    /** Concentrate and tailings rate of every stream, 4 * unit_num values laid out by stream number */
+    std::vector<double> streams;
+
+    /** Sweeps used by the last evaluation */
+    int iterations = 0;
+
+    // Build the feeding streams and the sweep order from the links
+    void build_rows();
+};
+
+/** Circuit of up to 32767 units with 16-bit indices */
+typedef CSparseCircuitT<std::uint16_t> CSparseCircuit16;
+/** Circuit with 32-bit indices */
+typedef CSparseCircuitT<std::uint32_t> CSparseCircuit;
+
+// Overwrite a circuit vector with a random circuit that is valid by construction
+template <class Index>
+void Sparse_Random_Circuit(std::vector<Index> &chromosome, int unit_num, CRandom *rng, double recycle = 0.1);
+
+// Change one gene of a circuit vector to another value its position allows
+template <class Index>
+int Sparse_Mutate(std::vector<Index> &chromosome, CRandom *rng);
+
+// Swap the genes of two circuit vectors from the start up to a random point
+template <class Index>
+int Sparse_Crossover(std::vector<Index> &father, std::vector<Index> &mother, CRandom *rng);
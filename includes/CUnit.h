@@ -28,12 +28,10 @@ const double V = 10;
 class CUnit
 {
 public:
-  /** index of the unit to which this unit’s concentrate stream is connected */
-  int conc_num;
-  /** index of the unit to which this unit’s tailings stream is connected */
-  int tails_num;
-  /** A Boolean that is changed to true if the unit has been seen */
-  bool mark = false;
+  /** index of the unit to which this unit’s concentrate stream is connected, -1 until linked */
+  int conc_num = -1;
+  /** index of the unit to which this unit’s tailings stream is connected, -1 until linked */
+  int tails_num = -1;
 
   /** the mass flow rate of solid (gormanium) */
   double flow_conc = 0;
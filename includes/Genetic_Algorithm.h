@@ -12,22 +12,211 @@
 #ifndef Genetic
 #define Genetic
 
+#include <string>
+#include <vector>
+#include "CMetrics.h"
+
 // Relevent Parameters for Genetic_Algorithm function
 #define NUM_PARENT 150
-#define NUM_UNIT 10
-#define TOLERANCE 0.001
-#define MAX_ITERATIONS 500
+#define NUM_UNIT 10         // Units in the circuits Genetic_Algorithm() designs, min_units to max_units (CCircuit.h)
+#define TOLERANCE 1e-6       // Error tolerance of the steady-state solver
+#define MAX_ITERATIONS 1000  // Most sweeps or Newton steps of the steady-state solver
 #define NUM_CHILDREN 100
 #define CROSSOVER_PRO 0.95
 #define MUTATE_PRO 0.01
 #define MAX_EVOLUTIONS 3000
+#define STALL_GENERATIONS 0 // Stop after this many generations without a better best circuit, 0 to never stop for it
+#define MIN_DIVERSITY 0     // Stop once fewer than this fraction of the parents are distinct circuits, 0 to never stop for it
+#define TIME_BUDGET 0       // Stop after this many seconds of evolution, 0 for no limit
+#define TARGET_SCORE 0      // Stop once the best circuit scores at least this, 0 for no target
+#define CACHE_SIZE 50000    // Maximum number of chromosomes in the fitness cache
+#define SOLVER SUBSTITUTION // Steady-state solver, SUBSTITUTION, NEWTON or COMPONENTS (see CCircuit.h)
+#define SELECTION ROULETTE  // Parent selection, ROULETTE, TOURNAMENT or RANK (see CSelection.h)
+#define TOURNAMENT_SIZE 2   // Parents drawn per tournament when SELECTION is TOURNAMENT
+#define MAX_DUPLICATES 1000 // Relabelled clones rejected per generation before they are let through
+#define BATCH_SIZE 64       // Unseen circuits simulated together when Batch_Evaluation is defined
+#define SEED_CANDIDATES 1024 // Random circuits drawn per round while creating the initial population
+#define SEED_ROUNDS 64      // Rounds without a new parent after which any circuit with a positive score may join the initial population
+#define NUM_ISLANDS 4       // Islands of the island model, each evolving NUM_PARENT/NUM_CHILDREN on its own thread
+#define MIGRATION_INTERVAL 50 // Generations between exchanges of migrants
+#define NUM_MIGRANTS 5      // Best parents each island sends to each neighbour
+#define MIGRATION_TOPOLOGY RING // RING or ALL_TO_ALL
+#define STEADY_STATE_CHILDREN 8 // Children the steady-state engine breeds and evaluates together before replacing
+#define SCREEN_TOLERANCE 1e-4 // Error tolerance of the single-precision pass when Screening is defined
+#define SCREEN_TOP 2        // Best screened circuits of every round evaluated again in double precision
+#define SCREEN_MARGIN 1     // Screened circuits scoring within this of the acceptance threshold are evaluated again
+#define SCREEN_AUDIT 16     // One in this many other screened circuits is evaluated again to count changed decisions
+#define PRINT_INTERVAL 100  // Generations between progress lines on the console, 0 for none
+#define RUN_LOG_FILE "data.bin" // Where Print logs the best circuit of every generation (see CRunLog.h)
+#define METRICS_FILE "metrics.json" // Where Metrics writes its timers and counters after a run, CSV if it ends in .csv
+#define CHECKPOINT_FILE "checkpoint.bin" // Where a run writes its checkpoints (see CCheckpoint.h)
+#define CHECKPOINT_INTERVAL 0 // Generations between checkpoints, 0 for none
 
 // Compile switch, If you want to using the function, delete '//'
-//#define Parallel  // If defined, using OpenMP for parallelization
+#define Parallel    // If defined and built with OpenMP, evaluate and breed on every core
 //#define DO_TIMING // Doing Timing
-//#define Print     // Doing Printing
+//#define Print     // Log the best circuit of every generation to RUN_LOG_FILE
+//#define Deduplicate // Keep relabelled copies of the same circuit out of the population
+//#define Batch_Evaluation // Simulate unseen circuits with the lockstep batch evaluator (substitution solver)
+//#define Islands   // Genetic_Algorithm() runs the island model with the parameters above
+//#define Steady_State // Genetic_Algorithm() runs the steady-state engine, replacing the worst members in place
+//#define Screening // Score unseen circuits in single precision, evaluating the best and the close calls again in double
+//#define Metrics   // Time the phases of a run and count solver work, written to METRICS_FILE (see CMetrics.h)
+//#define Estimate_Threshold // Also stop evaluations once the score is estimated, not certain, not to beat the threshold
+#define Warm_Start  // Start evaluating a child from the steady state of the parent it takes most genes from
+#define Repair      // Draw initial circuits valid by construction and repair invalid children instead of discarding them
+
+/** Which islands receive the migrants of an island */
+enum Migration_Topology
+{
+    /** The next island, the last sending to the first */
+    RING,
+    /** Every other island */
+    ALL_TO_ALL
+};
+
+/**
+* @brief    Parameters of a run of the genetic algorithm, so that runs with other parameters
+*           need no rebuild. The defaults are the parameters above. How long a run lasts,
+*           MAX_EVOLUTIONS included, is set by stopping_criteria.
+*/
+struct ga_config
+{
+    /** Circuits in the initial population */
+    int parents = NUM_PARENT;
+    /** Children of every generation, the best parent among them; the parents of the next */
+    int children = NUM_CHILDREN;
+    /** Probability that a pair of parents is crossed */
+    double crossover_probability = CROSSOVER_PRO;
+    /** Probability that a child is mutated */
+    double mutate_probability = MUTATE_PRO;
+    /** Error tolerance of the steady-state solver */
+    double tolerance = TOLERANCE;
+    /** Most sweeps or Newton steps of the steady-state solver */
+    int max_iterations = MAX_ITERATIONS;
+    /** Generations between progress lines on the console, 0 for none */
+    int print_interval = PRINT_INTERVAL;
+};
+
+/** Why a run of the genetic algorithm stopped */
+enum Stop_Reason
+{
+    /** Still running */
+    RUNNING,
+    /** All max_generations generations ran */
+    MAX_GENERATIONS,
+    /** The best circuit did not improve for stall_generations generations */
+    STALLED,
+    /** Too few of the parents were distinct circuits */
+    LOW_DIVERSITY,
+    /** The time budget ran out */
+    OUT_OF_TIME,
+    /** The best circuit reached the target score */
+    TARGET_REACHED,
+    /** The progress callback asked to stop */
+    CALLBACK_STOP
+};
+
+/**
+* @brief    When a run of the genetic algorithm stops. It stops at the first criterion met;
+*           a criterion of 0 is never met. The defaults are the parameters above.
+*/
+struct stopping_criteria
+{
+    /** Most generations to run */
+    int max_generations = MAX_EVOLUTIONS;
+    /** Generations without a better best circuit after which to stop */
+    int stall_generations = STALL_GENERATIONS;
+    /** Fraction of distinct circuits among the parents below which to stop */
+    double min_diversity = MIN_DIVERSITY;
+    /** Seconds of evolution after which to stop */
+    double time_budget = TIME_BUDGET;
+    /** Score of the best circuit at which to stop */
+    double target_score = TARGET_SCORE;
+};
+
+/**
+* @brief    Where and how often a run saves its state so that Resume_Genetic_Algorithm can
+*           carry it on. A checkpoint is also written when the run stops.
+*/
+struct checkpoint_settings
+{
+    /** File the checkpoints are written to, each replacing the last */
+    std::string file = CHECKPOINT_FILE;
+    /** Generations between checkpoints, 0 for none */
+    int interval = CHECKPOINT_INTERVAL;
+};
+
+/**
+* @brief    State of a run after a generation, as passed to a progress callback
+*/
+struct ga_progress
+{
+    /** Generations done */
+    int generation = 0;
+    /** Score of the best circuit so far */
+    double best_score = 0;
+    /** Circuit vector of the best circuit so far, 2 * unit count + 1 genes */
+    std::vector<int> best_circuit;
+    /** Generations since the best circuit last improved */
+    int stalled = 0;
+    /** Fraction of the parents of the generation that are distinct circuits, relabellings counted once */
+    double diversity = 1;
+    /** Seconds since the initial population was drawn */
+    double elapsed = 0;
+    /** Circuits simulated so far, the initial population included; cache hits are not counted */
+    unsigned long evaluations = 0;
+    /** Why the run stops after this generation, RUNNING if it goes on */
+    Stop_Reason stop = RUNNING;
+    /** Timers and counters of the run so far when Metrics is defined, NULL otherwise */
+    const CMetrics *metrics = NULL;
+};
 
-// Produce child vectors from a list of parent vectors
+/** Called after every generation with the state of the run and the user data given to the run;
+    returning false stops the run */
+typedef bool (*progress_callback)(const ga_progress &progress, void *user_data);
+
+// Produce child vectors from a list of parent vectors, seeded from the clock
 double Genetic_Algorithm(void);
 
+// Produce child vectors from a list of parent vectors; a seed gives the same result on any number of threads
+double Genetic_Algorithm(unsigned long seed);
+
+// Produce child vectors from a list of parent vectors for circuits of unit_num units
+double Genetic_Algorithm(unsigned long seed, int unit_num);
+
+// Produce child vectors until a stopping criterion is met, reporting progress after every generation
+double Genetic_Algorithm(unsigned long seed, int unit_num, const stopping_criteria &stopping, \
+                         progress_callback callback = NULL, void *user_data = NULL);
+
+// Produce child vectors until a stopping criterion is met, saving checkpoints as it goes
+double Genetic_Algorithm(unsigned long seed, int unit_num, const stopping_criteria &stopping, \
+                         const checkpoint_settings &checkpoint, progress_callback callback = NULL, \
+                         void *user_data = NULL);
+
+// Produce child vectors with the parameters of config instead of those above
+double Genetic_Algorithm(unsigned long seed, int unit_num, const ga_config &config, \
+                         const stopping_criteria &stopping = stopping_criteria(), \
+                         const checkpoint_settings &checkpoint = checkpoint_settings(), \
+                         progress_callback callback = NULL, void *user_data = NULL);
+
+// Carry on the run that wrote a checkpoint as if it had never stopped
+double Resume_Genetic_Algorithm(const char *path, progress_callback callback = NULL, void *user_data = NULL);
+
+// Island model: independent populations on their own threads exchanging their best parents
+double Island_Genetic_Algorithm(unsigned long seed, int unit_num = NUM_UNIT, int island_num = NUM_ISLANDS, \
+                                int generations = MAX_EVOLUTIONS, int migration_interval = MIGRATION_INTERVAL, \
+                                int migrants = NUM_MIGRANTS, Migration_Topology topology = MIGRATION_TOPOLOGY, \
+                                const ga_config &config = ga_config());
+
+// Steady-state engine: children replace the worst members in place, so only new circuits are evaluated
+double Steady_State_Genetic_Algorithm(unsigned long seed, int unit_num = NUM_UNIT, \
+                                      const stopping_criteria &stopping = stopping_criteria(), \
+                                      progress_callback callback = NULL, void *user_data = NULL);
+
+// Steady-state engine with the parameters of config instead of those above
+double Steady_State_Genetic_Algorithm(unsigned long seed, int unit_num, const ga_config &config, \
+                                      const stopping_criteria &stopping = stopping_criteria(), \
+                                      progress_callback callback = NULL, void *user_data = NULL);
+
 #endif
@@ -0,0 +1,320 @@
+/**
+ * @file      Genetic_Algorithm_internal.h
+ * @author    Galena Group
+ * @brief     Stages of the genetic algorithm and the state they share, for the tests and
+ *            benchmarks that drive a run one step at a time. Not part of the public interface.
+ * @version   0.1
+ * @date      2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+#include <array>
+#include <cmath>
+#include <vector>
+#include "CCircuit.h"
+#include "CFitnessCache.h"
+#include "CMetrics.h"
+#include "CPopulation.h"
+#include "CRandom.h"
+#include "CSelection.h"
+#include "Genetic_Algorithm.h"
+
+/** Circuit vector of an N unit circuit, sized at compile time */
+template <int N>
+using gene_array = std::array<int, 2 * N + 1>;
+
+/**
+ * @brief   A circuit drawn by one slot of a generation and what the fitness cache knows about it
+ */
+template <int N>
+struct ga_candidate
+{
+    /** Circuit vector */
+    gene_array<N> genes;
+    /** False if the circuit failed Check_Validity */
+    bool valid = false;
+    /** True if the circuit was invalid as bred and repair_chromosome made it valid */
+    bool repaired = false;
+    /** Fitness value, set if valid */
+    double score = 0;
+    /** Canonical key, set if valid */
+    circuit_key<N> key;
+    /** Parent whose steady state starts the evaluation, -1 for none */
+    int parent = -1;
+    /** Unit of genes that became each canonical unit, set if valid */
+    std::array<int, N> order;
+    /** Steady-state feed rates of the canonical circuit, set if evaluated here and converged */
+    std::array<double, 2 * N> flows;
+    /** True if flows is set */
+    bool has_flows = false;
+    /** True if the evaluation stopped once the score could not beat the threshold */
+    bool aborted = false;
+    /** Sweeps that stopping early is projected to have skipped, if aborted */
+    int saved_sweeps = 0;
+    /** True if score is a single-precision estimate from screening */
+    bool screened = false;
+};
+
+/**
+ * @brief   Steady states of the parents of a generation, used to warm start their children,
+ *          and how many sweeps the evaluations took
+ */
+template <int N>
+struct ga_warm_start
+{
+    /** Feed rates of every parent in its own unit numbering, 2 * N per parent */
+    std::vector<double> flows;
+    /** True for the parents whose steady state is known */
+    std::vector<char> known;
+    /** Circuits evaluated from the circuit feed */
+    unsigned long cold_evaluations = 0;
+    /** Sweeps or Newton steps of those evaluations */
+    unsigned long cold_sweeps = 0;
+    /** Circuits evaluated from the steady state of a parent */
+    unsigned long warm_evaluations = 0;
+    /** Sweeps or Newton steps of those evaluations */
+    unsigned long warm_sweeps = 0;
+};
+
+/**
+ * @brief   What became of the candidates a population looked at, to show how much of the
+ *          drawing and breeding is wasted
+ */
+struct ga_acceptance
+{
+    /** Candidates looked at */
+    unsigned long drawn = 0;
+    /** Candidates that were invalid as drawn or bred and that repair made valid */
+    unsigned long repaired = 0;
+    /** Candidates still invalid */
+    unsigned long invalid = 0;
+    /** Valid candidates turned away for their score or as duplicates */
+    unsigned long rejected = 0;
+    /** Candidates that joined the population */
+    unsigned long accepted = 0;
+    /** Evaluations stopped once the score could not beat the threshold */
+    unsigned long aborted = 0;
+    /** Sweeps those evaluations are projected to have skipped */
+    unsigned long saved_sweeps = 0;
+
+    /**
+     * @brief   Count one candidate
+     *
+     * @param   candidate               Candidate after evaluate_candidates
+     * @param   candidate_accepted      True if the candidate joined the population
+     */
+    template <int N>
+    void Count(const ga_candidate<N> &candidate, bool candidate_accepted)
+    {
+        drawn++;
+        repaired += candidate.repaired;
+        invalid += !candidate.valid;
+        rejected += candidate.valid && !candidate_accepted;
+        accepted += candidate_accepted;
+        aborted += candidate.aborted;
+        saved_sweeps += candidate.saved_sweeps;
+    }
+
+    /**
+     * @brief   Add the counts of another population
+     *
+     * @param   other       Counts to add
+     */
+    void Add(const ga_acceptance &other)
+    {
+        drawn += other.drawn;
+        repaired += other.repaired;
+        invalid += other.invalid;
+        rejected += other.rejected;
+        accepted += other.accepted;
+        aborted += other.aborted;
+        saved_sweeps += other.saved_sweeps;
+    }
+};
+
+/**
+ * @brief   What screening left to its single-precision scores and how often evaluating a
+ *          circuit again in double precision changed a decision
+ */
+struct ga_screening
+{
+    /** Circuits scored in single precision */
+    unsigned long screened = 0;
+    /** Of those, circuits among the best of their round or close to the threshold, evaluated again */
+    unsigned long refined = 0;
+    /** Refined circuits that double precision put on the other side of the threshold */
+    unsigned long refined_flips = 0;
+    /** Of the rest, circuits evaluated again as a sample, one in SCREEN_AUDIT */
+    unsigned long audited = 0;
+    /** Audited circuits that double precision put on the other side of the threshold */
+    unsigned long audited_flips = 0;
+    /** Best parents whose screened score was replaced by an exact one */
+    unsigned long elite_refined = 0;
+    /** Generations in which the exact scores changed which parent was the best */
+    unsigned long elite_changes = 0;
+
+    /**
+     * @brief   Add the counts of another population
+     *
+     * @param   other       Counts to add
+     */
+    void Add(const ga_screening &other)
+    {
+        screened += other.screened;
+        refined += other.refined;
+        refined_flips += other.refined_flips;
+        audited += other.audited;
+        audited_flips += other.audited_flips;
+        elite_refined += other.elite_refined;
+        elite_changes += other.elite_changes;
+    }
+};
+
+/**
+ * @brief   Working storage of the rounds of evaluate_candidates, kept from one round and
+ *          one generation to the next so that a round allocates nothing once the vectors
+ *          have reached the size of the largest round, and the solver settings and
+ *          evaluation count of the population
+ */
+struct ga_scratch
+{
+    /** Slots whose circuit is evaluated in this round, in slot order */
+    std::vector<int> misses;
+    /** For every slot, the earlier slot evaluating the same circuit, or -1 */
+    std::vector<int> first;
+    /** Slots that missed the cache, sorted by key to find repeats */
+    std::vector<int> by_key;
+    /** Canonical circuit vectors of the misses, for Batch_Evaluation and Screening */
+    std::vector<int> genes;
+    /** Scores of the misses, for Batch_Evaluation and Screening */
+    std::vector<double> scores;
+    /** Slots of the misses evaluated in double precision after screening, in slot order */
+    std::vector<int> refine;
+    /** Misses screened, best screened score first, for Screening */
+    std::vector<int> ranked;
+    /** Single-precision scores of the misses screened, in the order they were screened */
+    std::vector<double> estimates;
+    /** Scores of the misses refined after screening, for Batch_Evaluation */
+    std::vector<double> refined;
+    /** For every miss, 1 if it is audited after screening, -1 if it was rejected unscreened */
+    std::vector<char> audit;
+    /** What screening decided, for Screening */
+    ga_screening screening;
+    /** Phase timers and counters of the population, NULL to keep none */
+    CMetrics *metrics = NULL;
+    /** Error tolerance of the steady-state solver */
+    double tolerance = TOLERANCE;
+    /** Most sweeps or Newton steps of the steady-state solver */
+    int max_iterations = MAX_ITERATIONS;
+    /** Circuits simulated, cache hits not counted */
+    unsigned long evaluations = 0;
+};
+
+/**
+ * @brief   One population of the genetic algorithm: the whole run, or one island
+ */
+template <int N>
+struct ga_population
+{
+    /** Parents of the current generation */
+    CPopulationN<N> parent_set;
+    /** Fitness value of every parent */
+    std::vector<double> fitness_score;
+    /** Children being bred for the next generation, swapped with parent_set after each generation */
+    CPopulationN<N> child_set;
+    /** Candidates of the current breeding round */
+    std::vector<ga_candidate<N> > candidates;
+    /** Canonical keys of the children chosen so far when deduplicating */
+    std::vector<circuit_key<N> > child_keys;
+    /** Canonical keys of the parents of the last generation */
+    std::vector<circuit_key<N> > parent_keys;
+    /** Working storage of evaluate_candidates */
+    ga_scratch scratch;
+    /** What became of the candidates of the initial population */
+    ga_acceptance initial;
+    /** What became of the children bred */
+    ga_acceptance children;
+    /** Parent selection, built once per generation */
+    CSelection selection;
+    /** Steady states of the parents and the sweeps spent evaluating children */
+    ga_warm_start<N> warm;
+    /** Fitness cache of this population */
+    CFitnessCacheN<N> cache;
+    /** Parameters of the run */
+    ga_config config;
+    #ifdef Metrics
+      /** Phase timers and counters of this population */
+      CMetrics metrics;
+    #endif
+    /** Seed of the random streams of this population */
+    unsigned long seed;
+    /** Highest score of the last generation */
+    double the_max_value = 0;
+    /** Score of the first parent of the last generation, the value returned by a run */
+    double finalsocre = 0;
+
+    ga_population(unsigned long seed, const ga_config &config = ga_config())
+        : selection(SELECTION, TOURNAMENT_SIZE), cache(CACHE_SIZE), config(config), seed(seed)
+    {
+        child_set.Resize(config.children);
+        scratch.tolerance = config.tolerance;
+        scratch.max_iterations = config.max_iterations;
+    }
+};
+
+// Overwrite a circuit vector with random genes, valid or not
+template <int N>
+void random_chromosome(gene_array<N> *temp, CRandom *rng);
+
+// Overwrite a circuit vector with a random tree of units, valid by construction
+template <int N>
+void tree_chromosome(gene_array<N> *temp, CRandom *rng);
+
+// Make an invalid circuit valid by changing as few genes as possible
+template <int N>
+bool repair_chromosome(gene_array<N> &genes, CRandom *rng);
+
+// Overwrite a circuit vector with a random valid circuit
+template <int N>
+bool valid_chromosome(gene_array<N> *temp, CRandom *rng);
+
+// Create the initial population of set_num valid parents
+template <int N>
+void create_chromosome_set(CPopulationN<N> *parent_set, int set_num, CFitnessCacheN<N> *cache, unsigned long seed, \
+                           ga_acceptance *acceptance = NULL, ga_scratch *scratch = NULL);
+
+// Calculate fitness value for parent set
+template <int N>
+void calculate_fitness_value(std::vector<double> *score, const CPopulationN<N> &parent_set, double tolerance, \
+                             int max_iterations, CFitnessCacheN<N> *cache, \
+                             std::vector<circuit_key<N> > *keys = NULL, CMetrics *metrics = NULL, \
+                             unsigned long *evaluations = NULL);
+
+// Select best parent in parent set and put it into child set
+template <int N>
+double best_parent2child(CPopulationN<N> &child_set, const std::vector<double> &score, \
+                         const CPopulationN<N> &parent_set, int children);
+
+// Swap the genes of two parent vectors from the start up to a random point
+template <int N>
+int crossover(gene_array<N> &father, gene_array<N> &mother, CRandom *rng, double probability = CROSSOVER_PRO);
+
+// Change one gene of a vector to a random value
+template <int N>
+void mutate(gene_array<N> &before, CRandom *rng, double probability = MUTATE_PRO);
+
+// Check and score every candidate of a round
+template <int N>
+void evaluate_candidates(std::vector<ga_candidate<N> > &candidates, CFitnessCacheN<N> *cache, \
+                         ga_scratch *scratch, ga_warm_start<N> *warm = NULL, double threshold = -HUGE_VAL);
+
+// Score the parents of a generation, keep the best and breed the rest of the children
+template <int N>
+void evolve_generation(ga_population<N> &population, int k);
+
+#ifdef Metrics
+// Copy the counts of candidates into the metrics
+void copy_acceptance(candidate_metrics &metrics, const ga_acceptance &acceptance);
+#endif
@@ -7,67 +7,45 @@ author: Xufei Gao
 import graphviz
 import matplotlib.pyplot as plt
 from PIL import Image
+from run_log import RunLog
 
 
-# This function aims at finding the number of lines in the given file
-# and return the number
-def number_of_lines(file):
-    """
-    Given a .txt file name, this function aims at finding
-    the number of lines in the given file, and return the
-    number
-
-    Parameters
-    ----------
-    file : a .txt file name in string format
-    """
-    store = open(file, 'r')
-    line = store.readline()
-    line_number = 0
-    while line:
-        line_number += 1
-        line = store.readline()
-    store.close()
-    return line_number
-
-
-# This function aims at slicing data in the target .txt document
+# This function aims at reading the chosen generations from the run log
 # and calling process_line function to process the data to generate diagrams
-# return the number of lines in the given file
+# return the generations plotted
 def plot_figure(file):
     """
-    Given a .txt file name, this function aims at slicing data in the
-    target .txt document by line, and calling process_line function to process
-    the data to generate initial diagrams. At last, return the number of
-    lines in the given file
+    Given a run log file name, this function aims at reading the best
+    circuit of the chosen generations from the log, and calling process_line
+    function to process the data to generate initial diagrams. At last,
+    return the numbers of the records plotted
 
     Parameters
     ----------
-    file : a .txt file name in string format
+    file : a run log file name in string format
     """
-    each_line = []
     slices = [0, 1, 3, 5, 8, 9, 11, 26, 50, 60, 70, 80, 90, 100, 110,
               150, 160, 170, 180, 200, 220, 250, 270, 300, 350, 400, 500, 2999]
-    store = open(file, 'r')
-    count = 0
-    # max_line = number_of_lines(file)
-    for lines in store:
-        if count in slices:
-            ls = lines
-            slices.append(count)
-            for i in ls.split(" "):
-                each_line.append(i)
-            process_line(each_line, count)
-        each_line = []
-        count += 1
-    return slices
+    log = RunLog(file)
+    # records are read straight from the mapped log, so a long run costs
+    # no more to plot than a short one
+    plotted = [count for count in slices if count < len(log)]
+    # end on the best circuit of the run however long it ran
+    if len(log) > 0 and plotted[-1] != len(log) - 1:
+        plotted.append(len(log) - 1)
+    for count in plotted:
+        record = log[count]
+        process_line([str(gene) for gene in record.genes]
+                     + [record.best_score], count)
+    log.close()
+    return plotted
 
 
 # The function takes graphviz to process the data from the plot_figure function
 # and generate corresponding diagrams
 def process_line(line, count):
     """
-    Accept the data in a .txt document line by line from plot_figure function,
+    Accept the genes and score of a generation from plot_figure function,
     and a integer called count, this integer is use to name the each generated
     diagram. As the each time the plot_figure function transfers the count to
     this function, the value of count is different, which is bigger than before
@@ -75,8 +53,8 @@ def process_line(line, count):
 
     Parameters
     ----------
-    line : the data in a line of a .txt document
-    count: a integer which represents the line number
+    line : the genes of the best circuit followed by its score
+    count: a integer which represents the record number
     """
 
     # make a contain to store the processed data
@@ -121,7 +99,7 @@ def process_line(line, count):
                  cleanup=True, format='png')
 
 
-slices = plot_figure("./src/data.txt")
+slices = plot_figure("./src/data.bin")
 
 # process the diagrams generated before into fixed size
 # and flag the order of each diagram
@@ -0,0 +1,102 @@
+"""@package docstring
+File: This module reads the run logs the genetic algorithm writes with Print
+author: Galena Group
+"""
+
+
+import mmap
+import struct
+from collections import namedtuple
+
+
+# magic, version, record_size, unit_count, reserved, seed (see includes/CRunLog.h)
+HEADER = struct.Struct('<8sIIIIQ')
+# generation, stalled, best_score, elapsed; the genes follow
+RECORD = struct.Struct('<iidd')
+MAGIC = b'GARUNLOG'
+VERSION = 1
+
+Record = namedtuple('Record', ['generation', 'stalled', 'best_score',
+                               'elapsed', 'genes'])
+
+
+class RunLog:
+    """
+    A run log mapped into memory. Records are read when they are asked for,
+    so opening a log and reading a few generations of a long run is quick.
+
+    log[i] is record i, the record of generation i + 1, and log.find(g) is
+    the record of generation g.
+    """
+
+    def __init__(self, file):
+        """
+        Map a run log and check its header
+
+        Parameters
+        ----------
+        file : name of a run log, data.bin unless RUN_LOG_FILE was changed
+        """
+        with open(file, 'rb') as store:
+            self.data = mmap.mmap(store.fileno(), 0, access=mmap.ACCESS_READ)
+        if len(self.data) < HEADER.size:
+            raise ValueError(file + ' is not a run log')
+        (magic, version, self.record_size, self.unit_count, _,
+         self.seed) = HEADER.unpack_from(self.data, 0)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError(file + ' is not a run log of version '
+                             + str(VERSION))
+        self.gene_count = 2 * self.unit_count + 1
+        # a record cut short by a run that did not finish is left out
+        self.size = (len(self.data) - HEADER.size) // self.record_size
+
+    def __len__(self):
+        return self.size
+
+    def __getitem__(self, i):
+        """
+        Record i, the record of generation i + 1
+
+        Parameters
+        ----------
+        i : record number, negative numbers counting from the end
+        """
+        if i < 0:
+            i += self.size
+        if i < 0 or i >= self.size:
+            raise IndexError('record ' + str(i) + ' is not in the log')
+        offset = HEADER.size + i * self.record_size
+        fields = RECORD.unpack_from(self.data, offset)
+        start = offset + RECORD.size
+        genes = list(self.data[start:start + self.gene_count])
+        return Record(*fields, genes)
+
+    def generation(self, i):
+        """
+        Generation of record i, without reading the rest of it
+        """
+        return struct.unpack_from('<i', self.data,
+                                  HEADER.size + i * self.record_size)[0]
+
+    def find(self, generation):
+        """
+        Record of a generation, None if the log does not hold it. Records are
+        one per generation from 1 unless the log skips generations, in which
+        case the record is found by bisection.
+        """
+        i = generation - 1
+        if 0 <= i < self.size and self.generation(i) == generation:
+            return self[i]
+        low, high = 0, self.size
+        while low < high:
+            middle = (low + high) // 2
+            if self.generation(middle) < generation:
+                low = middle + 1
+            else:
+                high = middle
+        if low < self.size and self.generation(low) == generation:
+            return self[low]
+        return None
+
+    def close(self):
+        self.data.close()
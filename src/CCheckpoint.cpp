@@ -0,0 +1,250 @@
+/**
+ * @file    CCheckpoint.cpp
+ * @author  Galena Group
+ * @brief   Atomic binary checkpoints of a run of the genetic algorithm
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cstdio>
+#include <cstring>
+#include "../includes/CCheckpoint.h"
+
+#ifdef _WIN32
+  #include <io.h>
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+/** Magic bytes at the start of a checkpoint */
+static const char checkpoint_magic[8] = {'G', 'A', 'C', 'H', 'E', 'C', 'K', 'P'};
+
+/**
+ * @brief   FNV-1a hash of some bytes
+ *
+ * @param   data            Bytes to hash
+ * @param   bytes           Number of bytes
+ * @return  std::uint64_t   Hash value
+ */
+static std::uint64_t state_checksum(const unsigned char *data, std::size_t bytes)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+
+    for (std::size_t i = 0; i < bytes; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief   Flush a file that was written to the disk and close it
+ *
+ * @param   file        File open for writing
+ * @return  bool        true if everything written reached the disk
+ */
+static bool flush_and_close(std::FILE *file)
+{
+    bool ok = std::fflush(file) == 0;
+
+  #ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+  #else
+    ok = ok && fsync(fileno(file)) == 0;
+  #endif
+    return std::fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief   Replace a file by another, in one step that leaves either the old or the new file
+ *
+ * @param   from        File to rename
+ * @param   to          Name to give it
+ * @return  bool        true if renamed
+ */
+static bool replace_file(const char *from, const char *to)
+{
+  #ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+  #else
+    if (std::rename(from, to) != 0)
+        return false;
+
+    // the rename itself only lasts once the directory holding the file is on the disk
+    std::string name(to);
+    std::size_t slash = name.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : name.substr(0, slash);
+    int handle = open(directory.c_str(), O_RDONLY);
+    if (handle >= 0)
+    {
+        fsync(handle);
+        close(handle);
+    }
+    return true;
+  #endif
+}
+
+/**
+ * @brief   Append bytes to the state
+ *
+ * @param   data        Bytes to append
+ * @param   bytes       Number of bytes
+ */
+void CCheckpointWriter::Write(const void *data, std::size_t bytes)
+{
+    const unsigned char *first = (const unsigned char *)data;
+
+    this->state.insert(this->state.end(), first, first + bytes);
+}
+
+/**
+ * @brief   Append a string to the state, its length first
+ *
+ * @param   text        String to append
+ */
+void CCheckpointWriter::Write_String(const std::string &text)
+{
+    this->Write_Value((std::uint64_t)text.size());
+    this->Write(text.data(), text.size());
+}
+
+/**
+ * @brief   Write the state to path with a temporary name, flush it to the disk and rename
+ *          it to path. Until the rename, path still holds the last complete checkpoint.
+ *
+ * @param   path            Checkpoint to write
+ * @param   unit_count      Units in the circuits of the run
+ * @return  bool            true if the checkpoint was written
+ */
+bool CCheckpointWriter::Commit(const char *path, int unit_count) const
+{
+    std::string temporary = std::string(path) + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+
+    if (file == NULL)
+        return false;
+
+    checkpoint_header header;
+    std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+    header.version = checkpoint_version;
+    header.unit_count = unit_count;
+    header.size = this->state.size();
+    header.checksum = state_checksum(this->state.data(), this->state.size());
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(this->state.data(), 1, this->state.size(), file) == this->state.size();
+    ok = flush_and_close(file) && ok;
+    if (ok && replace_file(temporary.c_str(), path))
+        return true;
+
+    std::remove(temporary.c_str());
+    return false;
+}
+
+/**
+ * @brief   Bytes of state collected
+ *
+ * @return  std::size_t     Number of bytes
+ */
+std::size_t CCheckpointWriter::Size() const
+{
+    return this->state.size();
+}
+
+/**
+ * @brief   Read a checkpoint and check its header and checksum. A checkpoint that is
+ *          already open is closed first.
+ *
+ * @param   path        Checkpoint to read
+ * @return  bool        true if the file is a complete checkpoint this version can read
+ */
+bool CCheckpointReader::Open(const char *path)
+{
+    this->state.clear();
+    this->position = 0;
+    this->unit_count = 0;
+
+    std::FILE *file = std::fopen(path, "rb");
+    if (file == NULL)
+        return false;
+
+    checkpoint_header header;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+              std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) == 0 &&
+              header.version == checkpoint_version;
+    if (ok)
+    {
+        this->state.resize(header.size);
+        ok = std::fread(this->state.data(), 1, header.size, file) == header.size &&
+             std::fgetc(file) == EOF && state_checksum(this->state.data(), this->state.size()) == header.checksum;
+    }
+    std::fclose(file);
+
+    if (!ok)
+    {
+        this->state.clear();
+        return false;
+    }
+    this->unit_count = header.unit_count;
+    return true;
+}
+
+/**
+ * @brief   Units in the circuits of the run
+ *
+ * @return  int     Unit count, 0 if no checkpoint is open
+ */
+int CCheckpointReader::Unit_Count() const
+{
+    return this->unit_count;
+}
+
+/**
+ * @brief   Take bytes from the state
+ *
+ * @param   data        Receives the bytes
+ * @param   bytes       Number of bytes
+ * @return  bool        false, with nothing read, if fewer bytes are left
+ */
+bool CCheckpointReader::Read(void *data, std::size_t bytes)
+{
+    if (this->state.size() - this->position < bytes)
+        return false;
+
+    std::memcpy(data, this->state.data() + this->position, bytes);
+    this->position += bytes;
+    return true;
+}
+
+/**
+ * @brief   Take a string written with Write_String from the state
+ *
+ * @param   text        Receives the string
+ * @return  bool        false if the state ran out
+ */
+bool CCheckpointReader::Read_String(std::string &text)
+{
+    std::uint64_t length;
+
+    if (!this->Read_Value(length) || this->state.size() - this->position < length)
+        return false;
+
+    text.assign((const char *)this->state.data() + this->position, length);
+    this->position += length;
+    return true;
+}
+
+/**
+ * @brief   True if every byte of the state has been read
+ *
+ * @return  bool        true at the end of the state
+ */
+bool CCheckpointReader::Done() const
+{
+    return this->position == this->state.size();
+}
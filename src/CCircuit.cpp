@@ -9,165 +9,409 @@
  */
 
 #include <math.h>
+#include <algorithm>
+#include <cmath>
 #include "../includes/CCircuit.h"
 
+/** One bit per unit of a circuit */
+typedef std::uint32_t unit_mask;
+
+static_assert(max_units <= 32, "unit_mask needs a bit for every unit");
+
 /**
- * @brief   Traverse circuit and mark units that have been passed
+ * @brief   Units reachable from a set of units, following the links of one direction
  *
- * @param   unit_num        unit number that is marked
+ * @param   reached     Units to start from
+ * @param   links       For every unit, the units one link away from it
+ * @return  unit_mask   The starting units and every unit reachable from them
  */
-void CCircuit::mark_units(int unit_num)
+static unit_mask reach(unit_mask reached, const unit_mask *links)
 {
-    // exit if the unit has already been to
-    if (this->units[unit_num].mark)
-        return;
+    unit_mask frontier = reached;
 
-    // mark the unit
-    this->units[unit_num].mark = 1;
+    // every unit enters the frontier once, so this takes at most one step per unit
+    while (frontier != 0)
+    {
+        int unit = __builtin_ctz(frontier);
+        unit_mask added = links[unit] & ~reached;
 
-    // concentrate stream and tailing stream this unit is going to
-    int conc_num = this->units[unit_num].conc_num;
-    int tails_num = this->units[unit_num].tails_num;
+        frontier &= frontier - 1;
+        reached |= added;
+        frontier |= added;
+    }
+    return reached;
+}
 
-    // check if this unit is going to the end stream or passing to another unit
-    if (conc_num < num_units)
-        this->mark_units(conc_num);
-    else
-        // return 1 if any unit reaches to concentrate end
-        this->conc_toend = 1;
+/**
+ * @brief   Check validity of the circuit viewed by genes. A circuit is valid if the feed
+ *          goes to a unit, no unit sends a product to itself or both products to the same
+ *          place, concentrate only leaves through the concentrate outlet and tailings
+ *          through the tailings outlet, every unit is reachable from the feed, and every
+ *          unit has a route to both outlets. Circuits that fail the last rule have no
+ *          useful steady state. The links are held as one bitmask per unit, so nothing
+ *          recurses and the checks take a pass over the genes and a few word operations.
+ *
+ * @param   genes       Circuit vector of 2 * N + 1 genes, int or packed one per byte
+ * @return  bool        true if the circuit is valid, false if it is invalid or genes has the wrong length
+ */
+template <int N, class Gene>
+bool Validate_Genes(gene_span<Gene> genes)
+{
+    const unit_mask all = N == 32 ? ~(unit_mask)0 : ((unit_mask)1 << N) - 1;
+    unit_mask next[N], previous[N];
+    unit_mask to_conc = 0, to_tails = 0;
+    int start;
 
-    if (tails_num < num_units)
-        this->mark_units(tails_num);
-    else
-        // return 1 if any unit reaches to tailings end
-        this->tails_toend = 1;
+    if (genes.size != 2 * N + 1)
+        return false;
+
+    start = genes.data[0];
+    if (start < 0 || start >= N)
+        return false;
+
+    for (int i = 0; i < N; i++)
+        previous[i] = 0;
+
+    // structural checks, building the links as they go
+    for (int i = 0; i < N; i++)
+    {
+        int conc_num = genes.data[i * 2 + 1];
+        int tails_num = genes.data[i * 2 + 2];
+        unit_mask unit = (unit_mask)1 << i;
+
+        if (conc_num == tails_num || conc_num == i || tails_num == i)
+            return false;
+        if (conc_num < 0 || conc_num > N || tails_num < 0 || tails_num > N + 1 || tails_num == N)
+            return false;
+
+        next[i] = 0;
+        if (conc_num == N)
+            to_conc |= unit;
+        else
+        {
+            next[i] |= (unit_mask)1 << conc_num;
+            previous[conc_num] |= unit;
+        }
+
+        if (tails_num == N + 1)
+            to_tails |= unit;
+        else
+        {
+            next[i] |= (unit_mask)1 << tails_num;
+            previous[tails_num] |= unit;
+        }
+    }
+
+    // forward from the feed, then backward from each outlet
+    return reach((unit_mask)1 << start, next) == all && reach(to_conc, previous) == all &&
+           reach(to_tails, previous) == all;
 }
 
 /**
- * @brief   check validity of circuit
+ * @brief   Which units are reachable from the feed and which have a route to each outlet.
+ *          Genes out of range are taken as links to nowhere, so this also describes
+ *          circuits that fail the structural checks of Validate_Genes, e.g. to repair them.
  *
- * @return  bool    true if the vector is valid, false if the vector is invalid
+ * @param   genes               Circuit vector of 2 * N + 1 genes, int or packed one per byte
+ * @return  circuit_reach       One bit per unit, all bits clear if genes has the wrong length
  */
-bool CCircuit::Check_Validity()
+template <int N, class Gene>
+circuit_reach Circuit_Reach(gene_span<Gene> genes)
 {
-    bool valid = 1;
+    circuit_reach reached = {0, 0, 0, N == 32 ? ~(unit_mask)0 : ((unit_mask)1 << N) - 1};
+    unit_mask next[N], previous[N];
+    unit_mask to_conc = 0, to_tails = 0;
+
+    if (genes.size != 2 * N + 1)
+        return reached;
 
-    // Set all the cells to unseen
-    for (int i = 0; i < num_units; i++)
-        this->units[i].mark = false;
+    for (int i = 0; i < N; i++)
+        previous[i] = 0;
 
-    // Set no outlet streams
-    this->conc_toend = false;
-    this->tails_toend = false;
+    for (int i = 0; i < N; i++)
+    {
+        int link[2] = {genes.data[i * 2 + 1], genes.data[i * 2 + 2]};
 
-    // Traverse the circuit
-    mark_units(this->start);
+        next[i] = 0;
+        for (int k = 0; k < 2; k++)
+        {
+            if (link[k] >= 0 && link[k] < N)
+            {
+                next[i] |= (unit_mask)1 << link[k];
+                previous[link[k]] |= (unit_mask)1 << i;
+            }
+        }
+        if (link[0] == N)
+            to_conc |= (unit_mask)1 << i;
+        if (link[1] == N + 1)
+            to_tails |= (unit_mask)1 << i;
+    }
 
-    int conc_end = num_units;
-    int tails_end = num_units + 1;
+    if (genes.data[0] >= 0 && genes.data[0] < N)
+        reached.from_feed = reach((unit_mask)1 << genes.data[0], next);
+    reached.to_conc = reach(to_conc, previous);
+    reached.to_tails = reach(to_tails, previous);
+    return reached;
+}
+
+/**
+ * @brief   Check validity of count circuit vectors stored back to back, such as the
+ *          chromosomes of a CPopulation
+ *
+ * @param   genes       count * (2 * N + 1) genes, int or packed one per byte
+ * @param   count       Number of circuits
+ * @param   valid       Array of length count, receives the validity of every circuit
+ * @return  int         Number of valid circuits
+ */
+template <int N, class Gene>
+int Validate_Batch(const Gene *genes, int count, bool *valid)
+{
+    int valid_num = 0;
 
-    // Circuit is invalid if the start is concentrate end or tailings end
-    if (this->start == conc_end || this->start == tails_end)
+    for (int c = 0; c < count; c++)
     {
-        valid = 0;
-        return valid;
+        valid[c] = Validate_Genes<N>(gene_span<Gene>{genes + (std::size_t)c * (2 * N + 1), 2 * N + 1});
+        valid_num += valid[c];
     }
+    return valid_num;
+}
 
-    // Circuit is invalid if not all units are marked
-    for (int i = 0; i < num_units; i++)
+/**
+ * @brief   check validity of circuit, see Validate_Genes
+ *
+ * @return  bool    true if the vector is valid, false if the vector is invalid
+ */
+template <int N>
+bool CCircuitN<N>::Check_Validity()
+{
+    int chromosome[2 * N + 1];
+
+    this->units2vector(chromosome);
+    return Validate_Genes<N>(gene_span<int>{chromosome, 2 * N + 1});
+}
+
+/**
+ * @brief   Relabel units into canonical order and write the resulting circuit vector.
+ *          Units are numbered in breadth-first order from the feed unit, visiting the
+ *          concentrate destination before the tailings destination, so circuits that
+ *          differ only by unit numbering produce the same canonical vector.
+ *          Units that cannot be reached from the feed keep their relative order at the end.
+ *
+ * @param   canonical       Array of length 2 * N + 1 for the canonical circuit vector
+ * @param   order           If not NULL, array of length N that receives the unit of this
+ *                          circuit that became each canonical unit
+ */
+template <int N>
+void CCircuitN<N>::Canonical_Form(int *canonical, int *order)
+{
+    int label[N];
+    int own_order[N];
+    int labelled = 0;
+
+    if (order == NULL)
+        order = own_order;
+
+    // a feed straight to an outlet has nothing to relabel
+    if (this->start < 0 || this->start >= N)
     {
-        // Circuit is invalid if any unit has not been to
-        if (this->units[i].mark == 0)
-        {
-            valid = 0;
-            break;
-        }
-        // Circuit is invalid if destination for concentrate and tails are the same
-        if (this->units[i].conc_num == this->units[i].tails_num)
+        canonical[0] = this->start;
+        for (int i = 0; i < N; i++)
         {
-            valid = 0;
-            break;
+            canonical[i * 2 + 1] = this->units[i].conc_num;
+            canonical[i * 2 + 2] = this->units[i].tails_num;
+            order[i] = i;
         }
-        // Circuit is invalid if destination for concentrate or tail of a unit is itself
-        if (this->units[i].conc_num == i || this->units[i].tails_num == i)
+        return;
+    }
+
+    for (int i = 0; i < N; i++)
+        label[i] = -1;
+
+    label[this->start] = labelled;
+    order[labelled++] = this->start;
+
+    // order[] doubles as the breadth-first queue
+    for (int head = 0; head < labelled; head++)
+    {
+        int next[2] = {this->units[order[head]].conc_num, this->units[order[head]].tails_num};
+
+        for (int j = 0; j < 2; j++)
         {
-            valid = 0;
-            break;
+            if (next[j] >= 0 && next[j] < N && label[next[j]] < 0)
+            {
+                label[next[j]] = labelled;
+                order[labelled++] = next[j];
+            }
         }
-        // Circuit is invalid if the concentrate end is not unit_num and tailings end is not unit_num+1
-        if ((this->units[i].conc_num >= num_units && this->units[i].conc_num != conc_end) ||
-            (this->units[i].tails_num >= num_units && this->units[i].tails_num != tails_end))
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        if (label[i] < 0)
         {
-            valid = 0;
-            break;
+            label[i] = labelled;
+            order[labelled++] = i;
         }
     }
 
-    // Circuit is invalid if it does not have both concentrate and tails exit stream
-    if (this->conc_toend != 1 || this->tails_toend != 1)
-        valid = 0;
+    // outlets keep their numbers, units take their new labels
+    canonical[0] = 0;
+    for (int i = 0; i < N; i++)
+    {
+        int conc_num = this->units[order[i]].conc_num;
+        int tails_num = this->units[order[i]].tails_num;
 
-    return valid;
+        canonical[i * 2 + 1] = (conc_num >= 0 && conc_num < N) ? label[conc_num] : conc_num;
+        canonical[i * 2 + 2] = (tails_num >= 0 && tails_num < N) ? label[tails_num] : tails_num;
+    }
 }
 
 /**
- * @brief   Transfer data from circuit vector to a vector of units i.e. circuit
+ * @brief   Compact key shared by every relabelling of the same circuit
  *
- * @param   chromosome      Circuit vector
+ * @return  circuit_key<N>      Canonical circuit vector packed one gene per byte
  */
-void CCircuit::vector2units(std::vector<int> chromosome)
+template <int N>
+circuit_key<N> CCircuitN<N>::Canonical_Key()
+{
+    int canonical[2 * N + 1];
+    circuit_key<N> key;
+
+    this->Canonical_Form(canonical);
+    for (int i = 0; i < 2 * N + 1; i++)
+        key[i] = (unsigned char)canonical[i];
+    return key;
+}
+
+/**
+ * @brief   Transfer data from circuit vector stored as an array of int or of packed genes to a vector of units i.e. circuit
+ *
+ * @param   chromosome      Circuit vector, 2 * N + 1 genes
+ */
+template <int N>
+template <class Gene>
+void CCircuitN<N>::vector2units(const Gene *chromosome)
 {
     this->start = chromosome[0];
 
     // for every two nums in vectors, get its concentrate destination and 
     // tailings destination
-    for (int i = 0; i < num_units; i++)
+    for (int i = 0; i < N; i++)
     {
+        // the decomposition only depends on the links, so it is kept while they do not change
+        if (this->units[i].conc_num != chromosome[i * 2 + 1] || this->units[i].tails_num != chromosome[i * 2 + 2])
+            this->decomposed = false;
         this->units[i].conc_num = chromosome[i * 2 + 1];
         this->units[i].tails_num = chromosome[i * 2 + 2];
     }
 }
 
 /**
- * @brief   Transfer data from circuit vector stored as an integer array to a vector of units i.e. circuit
+ * @brief   Circuit vector of the units
  *
- * @param   chromosome      Circuit vector stored as an integer array
+ * @param   chromosome      Array of length 2 * N + 1 to fill
  */
-void CCircuit::vector2units(int *chromosome)
+template <int N>
+void CCircuitN<N>::units2vector(int *chromosome)
 {
-    this->start = chromosome[0];
-
-    // for every two nums in vectors, get its concentrate destination and 
-    // tailings destination
-    for (int i = 0; i < num_units; i++)
+    chromosome[0] = this->start;
+    for (int i = 0; i < N; i++)
     {
-        this->units[i].conc_num = chromosome[i * 2 + 1];
-        this->units[i].tails_num = chromosome[i * 2 + 2];
+        chromosome[i * 2 + 1] = this->units[i].conc_num;
+        chromosome[i * 2 + 2] = this->units[i].tails_num;
     }
 }
 
+/**
+ * @brief   Replace the circuit with the one viewed by genes. The solver, the feed and any
+ *          initial feed rates are kept.
+ *
+ * @param   genes       Circuit vector of 2 * N + 1 genes
+ * @return  bool        false, leaving the circuit unchanged, if genes has the wrong length
+ */
+template <int N>
+bool CCircuitN<N>::Assign(gene_span<int> genes)
+{
+    if (genes.size != 2 * N + 1)
+        return false;
+    this->vector2units(genes.data);
+    return true;
+}
+
+/**
+ * @brief   Replace the circuit with the one viewed by packed genes, e.g. a chromosome of a
+ *          CPopulation or a circuit_key. The solver, the feed and any initial feed rates are kept.
+ *
+ * @param   genes       Circuit vector of 2 * N + 1 genes, one per byte
+ * @return  bool        false, leaving the circuit unchanged, if genes has the wrong length
+ */
+template <int N>
+bool CCircuitN<N>::Assign(gene_span<unsigned char> genes)
+{
+    if (genes.size != 2 * N + 1)
+        return false;
+    this->vector2units(genes.data);
+    return true;
+}
+
+/**
+ * @brief   Score a circuit based on its performance, to the tolerance and within the
+ *          iterations given to the constructor
+ *
+ * @return  double              Score, or at most the threshold if the evaluation stopped there
+ *                              (see Set_Threshold)
+ */
+template <int N>
+double CCircuitN<N>::Evaluate_Circuit()
+{
+  return this->Evaluate_Circuit(this->tolerance, this->max_iterations);
+}
+
 /**
  * @brief   Score a circuit based on its performance
  *
  * @param   tolerance           Tolerance
  * @param   max_iterations      Maximum number of iterations
- * @return  double              Score
+ * @return  double              Score, or at most the threshold if the evaluation stopped there
+ *                              (see Set_Threshold)
  */
-double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
+template <int N>
+double CCircuitN<N>::Evaluate_Circuit(double tolerance, int max_iterations)
 {
   int iter = 0;
   bool converage;
-  double performance = 0;
+  double last_change = 0;
+  double settled = 0;
+  int settled_sweeps = 0;
+
+  this->iterations = 0;
+  this->clamps = 0;
+  this->updates = 0;
+  this->fell_back = false;
+  this->aborted = false;
+  this->saved_sweeps = 0;
+
+  // such a circuit would run to max_iterations and score -50000
+  if (this->threshold > -HUGE_VAL && this->Waste_Overflows())
+  {
+    this->aborted = true;
+    this->saved_sweeps = max_iterations;
+    return -50000;
+  }
+
   /////////////////////////////////////////////////////////////////
   //1: Give an initial guess for the feed rate of both components ///
   // to every cell in the circuit                                 ///
   /////////////////////////////////////////////////////////////////
-  for (int i = 0; i < num_units; i++)
+  for (int i = 0; i < N; i++)
   {
-    this->units[i].flow_conc = initial_conc;
-    this->units[i].flow_tails = initial_tails;
+    this->units[i].flow_conc = this->warm_start ? this->initial_flows[2 * i] : initial_conc;
+    this->units[i].flow_tails = this->warm_start ? this->initial_flows[2 * i + 1] : initial_tails;
   }
 
+  if (this->solver == COMPONENTS)
+    return this->evaluate_components(tolerance, max_iterations);
+
   while (iter < max_iterations)
   {
     converage = true;
@@ -177,13 +421,14 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
     //  to calculate the flowrate of each component in both the      //
     //  concentrate and tailings streams                            //
     //////////////////////////////////////////////////////////////////
-    for (int n = 0; n < num_units; n++)
+    for (int n = 0; n < N; n++)
     {
       if ((this->units[n].flow_conc + this->units[n].flow_tails) / 3000 < 1e-10)
       {
         //To stop overflow errors 
         this->units[n].flow_conc = 1e-7;
         this->units[n].flow_tails = 1e-7;
+        this->clamps++;
       }
     ///////////////////////////////////////////////////////////////////////////
     //3. Calculate values. Store the current value of the feed to each cell  // 
@@ -191,6 +436,7 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
     //   for all components to zero                                       ///
     /////////////////////////////////////////////////////////////////////////
       this->units[n].set_values();
+      this->updates++;
     }
 
     //////////////////////////////////////////////////////////////////
@@ -206,15 +452,15 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
     //  based on the linkages in the circuit vector.               //
     /////////////////////////////////////////////////////////////////
       
-    for (int n = 0; n < num_units; n++)
+    for (int n = 0; n < N; n++)
     {
-      if (this->units[n].conc_num < num_units)
+      if (this->units[n].conc_num < N)
       {
         this->units[this->units[n].conc_num].flow_conc += this->units[n].conc_conc;
         this->units[this->units[n].conc_num].flow_tails += this->units[n].conc_tails;
       }
 
-      if (this->units[n].tails_num < num_units)
+      if (this->units[n].tails_num < N)
       {
         this->units[this->units[n].tails_num].flow_conc += this->units[n].tails_conc;
         this->units[this->units[n].tails_num].flow_tails += this->units[n].tails_tails;
@@ -222,6 +468,7 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
     }
 
     iter++;
+    this->iterations++;
 
     ////////////////////////////////////////////////////////////////////////////////
     // 6. Check the difference between the newly calculated feed rate and       //
@@ -229,7 +476,7 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
     // that is above a given threshold (1.0e-6 might be appropriate)           //
     // then repeat from step 2.                                               //
     ///////////////////////////////////////////////////////////////////////////
-    for (int n = 0; n < num_units; n++)
+    for (int n = 0; n < N; n++)
     {
       if (abs(this->units[n].flow_conc - this->units[n].flow_conc_old) > tolerance || \
           abs(this->units[n].flow_tails - this->units[n].flow_tails_old) > tolerance)
@@ -240,6 +487,53 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
     }
     if (converage)
       break;
+
+    // Once the feed rates shrink towards the steady state at a steady rate, the distance
+    // left to it is about the tail of a geometric series. That is only an estimate: the
+    // rate of a recycle can oscillate and rise again, so it is trusted after a run of low
+    // rates, at the highest of them, and widened by a safety factor. If the caller allows
+    // it, stop as soon as the score the circuit could reach at that distance cannot beat
+    // the threshold.
+    if (this->estimate_threshold && this->threshold > -HUGE_VAL)
+    {
+      double change = this->feed_change();
+      double rate = last_change > 0 ? change / last_change : HUGE_VAL;
+
+      last_change = change;
+      if (rate < threshold_max_rate)
+      {
+        settled = std::max(settled, rate);
+        settled_sweeps++;
+      }
+      else
+      {
+        settled = 0;
+        settled_sweeps = 0;
+      }
+      if (settled_sweeps >= threshold_settled_sweeps)
+      {
+        double estimate = this->score_ceiling(threshold_safety * change / (1 - settled));
+
+        if (estimate <= this->threshold)
+        {
+          // substitution is projected to go on until the change falls below the tolerance
+          double left = std::ceil(std::log(tolerance / change) / std::log(settled));
+
+          this->aborted = true;
+          this->saved_sweeps = (int)std::min(std::max(left, 0.0), (double)(max_iterations - iter));
+          return estimate;
+        }
+      }
+    }
+
+    // Circuits without much recycle have settled by now. For the rest, hand the
+    // current feed rates to Newton's method and keep sweeping only if it fails.
+    if (this->solver == NEWTON && iter == newton_start_sweeps)
+    {
+      if (this->solve_newton(tolerance, max_iterations - iter))
+        return this->outlet_performance();
+      this->fell_back = true;
+    }
   }
     /////////////////////////////////////////////////////////////////////////////////
     // 7. Based on the flowrates of the overall circuit concentrate stream,        //
@@ -247,20 +541,734 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
     // you may wish to use the worst possible performance as the performance value //
     /////////////////////////////////////////////////////////////////////////////////
   if (converage)
-    for (int n = 0; n < num_units; n++)
+    return this->outlet_performance();
+  
+  return -50000;
+}
+
+/**
+ * @brief   Performance of the circuit from the streams computed by the last set_values call
+ *
+ * @return  double      Value of the concentrate leaving the circuit
+ */
+template <int N>
+double CCircuitN<N>::outlet_performance()
+{
+  double performance = 0;
+
+  for (int n = 0; n < N; n++)
+  {
+    if (this->units[n].conc_num > N - 1)
+      performance += this->units[n].conc_conc * 100 - this->units[n].conc_tails * 500;
+  }
+  return performance;
+}
+
+/**
+ * @brief   Whether the waste fed to the circuit can never all leave it, so that it piles up
+ *          and the feed rates grow without end. Most random circuits that fail to converge
+ *          are of this kind. However much waste a unit is fed, its concentrate carries less
+ *          than K_tails * V * phi * rho of it. Waste stays among the units the feed reaches
+ *          through tailings links alone unless it leaves by a concentrate link, so if none
+ *          of them sends its tailings to the outlet and their concentrate links out of the
+ *          set cannot carry the waste feed, it piles up.
+ *
+ * @return  bool        true if the circuit has no steady state
+ */
+template <int N>
+bool CCircuitN<N>::Waste_Overflows()
+{
+  unit_mask reached = (unit_mask)1 << this->start;
+  unit_mask frontier = reached;
+  int exits = 0;
+
+  while (frontier != 0)
+  {
+    int n = __builtin_ctz(frontier);
+    int tails = this->units[n].tails_num;
+
+    frontier &= frontier - 1;
+    if (tails >= N)
+      return false;
+    if (!(reached >> tails & 1))
     {
-      if (this->units[n].conc_num > num_units - 1)
-        performance += this->units[n].conc_conc * 100 - this->units[n].conc_tails * 500;
+      reached |= (unit_mask)1 << tails;
+      frontier |= (unit_mask)1 << tails;
     }
-  
-  else
+  }
+
+  for (int n = 0; n < N; n++)
+  {
+    int conc = this->units[n].conc_num;
+
+    if (reached >> n & 1 && (conc >= N || !(reached >> conc & 1)))
+      exits++;
+  }
+  return this->initial_tails >= exits * K_tails * V * phi * rho;
+}
+
+/**
+ * @brief   Largest change of a feed rate in the last sweep
+ *
+ * @return  double      Largest change of the concentrate or tailings feed rate of any unit
+ */
+template <int N>
+double CCircuitN<N>::feed_change()
+{
+  double change = 0;
+
+  for (int n = 0; n < N; n++)
+  {
+    change = std::max(change, std::fabs(this->units[n].flow_conc - this->units[n].flow_conc_old));
+    change = std::max(change, std::fabs(this->units[n].flow_tails - this->units[n].flow_tails_old));
+  }
+  return change;
+}
+
+/**
+ * @brief   Highest score the circuit can reach if no feed rate of the steady state is further
+ *          than distance from the feed rates the last streams were computed from. A unit
+ *          feeding the concentrate outlet adds 100 * conc_conc - 500 * conc_tails, which moves
+ *          by at most 225 per unit change of its concentrate feed and 525 per unit change of
+ *          its tailings feed (a stream is a feed times a recovery that falls as the total
+ *          feed grows, and the feed times the slope of the recovery is never above a quarter),
+ *          so the score moves by at most 750 * distance per such unit. It can never exceed
+ *          the value of all the valuable feed. The ceiling is only as good as distance, which
+ *          Evaluate_Circuit estimates.
+ *
+ * @param   distance    Largest distance of a feed rate from its steady-state value
+ * @return  double      Highest score of a steady state within distance
+ */
+template <int N>
+double CCircuitN<N>::score_ceiling(double distance)
+{
+  int outlet_units = 0;
+
+  for (int n = 0; n < N; n++)
+    outlet_units += this->units[n].conc_num > N - 1;
+
+  return std::min(this->outlet_performance() + 750 * outlet_units * distance, 100 * this->initial_conc);
+}
+
+/**
+ * @brief   Residual of the steady-state mass balance, G(x) = x - feed - inflow(x), where x
+ *          holds the concentrate and tailings feed rate of every unit. Optionally also builds
+ *          the analytic Jacobian dG/dx.
+ *
+ * @param   x           Feed rates, x[2n] concentrate and x[2n+1] tailings of unit n
+ * @param   residual    Array of length 2 * N for G(x)
+ * @param   jacobian    Row-major array of (2 * N)^2 for dG/dx, or NULL
+ */
+template <int N>
+void CCircuitN<N>::mass_balance(const double *x, double *residual, double *jacobian)
+{
+  const int size = 2 * N;
+  // tau = c / (flow_conc + flow_tails), so R = K tau / (1 + K tau) = K c / (s + K c)
+  const double a_conc = K_conc * V * phi * rho;
+  const double a_tails = K_tails * V * phi * rho;
+
+  for (int i = 0; i < size; i++)
+    residual[i] = x[i];
+  residual[2 * this->start] -= this->initial_conc;
+  residual[2 * this->start + 1] -= this->initial_tails;
+
+  if (jacobian != NULL)
+  {
+    for (int i = 0; i < size * size; i++)
+      jacobian[i] = 0;
+    for (int i = 0; i < size; i++)
+      jacobian[i * size + i] = 1;
+  }
+
+  for (int n = 0; n < N; n++)
+  {
+    double fc = x[2 * n];
+    double ft = x[2 * n + 1];
+    double s = fc + ft;
+    double R_conc = a_conc / (s + a_conc);
+    double R_tails = a_tails / (s + a_tails);
+
+    // streams leaving unit n and their derivatives with respect to (fc, ft)
+    double conc_conc = fc * R_conc;
+    double conc_tails = ft * R_tails;
+    double dcc_dfc = R_conc - fc * a_conc / ((s + a_conc) * (s + a_conc));
+    double dcc_dft = -fc * a_conc / ((s + a_conc) * (s + a_conc));
+    double dct_dft = R_tails - ft * a_tails / ((s + a_tails) * (s + a_tails));
+    double dct_dfc = -ft * a_tails / ((s + a_tails) * (s + a_tails));
+
+    int conc_num = this->units[n].conc_num;
+    int tails_num = this->units[n].tails_num;
+
+    if (conc_num < N)
+    {
+      residual[2 * conc_num] -= conc_conc;
+      residual[2 * conc_num + 1] -= conc_tails;
+      if (jacobian != NULL)
+      {
+        jacobian[(2 * conc_num) * size + 2 * n] -= dcc_dfc;
+        jacobian[(2 * conc_num) * size + 2 * n + 1] -= dcc_dft;
+        jacobian[(2 * conc_num + 1) * size + 2 * n] -= dct_dfc;
+        jacobian[(2 * conc_num + 1) * size + 2 * n + 1] -= dct_dft;
+      }
+    }
+
+    if (tails_num < N)
+    {
+      residual[2 * tails_num] -= fc - conc_conc;
+      residual[2 * tails_num + 1] -= ft - conc_tails;
+      if (jacobian != NULL)
+      {
+        jacobian[(2 * tails_num) * size + 2 * n] -= 1 - dcc_dfc;
+        jacobian[(2 * tails_num) * size + 2 * n + 1] -= -dcc_dft;
+        jacobian[(2 * tails_num + 1) * size + 2 * n] -= -dct_dfc;
+        jacobian[(2 * tails_num + 1) * size + 2 * n + 1] -= 1 - dct_dft;
+      }
+    }
+  }
+}
+
+/**
+ * @brief   Solve the steady-state mass balance with damped Newton's method, starting from
+ *          the feed rates currently held by the units. On success the units hold the
+ *          converged feed rates and the streams computed from them; on failure they are
+ *          left untouched.
+ *
+ * @param   tolerance           Largest change in any feed rate accepted as converged
+ * @param   max_iterations      Maximum number of Newton steps (capped at max_newton_steps)
+ * @return  bool                false if Newton's method diverged or stalled
+ */
+template <int N>
+bool CCircuitN<N>::solve_newton(double tolerance, int max_iterations)
+{
+  const int size = 2 * N;
+  double x[2 * N], x_new[2 * N];
+  double residual[2 * N], residual_new[2 * N];
+  double jacobian[4 * N * N];
+  double step[2 * N];
+  int steps = max_iterations < max_newton_steps ? max_iterations : max_newton_steps;
+  double best_change = HUGE_VAL;
+  int best_iter = 0;
+
+  // the start unit must exist for the balance to be defined
+  if (this->start < 0 || this->start >= N)
+    return false;
+
+  // nor is it for a link below 0, which Evaluate_Circuit does not check for
+  for (int n = 0; n < N; n++)
+    if (this->units[n].conc_num < 0 || this->units[n].tails_num < 0)
+      return false;
+
+  // material fed to a unit that cannot reach an outlet accumulates without
+  // bound, so there is no steady state for Newton's method to find
+  bool drains[N] = {false};
+  for (int pass = 0; pass < N; pass++)
+  {
+    for (int n = 0; n < N; n++)
+    {
+      int conc_num = this->units[n].conc_num;
+      int tails_num = this->units[n].tails_num;
+      if (conc_num >= N || tails_num >= N ||
+          drains[conc_num] || drains[tails_num])
+        drains[n] = true;
+    }
+  }
+  for (int n = 0; n < N; n++)
+    if (!drains[n])
+      return false;
+
+  for (int n = 0; n < N; n++)
+  {
+    x[2 * n] = this->units[n].flow_conc;
+    x[2 * n + 1] = this->units[n].flow_tails;
+  }
+
+  for (int iter = 0; iter < steps; iter++)
+  {
+    this->iterations++;
+    this->mass_balance(x, residual, jacobian);
+
+    // solve J step = -G by Gaussian elimination with partial pivoting
+    for (int i = 0; i < size; i++)
+      step[i] = -residual[i];
+
+    for (int col = 0; col < size; col++)
+    {
+      int pivot = col;
+      for (int row = col + 1; row < size; row++)
+        if (fabs(jacobian[row * size + col]) > fabs(jacobian[pivot * size + col]))
+          pivot = row;
+
+      // a singular Jacobian means material is trapped and there is no steady state
+      if (fabs(jacobian[pivot * size + col]) < 1e-14)
+        return false;
+
+      if (pivot != col)
+      {
+        for (int k = 0; k < size; k++)
+        {
+          double temp = jacobian[col * size + k];
+          jacobian[col * size + k] = jacobian[pivot * size + k];
+          jacobian[pivot * size + k] = temp;
+        }
+        double temp = step[col];
+        step[col] = step[pivot];
+        step[pivot] = temp;
+      }
+
+      for (int row = col + 1; row < size; row++)
+      {
+        double factor = jacobian[row * size + col] / jacobian[col * size + col];
+        if (factor == 0)
+          continue;
+        for (int k = col; k < size; k++)
+          jacobian[row * size + k] -= factor * jacobian[col * size + k];
+        step[row] -= factor * step[col];
+      }
+    }
+
+    for (int row = size - 1; row >= 0; row--)
+    {
+      for (int k = row + 1; k < size; k++)
+        step[row] -= jacobian[row * size + k] * step[k];
+      step[row] /= jacobian[row * size + row];
+    }
+
+    // Take the step in log(x), which linearises to the same Newton step but
+    // keeps every feed rate positive. Cap the relative change of each rate so a
+    // poor early step cannot overflow.
+    for (int i = 0; i < size; i++)
+    {
+      if (x[i] <= 0)
+        return false;
+      double relative = step[i] / x[i];
+      if (relative > 2)
+        relative = 2;
+      else if (relative < -2)
+        relative = -2;
+      x_new[i] = x[i] * exp(relative);
+    }
+    this->mass_balance(x_new, residual_new, NULL);
+
+    // G(x) is the change one substitution sweep would make, so this is the
+    // same convergence test as the substitution loop
+    double change = 0;
+    for (int i = 0; i < size; i++)
+    {
+      if (fabs(residual_new[i]) > change)
+        change = fabs(residual_new[i]);
+      x[i] = x_new[i];
+    }
+
+    // give up when the residual stops shrinking, as it does when the feed
+    // outgrows what can leave the circuit and no steady state exists
+    if (!std::isfinite(change))
+      return false;
+    if (change < 0.5 * best_change)
+    {
+      best_change = change;
+      best_iter = iter;
+    }
+    else if (iter - best_iter >= newton_stall_steps)
+      return false;
+
+    if (change <= tolerance)
+    {
+      // compute the outlet streams at the converged feed rates
+      for (int n = 0; n < N; n++)
+      {
+        this->units[n].flow_conc = x[2 * n];
+        this->units[n].flow_tails = x[2 * n + 1];
+        this->units[n].set_values();
+      }
+      this->updates += N;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief   Split the circuit into strongly connected components, the recycle loops and the
+ *          units outside any loop, and order them so that every component comes before the
+ *          components it feeds. Two units share a component if each reaches the other. A unit
+ *          upstream of another reaches every unit the other reaches and the other's component
+ *          besides, so ordering the units by how many units they reach orders the components.
+ */
+template <int N>
+void CCircuitN<N>::decompose()
+{
+  unit_mask next[N], reached[N];
+  unit_mask placed = 0;
+  int order[N];
+
+  for (int n = 0; n < N; n++)
+  {
+    int conc_num = this->units[n].conc_num;
+    int tails_num = this->units[n].tails_num;
+
+    next[n] = 0;
+    if (conc_num >= 0 && conc_num < N)
+      next[n] |= (unit_mask)1 << conc_num;
+    if (tails_num >= 0 && tails_num < N)
+      next[n] |= (unit_mask)1 << tails_num;
+  }
+
+  for (int n = 0; n < N; n++)
+  {
+    reached[n] = reach((unit_mask)1 << n, next);
+    order[n] = n;
+  }
+  std::stable_sort(order, order + N, [&reached](int a, int b)
+                   { return __builtin_popcount(reached[a]) > __builtin_popcount(reached[b]); });
+
+  this->component_num = 0;
+  for (int i = 0; i < N; i++)
+  {
+    int n = order[i];
+    unit_mask members = 0;
+
+    if (placed >> n & 1)
+      continue;
+
+    // the units n reaches that also reach n
+    for (unit_mask candidates = reached[n]; candidates != 0; candidates &= candidates - 1)
+    {
+      int m = __builtin_ctz(candidates);
+      if (reached[m] >> n & 1)
+        members |= (unit_mask)1 << m;
+    }
+    this->components[this->component_num++] = members;
+    placed |= members;
+  }
+  this->decomposed = true;
+}
+
+/**
+ * @brief   Solve the circuit one strongly connected component at a time, upstream components
+ *          first. The feed of a component is settled once every component upstream of it is,
+ *          so a unit outside any loop is computed once from it, and a recycle loop runs
+ *          successive substitution over its own units only, until none of their feed rates
+ *          changes by more than the tolerance. The steady state is the one SUBSTITUTION finds.
+ *
+ * @param   tolerance           Largest change in a feed rate of a loop accepted as converged
+ * @param   max_iterations      Maximum number of sweeps of each loop
+ * @return  double              Score, -50000 if a loop does not converge
+ */
+template <int N>
+double CCircuitN<N>::evaluate_components(double tolerance, int max_iterations)
+{
+  // feed of every unit from the circuit feed and from the components settled so far
+  double inflow[2 * N] = {0};
+
+  if (this->start < 0 || this->start >= N)
     return -50000;
-  
-  return performance;
+  if (!this->decomposed)
+    this->decompose();
+
+  inflow[2 * this->start] = this->initial_conc;
+  inflow[2 * this->start + 1] = this->initial_tails;
+
+  for (int c = 0; c < this->component_num; c++)
+  {
+    unit_mask members = this->components[c];
+    int first = __builtin_ctz(members);
+
+    if ((members & (members - 1)) != 0 || this->units[first].conc_num == first || this->units[first].tails_num == first)
+    {
+      if (!this->solve_loop(members, inflow, tolerance, max_iterations))
+        return -50000;
+    }
+    else
+    {
+      CUnit &unit = this->units[first];
+
+      unit.flow_conc = inflow[2 * first];
+      unit.flow_tails = inflow[2 * first + 1];
+      if ((unit.flow_conc + unit.flow_tails) / 3000 < 1e-10)
+      {
+        unit.flow_conc = 1e-7;
+        unit.flow_tails = 1e-7;
+        this->clamps++;
+      }
+      unit.set_values();
+      this->updates++;
+
+      // leave the feed in place, as a converged sweep would
+      unit.flow_conc = unit.flow_conc_old;
+      unit.flow_tails = unit.flow_tails_old;
+    }
+
+    // pass the settled streams on to the components downstream
+    for (unit_mask left = members; left != 0; left &= left - 1)
+    {
+      int n = __builtin_ctz(left);
+      int conc_num = this->units[n].conc_num;
+      int tails_num = this->units[n].tails_num;
+
+      if (conc_num >= 0 && conc_num < N && !(members >> conc_num & 1))
+      {
+        inflow[2 * conc_num] += this->units[n].conc_conc;
+        inflow[2 * conc_num + 1] += this->units[n].conc_tails;
+      }
+      if (tails_num >= 0 && tails_num < N && !(members >> tails_num & 1))
+      {
+        inflow[2 * tails_num] += this->units[n].tails_conc;
+        inflow[2 * tails_num + 1] += this->units[n].tails_tails;
+      }
+    }
+  }
+  return this->outlet_performance();
+}
+
+/**
+ * @brief   Successive substitution over the units of one recycle loop, starting from the
+ *          feed rates they hold, with the feed from outside the loop fixed
+ *
+ * @param   members             Units of the loop, one bit per unit
+ * @param   inflow              Settled feed of every unit from outside the loop, 2 * N values
+ * @param   tolerance           Largest change in a feed rate of the loop accepted as converged
+ * @param   max_iterations      Maximum number of sweeps
+ * @return  bool                false if the loop did not converge
+ */
+template <int N>
+bool CCircuitN<N>::solve_loop(unit_mask members, const double *inflow, double tolerance, int max_iterations)
+{
+  for (int iter = 0; iter < max_iterations; iter++)
+  {
+    bool converged = true;
+
+    for (unit_mask left = members; left != 0; left &= left - 1)
+    {
+      CUnit &unit = this->units[__builtin_ctz(left)];
+
+      if ((unit.flow_conc + unit.flow_tails) / 3000 < 1e-10)
+      {
+        unit.flow_conc = 1e-7;
+        unit.flow_tails = 1e-7;
+        this->clamps++;
+      }
+      unit.set_values();
+      this->updates++;
+    }
+
+    for (unit_mask left = members; left != 0; left &= left - 1)
+    {
+      int n = __builtin_ctz(left);
+      this->units[n].flow_conc = inflow[2 * n];
+      this->units[n].flow_tails = inflow[2 * n + 1];
+    }
+
+    for (unit_mask left = members; left != 0; left &= left - 1)
+    {
+      int n = __builtin_ctz(left);
+      int conc_num = this->units[n].conc_num;
+      int tails_num = this->units[n].tails_num;
+
+      if (conc_num >= 0 && conc_num < N && members >> conc_num & 1)
+      {
+        this->units[conc_num].flow_conc += this->units[n].conc_conc;
+        this->units[conc_num].flow_tails += this->units[n].conc_tails;
+      }
+      if (tails_num >= 0 && tails_num < N && members >> tails_num & 1)
+      {
+        this->units[tails_num].flow_conc += this->units[n].tails_conc;
+        this->units[tails_num].flow_tails += this->units[n].tails_tails;
+      }
+    }
+    this->iterations++;
+
+    for (unit_mask left = members; converged && left != 0; left &= left - 1)
+    {
+      const CUnit &unit = this->units[__builtin_ctz(left)];
+      converged = std::fabs(unit.flow_conc - unit.flow_conc_old) <= tolerance &&
+                  std::fabs(unit.flow_tails - unit.flow_tails_old) <= tolerance;
+    }
+    if (converged)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * @brief   Choose the steady-state solver used by Evaluate_Circuit
+ *
+ * @param   mode        SUBSTITUTION, NEWTON or COMPONENTS
+ */
+template <int N>
+void CCircuitN<N>::Set_Solver(Solver_Mode mode)
+{
+  this->solver = mode;
+}
+
+/**
+ * @brief   Start the next evaluations from given feed rates, for example the converged feed
+ *          rates of a similar circuit, instead of the circuit feed in every unit
+ *
+ * @param   flows       Concentrate and tailings feed of unit 0, then of unit 1, ...,
+ *                      2 * N values; NULL to start from the circuit feed again
+ */
+template <int N>
+void CCircuitN<N>::Set_Initial_Flows(const double *flows)
+{
+  this->warm_start = flows != NULL;
+  for (int i = 0; this->warm_start && i < 2 * N; i++)
+    this->initial_flows[i] = flows[i];
+}
+
+/**
+ * @brief   Feed rates of every unit at the end of the last evaluation: the steady state if
+ *          it converged, in the layout Set_Initial_Flows takes
+ *
+ * @param   flows       Array of length 2 * N to fill
+ */
+template <int N>
+void CCircuitN<N>::Get_Flows(double *flows)
+{
+  // set_values keeps the feed rates the last streams were computed from
+  for (int i = 0; i < N; i++)
+  {
+    flows[2 * i] = this->units[i].flow_conc_old;
+    flows[2 * i + 1] = this->units[i].flow_tails_old;
+  }
+}
+
+/**
+ * @brief   Number of sweeps or Newton steps used by the last Evaluate_Circuit call
+ *
+ * @return  int         Iterations, including substitution sweeps after a Newton fallback;
+ *                      with COMPONENTS the sweeps of every recycle loop added up
+ */
+template <int N>
+int CCircuitN<N>::Last_Iterations()
+{
+  return this->iterations;
+}
+
+/**
+ * @brief   Number of times the last Evaluate_Circuit call found a unit with almost no feed
+ *          and reset its feed rates to 1e-7
+ *
+ * @return  int         Resets, counted once per unit and sweep
+ */
+template <int N>
+int CCircuitN<N>::Last_Clamps()
+{
+  return this->clamps;
+}
+
+/**
+ * @brief   Number of times the last Evaluate_Circuit call computed the streams of a unit,
+ *          the work of a sweep being one per unit it covers
+ *
+ * @return  int         Unit updates, including the final streams of a Newton solve
+ */
+template <int N>
+int CCircuitN<N>::Last_Unit_Updates()
+{
+  return this->updates;
+}
+
+/**
+ * @brief   Strongly connected components of the circuit, upstream components first: each
+ *          recycle loop is one component and every unit outside a loop is a component of
+ *          its own. The decomposition is kept until the links of the circuit change.
+ *
+ * @param   components      Array of length N that receives the units of every component,
+ *                          bit i for unit i
+ * @return  int             Number of components
+ */
+template <int N>
+int CCircuitN<N>::Components(std::uint32_t *components)
+{
+  if (!this->decomposed)
+    this->decompose();
+  for (int c = 0; c < this->component_num; c++)
+    components[c] = this->components[c];
+  return this->component_num;
 }
 
 /**
- * @brief   Constructor for CCircuit object from circuit vector
+ * @brief   Whether the last Evaluate_Circuit call fell back from Newton to substitution
+ *
+ * @return  bool        true if Newton's method failed and substitution was used
+ */
+template <int N>
+bool CCircuitN<N>::Fell_Back()
+{
+  return this->fell_back;
+}
+
+/**
+ * @brief   Stop the next evaluations as soon as the score cannot exceed threshold, for
+ *          callers that only keep circuits scoring above it. That is certain only for a
+ *          circuit whose waste piles up, which scores -50000 without a sweep. With estimate,
+ *          evaluations also stop once the score is estimated not to exceed threshold. The
+ *          estimate is a heuristic, not a bound: it extrapolates how far the feed rates still
+ *          move per sweep and how fast that shrinks, once that rate has stayed low for
+ *          threshold_settled_sweeps sweeps, with a safety factor of threshold_safety, and an
+ *          evaluation it stops returns the estimate instead of the score. Newton steps are
+ *          not estimated, so NEWTON estimates only in the sweeps before them and after a
+ *          fallback, and COMPONENTS never does.
+ *
+ * @param   threshold       Score to beat, -HUGE_VAL to always converge
+ * @param   estimate        Also stop on the estimate, at the risk of stopping a circuit
+ *                          that would have beaten threshold
+ */
+template <int N>
+void CCircuitN<N>::Set_Threshold(double threshold, bool estimate)
+{
+  this->threshold = threshold;
+  this->estimate_threshold = estimate;
+}
+
+/**
+ * @brief   Whether the last Evaluate_Circuit call stopped early at the threshold
+ *
+ * @return  bool        true if the returned score is -50000 for waste that piles up, or an
+ *                      estimate of at most the threshold
+ */
+template <int N>
+bool CCircuitN<N>::Aborted()
+{
+  return this->aborted;
+}
+
+/**
+ * @brief   Sweeps the last Evaluate_Circuit call is projected to have skipped by stopping at
+ *          the threshold: max_iterations for waste that piles up, otherwise extrapolated from
+ *          the rate the feed rates were settling at when it stopped. They are not measured.
+ *
+ * @return  int         Projected sweeps successive substitution would still have taken, 0 if it
+ *                      did not stop early
+ */
+template <int N>
+int CCircuitN<N>::Saved_Sweeps()
+{
+  return this->saved_sweeps;
+}
+
+/**
+ * @brief   Constructor for an empty CCircuitN object, to be filled by Assign. Until then
+ *          the feed goes straight to the concentrate outlet, which is not a valid circuit.
+ */
+template <int N>
+CCircuitN<N>::CCircuitN()
+{
+    this->start = N;
+    for (int i = 0; i < N; i++)
+    {
+        this->units[i].conc_num = N;
+        this->units[i].tails_num = N + 1;
+    }
+
+    this->tolerance = 1e-6;
+    this->max_iterations = 1000;
+    this->initial_conc = 10;
+    this->initial_tails = 100;
+}
+
+/**
+ * @brief   Constructor for CCircuitN object from circuit vector
  *
  * @param   chromosome          circuit vector
  * @param   tolerance           error tolerance
@@ -268,16 +1276,19 @@ double CCircuit::Evaluate_Circuit(double tolerance, int max_iterations)
  * @param   initial_conc        initial feed concentrate
  * @param   initial_tails       initial feed tailings
  */
-CCircuit::CCircuit(std::vector<int> chromosome, double tolerance, int max_iterations, int initial_conc, int initial_tails)
+template <int N>
+CCircuitN<N>::CCircuitN(const std::vector<int> &chromosome, double tolerance, int max_iterations, int initial_conc, int initial_tails)
 {
-    this->vector2units(chromosome);
+    this->vector2units(chromosome.data());
 
+    this->tolerance = tolerance;
+    this->max_iterations = max_iterations;
     this->initial_conc = initial_conc;
     this->initial_tails = initial_tails;
 }
 
 /**
- * @brief   Constructor for CCircuit object from circuit vector stored as an integer array
+ * @brief   Constructor for CCircuitN object from circuit vector stored as an integer array
  *
  * @param   chromosome          circuit vector stored as an integer array
  * @param   tolerance           error tolerance
@@ -285,10 +1296,117 @@ CCircuit::CCircuit(std::vector<int> chromosome, double tolerance, int max_iterat
  * @param   initial_conc        initial feed concentrate
  * @param   initial_tails       initial feed tailings
  */
-CCircuit::CCircuit(int *chromosome, double tolerance, int max_iterations, int initial_conc, int initial_tails)
+template <int N>
+CCircuitN<N>::CCircuitN(const int *chromosome, double tolerance, int max_iterations, int initial_conc, int initial_tails)
 {
     this->vector2units(chromosome);
 
+    this->tolerance = tolerance;
+    this->max_iterations = max_iterations;
     this->initial_conc = initial_conc;
     this->initial_tails = initial_tails;
 }
+
+/**
+ * @brief   Score the circuit viewed by genes. Nothing is allocated: the genes are read in
+ *          place and every intermediate value lives in scratch, which the caller can reuse
+ *          from one circuit to the next.
+ *
+ * @param   genes               Circuit vector of 2 * N + 1 genes, int or packed one per byte
+ * @param   scratch             Working storage, overwritten; its feed rates are the circuit feed
+ * @param   mode                SUBSTITUTION, NEWTON or COMPONENTS
+ * @param   initial_flows       Feed rates to start from, laid out as CCircuitN<N>::Get_Flows
+ *                              writes them, or NULL to start from the circuit feed
+ * @param   tolerance           Tolerance
+ * @param   max_iterations      Maximum number of iterations
+ * @param   threshold           Stop as soon as the score cannot exceed this, see
+ *                              CCircuitN<N>::Set_Threshold; -HUGE_VAL to always converge
+ * @param   estimate            Also stop once the score is only estimated not to exceed it
+ * @return  double              Score, -50000 if genes has the wrong length, the circuit is
+ *                              invalid or it does not converge, and at most threshold if
+ *                              the evaluation stopped there
+ */
+template <int N, class Gene>
+double Evaluate_Genes(gene_span<Gene> genes, CCircuitN<N> &scratch, Solver_Mode mode,
+                      const double *initial_flows, double tolerance, int max_iterations, double threshold,
+                      bool estimate)
+{
+    if (!Validate_Genes<N>(genes))
+        return -50000;
+
+    scratch.Assign(genes);
+
+    scratch.Set_Solver(mode);
+    scratch.Set_Initial_Flows(initial_flows);
+    scratch.Set_Threshold(threshold, estimate);
+    return scratch.Evaluate_Circuit(tolerance, max_iterations);
+}
+
+/**
+ * @brief   Check validity of a circuit vector of any size built into the library.
+ *          The size is read from the length of the vector.
+ *
+ * @param   chromosome      Circuit vector of length 2 * unit count + 1
+ * @return  bool            false if the vector is invalid or of a size not built in
+ */
+bool Circuit_Validity(const std::vector<int> &chromosome)
+{
+    if (chromosome.size() % 2 == 0)
+        return false;
+
+    switch (((int)chromosome.size() - 1) / 2)
+    {
+        #define VALIDITY_CASE(UNITS) \
+        case UNITS: \
+            return CCircuitN<UNITS>(chromosome.data()).Check_Validity();
+        FOR_EACH_UNIT_COUNT(VALIDITY_CASE)
+        #undef VALIDITY_CASE
+    }
+    return false;
+}
+
+/**
+ * @brief   Score a circuit vector of any size built into the library.
+ *          The size is read from the length of the vector.
+ *
+ * @param   chromosome          Circuit vector of length 2 * unit count + 1
+ * @param   mode                SUBSTITUTION, NEWTON or COMPONENTS
+ * @param   tolerance           Tolerance
+ * @param   max_iterations      Maximum number of iterations
+ * @return  double              Score, -50000 if it does not converge or the size is not built in
+ */
+double Circuit_Performance(const std::vector<int> &chromosome, Solver_Mode mode, double tolerance, int max_iterations)
+{
+    if (chromosome.size() % 2 == 0)
+        return -50000;
+
+    switch (((int)chromosome.size() - 1) / 2)
+    {
+        #define PERFORMANCE_CASE(UNITS) \
+        case UNITS: \
+        { \
+            CCircuitN<UNITS> circuit(chromosome.data()); \
+            circuit.Set_Solver(mode); \
+            return circuit.Evaluate_Circuit(tolerance, max_iterations); \
+        }
+        FOR_EACH_UNIT_COUNT(PERFORMANCE_CASE)
+        #undef PERFORMANCE_CASE
+    }
+    return -50000;
+}
+
+#define INSTANTIATE_CIRCUIT(UNITS) \
+    template class CCircuitN<UNITS>; \
+    template double Evaluate_Genes<UNITS, int>(gene_span<int>, CCircuitN<UNITS> &, Solver_Mode, \
+                                               const double *, double, int, double, bool); \
+    template double Evaluate_Genes<UNITS, unsigned char>(gene_span<unsigned char>, CCircuitN<UNITS> &, \
+                                                         Solver_Mode, const double *, double, int, double, \
+                                                         bool); \
+    template bool Validate_Genes<UNITS, int>(gene_span<int>); \
+    template bool Validate_Genes<UNITS, unsigned char>(gene_span<unsigned char>); \
+    template circuit_reach Circuit_Reach<UNITS, int>(gene_span<int>); \
+    template circuit_reach Circuit_Reach<UNITS, unsigned char>(gene_span<unsigned char>); \
+    template int Validate_Batch<UNITS, int>(const int *, int, bool *); \
+    template int Validate_Batch<UNITS, unsigned char>(const unsigned char *, int, bool *);
+FOR_EACH_UNIT_COUNT(INSTANTIATE_CIRCUIT)
+#undef INSTANTIATE_CIRCUIT
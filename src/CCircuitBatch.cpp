@@ -0,0 +1,699 @@
+/**
+ * @file    CCircuitBatch.cpp
+ * @author  Galena Group
+ * @brief   Lockstep evaluation of a population of circuits with vector kernels
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include <cmath>
+#include "../includes/CCircuitBatch.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief   Lanes of the sweep, indexed [unit * Lanes + lane]. The streams leaving
+ *          unit n are stream n (concentrate) and stream N + n (tailings).
+ */
+template <int N, class Real, int Lanes>
+struct batch_lanes_state
+{
+    Real flow_conc[N * Lanes];
+    Real flow_tails[N * Lanes];
+    Real flow_conc_old[N * Lanes];
+    Real flow_tails_old[N * Lanes];
+    /** concentrate in the concentrate streams, then in the tailings streams */
+    Real stream_conc[2 * N * Lanes];
+    /** tailings in the concentrate streams, then in the tailings streams */
+    Real stream_tails[2 * N * Lanes];
+    /** Solids held by a unit, V * phi * rho, in every lane */
+    Real holdup[Lanes];
+    /** Rate constant of gormanium in every lane */
+    Real rate_conc[Lanes];
+    /** Rate constant of waste in every lane */
+    Real rate_tails[Lanes];
+};
+
+/**
+ * @brief   set_values for every unit of every lane, one lane at a time
+ *
+ * @param   state       Lanes of the sweep
+ */
+template <int N, class Real, int Lanes>
+static void batch_set_values(batch_lanes_state<N, Real, Lanes> &state)
+{
+    const int tails_stream = N * Lanes;
+
+    for (int i = 0; i < N * Lanes; i++)
+    {
+        Real fc = state.flow_conc[i];
+        Real ft = state.flow_tails[i];
+
+        // To stop overflow errors
+        if ((fc + ft) / 3000 < (Real)1e-10)
+        {
+            fc = (Real)1e-7;
+            ft = (Real)1e-7;
+        }
+
+        Real tau = state.holdup[i % Lanes] / (fc + ft);
+        Real R_conc = state.rate_conc[i % Lanes] * tau / (1 + state.rate_conc[i % Lanes] * tau);
+        Real R_tails = state.rate_tails[i % Lanes] * tau / (1 + state.rate_tails[i % Lanes] * tau);
+
+        state.stream_conc[i] = fc * R_conc;
+        state.stream_tails[i] = ft * R_tails;
+        state.stream_conc[tails_stream + i] = fc * (1 - R_conc);
+        state.stream_tails[tails_stream + i] = ft * (1 - R_tails);
+        state.flow_conc_old[i] = fc;
+        state.flow_tails_old[i] = ft;
+    }
+}
+
+/**
+ * @brief   Bit mask of the lanes in which some feed rate changed by more than the
+ *          tolerance, one lane at a time
+ *
+ * @param   state       Lanes of the sweep
+ * @param   tolerance   Tolerance
+ * @return  int         Bit l is set if lane l has not converged
+ */
+template <int N, class Real, int Lanes>
+static int batch_changed(const batch_lanes_state<N, Real, Lanes> &state, Real tolerance)
+{
+    int changed = 0;
+
+    for (int i = 0; i < N * Lanes; i++)
+    {
+        if (std::fabs(state.flow_conc[i] - state.flow_conc_old[i]) > tolerance ||
+            std::fabs(state.flow_tails[i] - state.flow_tails_old[i]) > tolerance)
+            changed |= 1 << (i % Lanes);
+    }
+    return changed;
+}
+
+#ifdef __AVX2__
+/**
+ * @brief   set_values for every unit of every lane, four lanes of doubles to a register
+ *
+ * @param   state       Lanes of the sweep
+ */
+template <int N>
+static void batch_set_values(batch_lanes_state<N, double, batch_lanes> &state)
+{
+    const int tails_stream = N * batch_lanes;
+
+    const __m256d c = _mm256_loadu_pd(state.holdup);
+    const __m256d k_conc = _mm256_loadu_pd(state.rate_conc);
+    const __m256d k_tails = _mm256_loadu_pd(state.rate_tails);
+    const __m256d one = _mm256_set1_pd(1);
+    const __m256d limit = _mm256_set1_pd(1e-10);
+    const __m256d three_thousand = _mm256_set1_pd(3000);
+    const __m256d floor = _mm256_set1_pd(1e-7);
+
+    for (int i = 0; i < N * batch_lanes; i += batch_lanes)
+    {
+        __m256d fc = _mm256_loadu_pd(&state.flow_conc[i]);
+        __m256d ft = _mm256_loadu_pd(&state.flow_tails[i]);
+
+        // To stop overflow errors
+        __m256d empty = _mm256_cmp_pd(_mm256_div_pd(_mm256_add_pd(fc, ft), three_thousand), limit, _CMP_LT_OQ);
+        fc = _mm256_blendv_pd(fc, floor, empty);
+        ft = _mm256_blendv_pd(ft, floor, empty);
+
+        __m256d tau = _mm256_div_pd(c, _mm256_add_pd(fc, ft));
+        __m256d kt_conc = _mm256_mul_pd(k_conc, tau);
+        __m256d kt_tails = _mm256_mul_pd(k_tails, tau);
+        __m256d R_conc = _mm256_div_pd(kt_conc, _mm256_add_pd(one, kt_conc));
+        __m256d R_tails = _mm256_div_pd(kt_tails, _mm256_add_pd(one, kt_tails));
+
+        _mm256_storeu_pd(&state.stream_conc[i], _mm256_mul_pd(fc, R_conc));
+        _mm256_storeu_pd(&state.stream_tails[i], _mm256_mul_pd(ft, R_tails));
+        _mm256_storeu_pd(&state.stream_conc[tails_stream + i], _mm256_mul_pd(fc, _mm256_sub_pd(one, R_conc)));
+        _mm256_storeu_pd(&state.stream_tails[tails_stream + i], _mm256_mul_pd(ft, _mm256_sub_pd(one, R_tails)));
+        _mm256_storeu_pd(&state.flow_conc_old[i], fc);
+        _mm256_storeu_pd(&state.flow_tails_old[i], ft);
+    }
+}
+
+/**
+ * @brief   Bit mask of the lanes in which some feed rate changed by more than the
+ *          tolerance, four lanes of doubles to a register
+ *
+ * @param   state       Lanes of the sweep
+ * @param   tolerance   Tolerance
+ * @return  int         Bit l is set if lane l has not converged
+ */
+template <int N>
+static int batch_changed(const batch_lanes_state<N, double, batch_lanes> &state, double tolerance)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d tol = _mm256_set1_pd(tolerance);
+    __m256d moved = _mm256_setzero_pd();
+
+    for (int i = 0; i < N * batch_lanes; i += batch_lanes)
+    {
+        __m256d dc = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(&state.flow_conc[i]),
+                                                          _mm256_loadu_pd(&state.flow_conc_old[i])));
+        __m256d dt = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(&state.flow_tails[i]),
+                                                          _mm256_loadu_pd(&state.flow_tails_old[i])));
+        moved = _mm256_or_pd(moved, _mm256_cmp_pd(dc, tol, _CMP_GT_OQ));
+        moved = _mm256_or_pd(moved, _mm256_cmp_pd(dt, tol, _CMP_GT_OQ));
+    }
+    return _mm256_movemask_pd(moved);
+}
+
+/**
+ * @brief   set_values for every unit of every lane, eight lanes of floats to a register
+ *
+ * @param   state       Lanes of the sweep
+ */
+template <int N>
+static void batch_set_values(batch_lanes_state<N, float, screen_lanes> &state)
+{
+    const int tails_stream = N * screen_lanes;
+    const __m256 c = _mm256_loadu_ps(state.holdup);
+    const __m256 k_conc = _mm256_loadu_ps(state.rate_conc);
+    const __m256 k_tails = _mm256_loadu_ps(state.rate_tails);
+    const __m256 one = _mm256_set1_ps(1);
+    const __m256 limit = _mm256_set1_ps(1e-10);
+    const __m256 three_thousand = _mm256_set1_ps(3000);
+    const __m256 floor = _mm256_set1_ps(1e-7);
+
+    for (int i = 0; i < N * screen_lanes; i += screen_lanes)
+    {
+        __m256 fc = _mm256_loadu_ps(&state.flow_conc[i]);
+        __m256 ft = _mm256_loadu_ps(&state.flow_tails[i]);
+
+        // To stop overflow errors
+        __m256 empty = _mm256_cmp_ps(_mm256_div_ps(_mm256_add_ps(fc, ft), three_thousand), limit, _CMP_LT_OQ);
+        fc = _mm256_blendv_ps(fc, floor, empty);
+        ft = _mm256_blendv_ps(ft, floor, empty);
+
+        __m256 tau = _mm256_div_ps(c, _mm256_add_ps(fc, ft));
+        __m256 kt_conc = _mm256_mul_ps(k_conc, tau);
+        __m256 kt_tails = _mm256_mul_ps(k_tails, tau);
+        __m256 R_conc = _mm256_div_ps(kt_conc, _mm256_add_ps(one, kt_conc));
+        __m256 R_tails = _mm256_div_ps(kt_tails, _mm256_add_ps(one, kt_tails));
+
+        _mm256_storeu_ps(&state.stream_conc[i], _mm256_mul_ps(fc, R_conc));
+        _mm256_storeu_ps(&state.stream_tails[i], _mm256_mul_ps(ft, R_tails));
+        _mm256_storeu_ps(&state.stream_conc[tails_stream + i], _mm256_mul_ps(fc, _mm256_sub_ps(one, R_conc)));
+        _mm256_storeu_ps(&state.stream_tails[tails_stream + i], _mm256_mul_ps(ft, _mm256_sub_ps(one, R_tails)));
+        _mm256_storeu_ps(&state.flow_conc_old[i], fc);
+        _mm256_storeu_ps(&state.flow_tails_old[i], ft);
+    }
+}
+
+/**
+ * @brief   Bit mask of the lanes in which some feed rate changed by more than the
+ *          tolerance, eight lanes of floats to a register
+ *
+ * @param   state       Lanes of the sweep
+ * @param   tolerance   Tolerance
+ * @return  int         Bit l is set if lane l has not converged
+ */
+template <int N>
+static int batch_changed(const batch_lanes_state<N, float, screen_lanes> &state, float tolerance)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 tol = _mm256_set1_ps(tolerance);
+    __m256 moved = _mm256_setzero_ps();
+
+    for (int i = 0; i < N * screen_lanes; i += screen_lanes)
+    {
+        __m256 dc = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&state.flow_conc[i]),
+                                                         _mm256_loadu_ps(&state.flow_conc_old[i])));
+        __m256 dt = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&state.flow_tails[i]),
+                                                         _mm256_loadu_ps(&state.flow_tails_old[i])));
+        moved = _mm256_or_ps(moved, _mm256_cmp_ps(dc, tol, _CMP_GT_OQ));
+        moved = _mm256_or_ps(moved, _mm256_cmp_ps(dt, tol, _CMP_GT_OQ));
+    }
+    return _mm256_movemask_ps(moved);
+}
+#endif
+
+/**
+ * @brief   Constructor for a batch from a set of circuit vectors
+ *
+ * @param   chromosomes         circuit vectors
+ * @param   initial_conc        initial feed concentrate
+ * @param   initial_tails       initial feed tailings
+ */
+template <int N>
+CCircuitBatchN<N>::CCircuitBatchN(const std::vector<std::vector<int> > &chromosomes, int initial_conc, int initial_tails)
+{
+    this->count = chromosomes.size();
+    this->initial_conc = initial_conc;
+    this->initial_tails = initial_tails;
+
+    this->chromosomes.reserve(this->count * (2 * N + 1));
+    for (int i = 0; i < this->count; i++)
+        this->chromosomes.insert(this->chromosomes.end(), chromosomes[i].begin(),
+                                 chromosomes[i].begin() + 2 * N + 1);
+}
+
+/**
+ * @brief   Constructor for a batch from count circuit vectors stored back to back in an integer array
+ *
+ * @param   chromosomes         count * (2 * N + 1) genes
+ * @param   count               number of circuits
+ * @param   initial_conc        initial feed concentrate
+ * @param   initial_tails       initial feed tailings
+ */
+template <int N>
+CCircuitBatchN<N>::CCircuitBatchN(const int *chromosomes, int count, int initial_conc, int initial_tails)
+{
+    this->count = count;
+    this->initial_conc = initial_conc;
+    this->initial_tails = initial_tails;
+    this->chromosomes.assign(chromosomes, chromosomes + count * (2 * N + 1));
+}
+
+/**
+ * @brief   Number of circuits in the batch
+ *
+ * @return  int     Number of circuits
+ */
+template <int N>
+int CCircuitBatchN<N>::Size()
+{
+    return this->count;
+}
+
+/**
+ * @brief   Score every circuit in the batch. Every lane performs exactly the arithmetic
+ *          of CCircuitN<N>::Evaluate_Circuit, in the same order, on its own circuit.
+ *
+ * @param   scores              Array of length Size() for the scores
+ * @param   tolerance           Tolerance
+ * @param   max_iterations      Maximum number of iterations
+ */
+template <int N>
+void CCircuitBatchN<N>::Evaluate_Circuits(double *scores, double tolerance, int max_iterations)
+{
+    this->evaluate_lanes<double, batch_lanes>(scores, tolerance, max_iterations);
+}
+
+/**
+ * @brief   Score every circuit in the batch in single precision. Each register holds twice
+ *          the lanes and each sweep moves half the bytes, but a feed rate of a few hundred
+ *          is only good to about 1e-5, so the tolerance must be looser than that for the
+ *          circuits to converge. The scores are estimates, off by up to a few points.
+ *
+ * @param   scores              Array of length Size() for the scores
+ * @param   tolerance           Tolerance, at least 1e-4
+ * @param   max_iterations      Maximum number of iterations
+ */
+template <int N>
+void CCircuitBatchN<N>::Screen_Circuits(double *scores, double tolerance, int max_iterations)
+{
+    this->evaluate_lanes<float, screen_lanes>(scores, tolerance, max_iterations);
+}
+
+/**
+ * @brief   Sweep the circuits Lanes at a time with feed rates of type Real, refilling each
+ *          lane as its circuit converges or runs out of iterations
+ *
+ * @param   scores              Array of length Size() for the scores
+ * @param   tolerance           Tolerance
+ * @param   max_iterations      Maximum number of iterations
+ */
+template <int N>
+template <class Real, int Lanes>
+void CCircuitBatchN<N>::evaluate_lanes(double *scores, double tolerance, int max_iterations)
+{
+    batch_lanes_state<N, Real, Lanes> state;
+    int circuit[Lanes];
+    int iterations[Lanes];
+    int next = 0;
+    int active = 0;
+
+    // topology of the circuit in each lane: the circuit feed of every unit and
+    // the streams flowing into it, in the order Evaluate_Circuit adds them
+    Real feed_conc[N * Lanes];
+    Real feed_tails[N * Lanes];
+    int inflow[Lanes][N][2 * N];
+    int inflow_count[Lanes][N];
+    int conc_num[N * Lanes];
+
+    for (int i = 0; i < N * Lanes; i++)
+    {
+        state.flow_conc[i] = this->initial_conc;
+        state.flow_tails[i] = this->initial_tails;
+        feed_conc[i] = 0;
+        feed_tails[i] = 0;
+        conc_num[i] = N;
+    }
+
+    for (int l = 0; l < Lanes; l++)
+    {
+        circuit[l] = -1;
+        state.holdup[l] = (Real)(V * phi * rho);
+        state.rate_conc[l] = (Real)K_conc;
+        state.rate_tails[l] = (Real)K_tails;
+        for (int d = 0; d < N; d++)
+            inflow_count[l][d] = 0;
+    }
+
+    while (true)
+    {
+        // load the next circuits into idle lanes
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (circuit[l] >= 0 || next >= this->count)
+                continue;
+
+            const int *chromosome = &this->chromosomes[next * (2 * N + 1)];
+
+            // a feed straight to an outlet never converges in Evaluate_Circuit either
+            if (chromosome[0] < 0 || chromosome[0] >= N || max_iterations <= 0)
+            {
+                scores[next++] = -50000;
+                l--;
+                continue;
+            }
+
+            circuit[l] = next++;
+            iterations[l] = 0;
+            for (int d = 0; d < N; d++)
+            {
+                inflow_count[l][d] = 0;
+                feed_conc[d * Lanes + l] = d == chromosome[0] ? this->initial_conc : 0;
+                feed_tails[d * Lanes + l] = d == chromosome[0] ? this->initial_tails : 0;
+                state.flow_conc[d * Lanes + l] = this->initial_conc;
+                state.flow_tails[d * Lanes + l] = this->initial_tails;
+            }
+            for (int n = 0; n < N; n++)
+            {
+                int conc = chromosome[n * 2 + 1];
+                int tails = chromosome[n * 2 + 2];
+
+                conc_num[n * Lanes + l] = conc;
+                if (conc < N)
+                    inflow[l][conc][inflow_count[l][conc]++] = n * Lanes + l;
+                if (tails < N)
+                    inflow[l][tails][inflow_count[l][tails]++] = (N + n) * Lanes + l;
+            }
+            active++;
+        }
+
+        if (active == 0)
+            break;
+
+        batch_set_values(state);
+
+        // gather the feed of every unit from the circuit feed and its inflowing streams
+        for (int l = 0; l < Lanes; l++)
+        {
+            for (int d = 0; d < N; d++)
+            {
+                Real fc = feed_conc[d * Lanes + l];
+                Real ft = feed_tails[d * Lanes + l];
+
+                for (int k = 0; k < inflow_count[l][d]; k++)
+                {
+                    fc += state.stream_conc[inflow[l][d][k]];
+                    ft += state.stream_tails[inflow[l][d][k]];
+                }
+                state.flow_conc[d * Lanes + l] = fc;
+                state.flow_tails[d * Lanes + l] = ft;
+            }
+        }
+
+        int changed = batch_changed(state, (Real)tolerance);
+
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (circuit[l] < 0)
+                continue;
+
+            iterations[l]++;
+            if (changed & (1 << l))
+            {
+                if (iterations[l] < max_iterations)
+                    continue;
+                scores[circuit[l]] = -50000;
+            }
+            else
+            {
+                // score the lane from the streams of this sweep, as Evaluate_Circuit does
+                double performance = 0;
+                for (int n = 0; n < N; n++)
+                {
+                    int i = n * Lanes + l;
+                    if (conc_num[i] > N - 1)
+                        performance += state.stream_conc[i] * 100 - state.stream_tails[i] * 500;
+                }
+                scores[circuit[l]] = performance;
+            }
+
+            circuit[l] = -1;
+            active--;
+        }
+    }
+}
+
+/**
+ * @brief   Score every circuit in the batch under every scenario. The topology of a circuit
+ *          is decoded once and its scenarios are swept batch_lanes at a time, one to a lane,
+ *          so every lane gathers its feeds through the same links. A lane is refilled with
+ *          the next scenario as soon as its own converges or runs out of iterations. With
+ *          a default scenario a lane performs the arithmetic of Evaluate_Circuits.
+ *
+ * @param   scenarios           Scenarios to score the circuits under
+ * @param   scores              Array of length Size() * scenarios.size(), the score of circuit
+ *                              c under scenario s at c * scenarios.size() + s
+ * @param   tolerance           Tolerance
+ * @param   max_iterations      Maximum number of iterations
+ */
+template <int N>
+void CCircuitBatchN<N>::Evaluate_Scenarios(const std::vector<circuit_scenario> &scenarios, double *scores,
+                                           double tolerance, int max_iterations)
+{
+    const int Lanes = batch_lanes;
+    const int count = scenarios.size();
+    batch_lanes_state<N, double, Lanes> state;
+    int scenario[Lanes];
+    int iterations[Lanes];
+    double feed_conc[Lanes];
+    double feed_tails[Lanes];
+
+    // topology of the circuit, shared by every lane
+    int inflow[N][2 * N];
+    int inflow_count[N];
+    int conc_num[N];
+
+    for (int c = 0; c < this->count; c++)
+    {
+        const int *chromosome = &this->chromosomes[c * (2 * N + 1)];
+        double *circuit_scores = &scores[c * count];
+        const int start = chromosome[0];
+
+        // a feed straight to an outlet never converges in Evaluate_Circuit either
+        if (start < 0 || start >= N || max_iterations <= 0)
+        {
+            for (int s = 0; s < count; s++)
+                circuit_scores[s] = -50000;
+            continue;
+        }
+
+        for (int d = 0; d < N; d++)
+            inflow_count[d] = 0;
+        for (int n = 0; n < N; n++)
+        {
+            int conc = chromosome[n * 2 + 1];
+            int tails = chromosome[n * 2 + 2];
+
+            conc_num[n] = conc;
+            if (conc < N)
+                inflow[conc][inflow_count[conc]++] = n;
+            if (tails < N)
+                inflow[tails][inflow_count[tails]++] = N + n;
+        }
+
+        int next = 0;
+        int active = 0;
+
+        for (int l = 0; l < Lanes; l++)
+        {
+            scenario[l] = -1;
+            feed_conc[l] = 0;
+            feed_tails[l] = 0;
+            state.holdup[l] = V * phi * rho;
+            state.rate_conc[l] = K_conc;
+            state.rate_tails[l] = K_tails;
+            for (int d = 0; d < N; d++)
+            {
+                state.flow_conc[d * Lanes + l] = 0;
+                state.flow_tails[d * Lanes + l] = 0;
+            }
+        }
+
+        while (true)
+        {
+            // load the next scenarios into idle lanes
+            for (int l = 0; l < Lanes && next < count; l++)
+            {
+                if (scenario[l] >= 0)
+                    continue;
+
+                const circuit_scenario &conditions = scenarios[next];
+
+                scenario[l] = next++;
+                iterations[l] = 0;
+                feed_conc[l] = conditions.feed_conc;
+                feed_tails[l] = conditions.feed_tails;
+                state.holdup[l] = conditions.volume * conditions.solids * conditions.density;
+                state.rate_conc[l] = conditions.rate_conc;
+                state.rate_tails[l] = conditions.rate_tails;
+                for (int d = 0; d < N; d++)
+                {
+                    state.flow_conc[d * Lanes + l] = conditions.feed_conc;
+                    state.flow_tails[d * Lanes + l] = conditions.feed_tails;
+                }
+                active++;
+            }
+
+            if (active == 0)
+                break;
+
+            batch_set_values(state);
+
+            // gather the feed of every unit from the circuit feed and its inflowing streams
+            for (int d = 0; d < N; d++)
+            {
+                double *fc = &state.flow_conc[d * Lanes];
+                double *ft = &state.flow_tails[d * Lanes];
+
+                for (int l = 0; l < Lanes; l++)
+                {
+                    fc[l] = d == start ? feed_conc[l] : 0;
+                    ft[l] = d == start ? feed_tails[l] : 0;
+                }
+                for (int k = 0; k < inflow_count[d]; k++)
+                {
+                    const double *stream_conc = &state.stream_conc[inflow[d][k] * Lanes];
+                    const double *stream_tails = &state.stream_tails[inflow[d][k] * Lanes];
+
+                    for (int l = 0; l < Lanes; l++)
+                    {
+                        fc[l] += stream_conc[l];
+                        ft[l] += stream_tails[l];
+                    }
+                }
+            }
+
+            int changed = batch_changed(state, tolerance);
+
+            for (int l = 0; l < Lanes; l++)
+            {
+                if (scenario[l] < 0)
+                    continue;
+
+                iterations[l]++;
+                if (changed & (1 << l))
+                {
+                    if (iterations[l] < max_iterations)
+                        continue;
+                    circuit_scores[scenario[l]] = -50000;
+                }
+                else
+                {
+                    // score the lane from the streams of this sweep at the prices of its scenario
+                    const circuit_scenario &conditions = scenarios[scenario[l]];
+                    double performance = 0;
+                    for (int n = 0; n < N; n++)
+                    {
+                        int i = n * Lanes + l;
+                        if (conc_num[n] > N - 1)
+                            performance += state.stream_conc[i] * conditions.conc_price -
+                                           state.stream_tails[i] * conditions.tails_cost;
+                    }
+                    circuit_scores[scenario[l]] = performance;
+                }
+
+                scenario[l] = -1;
+                active--;
+            }
+        }
+    }
+}
+
+#define INSTANTIATE_BATCH(UNITS) template class CCircuitBatchN<UNITS>;
+FOR_EACH_UNIT_COUNT(INSTANTIATE_BATCH)
+#undef INSTANTIATE_BATCH
+
+/**
+ * @brief   Robust fitness of a circuit from its score in every scenario: the weighted mean
+ *          and spread, the extremes, and the mean of the worst tail of the weight, which
+ *          rewards circuits that hold up when the ore or the kinetics turn against them.
+ *
+ * @param   scores              Score of the circuit under every scenario
+ * @param   scenarios           Scenarios, for their weights
+ * @param   tail                Fraction of the total weight averaged in tail_mean, from
+ *                              the lowest score up. At most 0 gives the worst score.
+ * @return  scenario_statistics Statistics of the scores, all zero without scenarios
+ */
+scenario_statistics Scenario_Statistics(const double *scores, const std::vector<circuit_scenario> &scenarios,
+                                        double tail)
+{
+    scenario_statistics statistics;
+    const int count = scenarios.size();
+
+    if (count == 0)
+        return statistics;
+
+    double total_weight = 0;
+    double weighted_sum = 0;
+    std::vector<int> order(count);
+
+    statistics.worst = scores[0];
+    statistics.best = scores[0];
+    for (int s = 0; s < count; s++)
+    {
+        order[s] = s;
+        total_weight += scenarios[s].weight;
+        weighted_sum += scenarios[s].weight * scores[s];
+        statistics.worst = std::min(statistics.worst, scores[s]);
+        statistics.best = std::max(statistics.best, scores[s]);
+        if (scores[s] == -50000)
+            statistics.failures++;
+    }
+
+    if (total_weight <= 0)
+        return statistics;
+
+    statistics.mean = weighted_sum / total_weight;
+
+    double variance = 0;
+    for (int s = 0; s < count; s++)
+        variance += scenarios[s].weight * (scores[s] - statistics.mean) * (scores[s] - statistics.mean);
+    statistics.std_dev = std::sqrt(variance / total_weight);
+
+    // average the lowest scores until they carry the tail of the weight, the last one in part
+    if (tail <= 0)
+    {
+        statistics.tail_mean = statistics.worst;
+        return statistics;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [scores](int a, int b) { return scores[a] < scores[b]; });
+
+    double wanted = std::min(tail, 1.0) * total_weight;
+    double taken = 0;
+    double tail_sum = 0;
+    for (int k = 0; k < count && taken < wanted; k++)
+    {
+        double weight = std::min(scenarios[order[k]].weight, wanted - taken);
+        taken += weight;
+        tail_sum += weight * scores[order[k]];
+    }
+    statistics.tail_mean = taken > 0 ? tail_sum / taken : statistics.worst;
+
+    return statistics;
+}
@@ -0,0 +1,369 @@
+/**
+ * @file    CFitnessCache.cpp
+ * @author  Galena Group
+ * @brief   Memoization of fitness values so known chromosomes are not re-evaluated
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include "../includes/CFitnessCache.h"
+
+/**
+ * @brief   Hash a chromosome key
+ *
+ * @param   key             Packed chromosome
+ * @return  std::size_t     Hash value
+ */
+template <int N>
+std::size_t circuit_key_hash<N>::operator()(const circuit_key<N> &key) const
+{
+    std::size_t hash = 14695981039346656037ULL;
+
+    for (std::size_t i = 0; i < key.size(); i++)
+    {
+        hash ^= key[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief   Constructor for a cache holding at most capacity entries
+ *
+ * @param   capacity        Maximum number of entries, at least 1
+ */
+template <int N>
+CFitnessCacheN<N>::CFitnessCacheN(std::size_t capacity)
+{
+    std::size_t bucket_num = 1;
+
+    this->capacity = capacity > 0 ? capacity : 1;
+    while (bucket_num < this->capacity)
+        bucket_num *= 2;
+    this->buckets.assign(bucket_num, -1);
+}
+
+/**
+ * @brief   Bucket of a key
+ *
+ * @param   key         Packed chromosome
+ * @return  int         Index into buckets
+ */
+template <int N>
+int CFitnessCacheN<N>::bucket(const circuit_key<N> &key) const
+{
+    return circuit_key_hash<N>()(key) & (this->buckets.size() - 1);
+}
+
+/**
+ * @brief   Slot holding a key
+ *
+ * @param   key         Packed chromosome
+ * @return  int         Slot number, -1 if the key is not stored
+ */
+template <int N>
+int CFitnessCacheN<N>::find_slot(const circuit_key<N> &key) const
+{
+    int s = this->buckets[this->bucket(key)];
+
+    while (s >= 0 && this->slots[s].key != key)
+        s = this->slots[s].chain;
+    return s;
+}
+
+/**
+ * @brief   Take a slot out of the list ordered by use
+ *
+ * @param   s       Slot number
+ */
+template <int N>
+void CFitnessCacheN<N>::unlink(int s)
+{
+    slot &entry = this->slots[s];
+
+    if (entry.newer >= 0)
+        this->slots[entry.newer].older = entry.older;
+    else
+        this->newest = entry.older;
+
+    if (entry.older >= 0)
+        this->slots[entry.older].newer = entry.newer;
+    else
+        this->oldest = entry.newer;
+}
+
+/**
+ * @brief   Put a slot at the most recently used end of the list
+ *
+ * @param   s       Slot number, not in the list
+ */
+template <int N>
+void CFitnessCacheN<N>::link_newest(int s)
+{
+    this->slots[s].newer = -1;
+    this->slots[s].older = this->newest;
+    if (this->newest >= 0)
+        this->slots[this->newest].newer = s;
+    else
+        this->oldest = s;
+    this->newest = s;
+}
+
+/**
+ * @brief   Pack a chromosome into a cache key
+ *
+ * @param   chromosome          Circuit vector stored as an integer array
+ * @return  circuit_key<N>      Packed chromosome
+ */
+template <int N>
+circuit_key<N> CFitnessCacheN<N>::Make_Key(const int *chromosome)
+{
+    circuit_key<N> key;
+
+    for (int i = 0; i < 2 * N + 1; i++)
+        key[i] = (unsigned char)chromosome[i];
+    return key;
+}
+
+/**
+ * @brief   Look up the fitness value of a chromosome
+ *
+ * @param   chromosome      Circuit vector stored as an integer array
+ * @param   score           Stored fitness value, set only if found
+ * @return  bool            true if the chromosome is in the cache
+ */
+template <int N>
+bool CFitnessCacheN<N>::Find(const int *chromosome, double &score)
+{
+    return this->Find(Make_Key(chromosome), score);
+}
+
+/**
+ * @brief   Look up the fitness value stored under a key
+ *
+ * @param   key             Packed chromosome, e.g. from CCircuit::Canonical_Key
+ * @param   score           Stored fitness value, set only if found
+ * @return  bool            true if the key is in the cache
+ */
+template <int N>
+bool CFitnessCacheN<N>::Find(const circuit_key<N> &key, double &score)
+{
+    int s = this->find_slot(key);
+
+    if (s < 0)
+    {
+        this->misses++;
+        return false;
+    }
+
+    // move the entry to the front so it is evicted last
+    this->unlink(s);
+    this->link_newest(s);
+    score = this->slots[s].entry.score;
+    this->hits++;
+    return true;
+}
+
+/**
+ * @brief   Store the fitness value of a chromosome
+ *
+ * @param   chromosome      Circuit vector stored as an integer array
+ * @param   score           Fitness value
+ */
+template <int N>
+void CFitnessCacheN<N>::Insert(const int *chromosome, double score)
+{
+    this->Insert(Make_Key(chromosome), score);
+}
+
+/**
+ * @brief   Store the fitness value under a key
+ *
+ * @param   key             Packed chromosome, e.g. from CCircuit::Canonical_Key
+ * @param   score           Fitness value
+ */
+template <int N>
+void CFitnessCacheN<N>::Insert(const circuit_key<N> &key, double score)
+{
+    this->Insert(key, score, NULL);
+}
+
+/**
+ * @brief   Store the fitness value and steady-state feed rates under a key
+ *
+ * @param   key             Packed chromosome, e.g. from CCircuit::Canonical_Key
+ * @param   score           Fitness value
+ * @param   flows           Feed rates from CCircuitN<N>::Get_Flows for the circuit of the key,
+ *                          or NULL to keep whatever feed rates are stored
+ */
+template <int N>
+void CFitnessCacheN<N>::Insert(const circuit_key<N> &key, double score, const double *flows)
+{
+    int s = this->find_slot(key);
+
+    if (s < 0)
+    {
+        if (this->slots.size() < this->capacity)
+        {
+            s = this->slots.size();
+            this->slots.emplace_back();
+        }
+        else
+        {
+            // reuse the least recently used slot, unchaining it from its old bucket
+            s = this->oldest;
+            this->unlink(s);
+
+            int *link = &this->buckets[this->bucket(this->slots[s].key)];
+            while (*link != s)
+                link = &this->slots[*link].chain;
+            *link = this->slots[s].chain;
+            this->evictions++;
+        }
+
+        int &head = this->buckets[this->bucket(key)];
+        this->slots[s].key = key;
+        this->slots[s].entry.has_flows = false;
+        this->slots[s].chain = head;
+        head = s;
+    }
+    else
+    {
+        this->unlink(s);
+    }
+    this->link_newest(s);
+
+    fitness_entry<N> *entry = &this->slots[s].entry;
+    entry->score = score;
+    entry->screened = false;
+    if (flows != NULL)
+    {
+        entry->has_flows = true;
+        for (int i = 0; i < 2 * N; i++)
+            entry->flows[i] = (float)flows[i];
+    }
+}
+
+/**
+ * @brief   Store a score estimated by screening. The entry holds no feed rates, and
+ *          Exact is false for it until Insert stores an exact score under the key.
+ *
+ * @param   key             Packed chromosome, e.g. from CCircuit::Canonical_Key
+ * @param   score           Estimated fitness value
+ */
+template <int N>
+void CFitnessCacheN<N>::Insert_Screened(const circuit_key<N> &key, double score)
+{
+    this->Insert(key, score, NULL);
+
+    fitness_entry<N> *entry = &this->slots[this->newest].entry;
+    entry->has_flows = false;
+    entry->screened = true;
+}
+
+/**
+ * @brief   Check whether an exact score is stored under a key, rather than none or one
+ *          estimated by screening. Neither the counters nor the order of eviction change.
+ *
+ * @param   key             Packed chromosome
+ * @return  bool            true if the key is stored with a score that was not screened
+ */
+template <int N>
+bool CFitnessCacheN<N>::Exact(const circuit_key<N> &key) const
+{
+    int s = this->find_slot(key);
+
+    return s >= 0 && !this->slots[s].entry.screened;
+}
+
+/**
+ * @brief   Steady-state feed rates stored under a key. Neither the counters nor the
+ *          order of eviction change.
+ *
+ * @param   key             Packed chromosome
+ * @param   flows           Array of length 2 * N, set only if found
+ * @return  bool            true if feed rates are stored under the key
+ */
+template <int N>
+bool CFitnessCacheN<N>::Find_Flows(const circuit_key<N> &key, double *flows)
+{
+    int s = this->find_slot(key);
+
+    if (s < 0 || !this->slots[s].entry.has_flows)
+        return false;
+
+    for (int i = 0; i < 2 * N; i++)
+        flows[i] = this->slots[s].entry.flows[i];
+    return true;
+}
+
+/**
+ * @brief   Remove every entry and reset the counters
+ */
+template <int N>
+void CFitnessCacheN<N>::Clear()
+{
+    this->slots.clear();
+    std::fill(this->buckets.begin(), this->buckets.end(), -1);
+    this->newest = -1;
+    this->oldest = -1;
+    this->hits = 0;
+    this->misses = 0;
+    this->evictions = 0;
+}
+
+/**
+ * @brief   Copy out every entry, least recently used first, so that inserting them again
+ *          in that order with Insert_Entry rebuilds a cache that evicts in the same order
+ *
+ * @param   keys            Receives the key of every entry
+ * @param   entries         Receives what is stored under each key
+ */
+template <int N>
+void CFitnessCacheN<N>::Get_Entries(std::vector<circuit_key<N> > &keys, std::vector<fitness_entry<N> > &entries) const
+{
+    keys.clear();
+    entries.clear();
+    for (int s = this->oldest; s >= 0; s = this->slots[s].newer)
+    {
+        keys.push_back(this->slots[s].key);
+        entries.push_back(this->slots[s].entry);
+    }
+}
+
+/**
+ * @brief   Store an entry as Get_Entries copied it out, as the most recently used. The
+ *          counters do not change.
+ *
+ * @param   key         Packed chromosome
+ * @param   entry       Fitness value and feed rates, stored exactly
+ */
+template <int N>
+void CFitnessCacheN<N>::Insert_Entry(const circuit_key<N> &key, const fitness_entry<N> &entry)
+{
+    unsigned long evictions = this->evictions;
+
+    this->Insert(key, entry.score);
+    this->slots[this->newest].entry = entry;
+    this->evictions = evictions;
+}
+
+/**
+ * @brief   Number of entries currently stored
+ *
+ * @return  std::size_t     Number of entries
+ */
+template <int N>
+std::size_t CFitnessCacheN<N>::Size() const
+{
+    return this->slots.size();
+}
+
+#define INSTANTIATE_CACHE(UNITS) \
+    template struct circuit_key_hash<UNITS>; \
+    template class CFitnessCacheN<UNITS>;
+FOR_EACH_UNIT_COUNT(INSTANTIATE_CACHE)
+#undef INSTANTIATE_CACHE
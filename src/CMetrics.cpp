@@ -0,0 +1,335 @@
+/**
+ * @file    CMetrics.cpp
+ * @author  Galena Group
+ * @brief   Phase timers and counters of a run of the genetic algorithm
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../includes/CMetrics.h"
+
+using namespace std;
+
+/** Names of the phases in the output, in the order of Metrics_Phase */
+static const char *phase_names[phase_count] = {"other",     "init",     "fitness",  "elite",
+                                               "selection", "breeding", "validity", "evaluation"};
+
+/**
+ * @brief   One value of the output
+ */
+struct metrics_row
+{
+    /** Group of the value: a JSON object, the first CSV column */
+    const char *section;
+    /** Name of the value within its group */
+    string name;
+    /** Value */
+    double value;
+};
+
+/**
+ * @brief   Seconds between two points in time
+ *
+ * @param   from        Earlier point
+ * @param   to          Later point
+ * @return  double      Seconds
+ */
+static double seconds_between(chrono::steady_clock::time_point from, chrono::steady_clock::time_point to)
+{
+    return chrono::duration<double>(to - from).count();
+}
+
+/**
+ * @brief   Rows for what became of some candidates
+ *
+ * @param   rows            Receives the rows
+ * @param   section         Group of the rows
+ * @param   candidates      Counts of the candidates
+ */
+static void candidate_rows(vector<metrics_row> &rows, const char *section, const candidate_metrics &candidates)
+{
+    double drawn = max(1UL, candidates.drawn);
+
+    rows.push_back({section, "drawn", (double)candidates.drawn});
+    rows.push_back({section, "repaired", (double)candidates.repaired});
+    rows.push_back({section, "invalid", (double)candidates.invalid});
+    rows.push_back({section, "rejected", (double)candidates.rejected});
+    rows.push_back({section, "accepted", (double)candidates.accepted});
+    rows.push_back({section, "rejection_rate", (candidates.invalid + candidates.rejected) / drawn});
+}
+
+/**
+ * @brief   Every value of the output, in order
+ *
+ * @param   metrics     Metrics to write
+ * @return  vector      Rows
+ */
+static vector<metrics_row> metrics_rows(const CMetrics &metrics)
+{
+    vector<metrics_row> rows;
+    double evaluations = max(1UL, metrics.evaluations);
+    double generations = max(1UL, metrics.generations);
+    double generation_seconds = metrics.generation_seconds > 0 ? metrics.generation_seconds : 1;
+
+    rows.push_back({"phase_seconds", "total", metrics.Elapsed()});
+    for (int p = 0; p < phase_count; p++)
+        rows.push_back({"phase_seconds", phase_names[p], metrics.Seconds((Metrics_Phase)p)});
+
+    rows.push_back({"solver", "evaluations", (double)metrics.evaluations});
+    rows.push_back({"solver", "sweeps", (double)metrics.sweeps});
+    rows.push_back({"solver", "sweeps_per_evaluation", metrics.sweeps / evaluations});
+    rows.push_back({"solver", "failures", (double)metrics.failures});
+    rows.push_back({"solver", "failure_rate", metrics.failures / evaluations});
+    rows.push_back({"solver", "clamps", (double)metrics.clamps});
+    rows.push_back({"solver", "aborted", (double)metrics.aborted});
+
+    rows.push_back({"generations", "count", (double)metrics.generations});
+    rows.push_back({"generations", "seconds", metrics.generation_seconds});
+    rows.push_back({"generations", "per_second", metrics.generations / generation_seconds});
+    rows.push_back({"generations", "evaluations_per_second", metrics.evaluations / max(metrics.Elapsed(), 1e-9)});
+    rows.push_back({"generations", "mean_seconds", metrics.generation_seconds / generations});
+    rows.push_back({"generations", "fastest_seconds", metrics.fastest_generation});
+    rows.push_back({"generations", "slowest_seconds", metrics.slowest_generation});
+
+    candidate_rows(rows, "initial", metrics.initial);
+    candidate_rows(rows, "children", metrics.children);
+    return rows;
+}
+
+/**
+ * @brief   Constructor for metrics with every counter 0
+ */
+CMetrics::CMetrics()
+{
+    std::fill(this->seconds, this->seconds + phase_count, 0.0);
+}
+
+/**
+ * @brief   Reset every counter and start timing in PHASE_OTHER
+ */
+void CMetrics::Start()
+{
+    *this = CMetrics();
+    this->running = true;
+    this->switched = chrono::steady_clock::now();
+    this->generation_began = this->switched;
+}
+
+/**
+ * @brief   Charge the time since the last switch to the current phase and switch to phase.
+ *          Phases do not nest: a function that enters a phase of its own enters the phase it
+ *          was called in again, which Enter returns, before it returns.
+ *
+ * @param   phase               Phase to switch to
+ * @return  Metrics_Phase       Phase left
+ */
+Metrics_Phase CMetrics::Enter(Metrics_Phase phase)
+{
+    Metrics_Phase left = this->current;
+
+    if (this->running)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        this->seconds[left] += seconds_between(this->switched, now);
+        this->switched = now;
+    }
+    this->current = phase;
+    return left;
+}
+
+/**
+ * @brief   Count one evaluation of a circuit. The evaluations of a round run on every
+ *          thread, so the counters are updated atomically.
+ *
+ * @param   sweeps          CCircuit::Last_Iterations() after the evaluation
+ * @param   converged       False if the evaluation scored -50000
+ * @param   clamps          CCircuit::Last_Clamps() after the evaluation
+ * @param   aborted         CCircuit::Aborted() after the evaluation
+ */
+void CMetrics::Count_Evaluation(int sweeps, bool converged, int clamps, bool aborted)
+{
+  #ifdef _OPENMP
+    #pragma omp atomic
+    this->evaluations++;
+    #pragma omp atomic
+    this->sweeps += sweeps;
+    #pragma omp atomic
+    this->failures += !converged;
+    #pragma omp atomic
+    this->clamps += clamps;
+    #pragma omp atomic
+    this->aborted += aborted;
+  #else
+    this->evaluations++;
+    this->sweeps += sweeps;
+    this->failures += !converged;
+    this->clamps += clamps;
+    this->aborted += aborted;
+  #endif
+}
+
+/**
+ * @brief   Start timing a generation
+ */
+void CMetrics::Begin_Generation()
+{
+    this->generation_began = chrono::steady_clock::now();
+}
+
+/**
+ * @brief   Count a generation and its wall time since Begin_Generation
+ */
+void CMetrics::End_Generation()
+{
+    double taken = seconds_between(this->generation_began, chrono::steady_clock::now());
+
+    this->fastest_generation = this->generations == 0 ? taken : min(this->fastest_generation, taken);
+    this->slowest_generation = max(this->slowest_generation, taken);
+    this->generation_seconds += taken;
+    this->generations++;
+}
+
+/**
+ * @brief   Add the counters and times of another run, as for the islands of the island
+ *          model. Islands run side by side, so the phase times add up to more than the
+ *          wall time of the run.
+ *
+ * @param   other       Metrics to add
+ */
+void CMetrics::Add(const CMetrics &other)
+{
+    for (int p = 0; p < phase_count; p++)
+        this->seconds[p] += other.Seconds((Metrics_Phase)p);
+
+    this->evaluations += other.evaluations;
+    this->sweeps += other.sweeps;
+    this->failures += other.failures;
+    this->clamps += other.clamps;
+    this->aborted += other.aborted;
+
+    this->fastest_generation = this->generations == 0 ? other.fastest_generation
+                               : other.generations == 0 ? this->fastest_generation
+                                                         : min(this->fastest_generation, other.fastest_generation);
+    this->slowest_generation = max(this->slowest_generation, other.slowest_generation);
+    this->generation_seconds += other.generation_seconds;
+    this->generations += other.generations;
+
+    candidate_metrics *mine[] = {&this->initial, &this->children};
+    const candidate_metrics *theirs[] = {&other.initial, &other.children};
+    for (int i = 0; i < 2; i++)
+    {
+        mine[i]->drawn += theirs[i]->drawn;
+        mine[i]->repaired += theirs[i]->repaired;
+        mine[i]->invalid += theirs[i]->invalid;
+        mine[i]->rejected += theirs[i]->rejected;
+        mine[i]->accepted += theirs[i]->accepted;
+    }
+}
+
+/**
+ * @brief   Stop timing, charging the time since the last switch to the current phase
+ */
+void CMetrics::Stop()
+{
+    this->Enter(this->current);
+    this->running = false;
+}
+
+/**
+ * @brief   Seconds spent in a phase so far, including the time since the last switch if
+ *          the run is in it, so the metrics can be read while the run goes on
+ *
+ * @param   phase       Phase
+ * @return  double      Seconds
+ */
+double CMetrics::Seconds(Metrics_Phase phase) const
+{
+    double charged = this->seconds[phase];
+
+    if (this->running && phase == this->current)
+        charged += seconds_between(this->switched, chrono::steady_clock::now());
+    return charged;
+}
+
+/**
+ * @brief   Seconds spent in all phases so far, the time since Start for a single run
+ *
+ * @return  double      Seconds
+ */
+double CMetrics::Elapsed() const
+{
+    double total = 0;
+
+    for (int p = 0; p < phase_count; p++)
+        total += this->Seconds((Metrics_Phase)p);
+    return total;
+}
+
+/**
+ * @brief   Write the metrics as a JSON object with one member per group of values
+ *
+ * @param   out         Stream to write to
+ */
+void CMetrics::Write_JSON(std::ostream &out) const
+{
+    vector<metrics_row> rows = metrics_rows(*this);
+    streamsize precision = out.precision(12);
+
+    out << "{";
+    for (size_t r = 0; r < rows.size(); r++)
+    {
+        bool first_of_section = r == 0 || strcmp(rows[r].section, rows[r - 1].section) != 0;
+        bool last_of_section = r + 1 == rows.size() || strcmp(rows[r].section, rows[r + 1].section) != 0;
+
+        if (first_of_section)
+            out << (r == 0 ? "" : ",") << "\n  \"" << rows[r].section << "\": {";
+        out << (first_of_section ? "" : ", ") << "\"" << rows[r].name << "\": " << rows[r].value;
+        if (last_of_section)
+            out << "}";
+    }
+    out << "\n}" << endl;
+    out.precision(precision);
+}
+
+/**
+ * @brief   Write the metrics as CSV with a header row, then one row per value: group, name, value
+ *
+ * @param   out         Stream to write to
+ */
+void CMetrics::Write_CSV(std::ostream &out) const
+{
+    vector<metrics_row> rows = metrics_rows(*this);
+    streamsize precision = out.precision(12);
+
+    out << "section,name,value" << endl;
+    for (size_t r = 0; r < rows.size(); r++)
+        out << rows[r].section << "," << rows[r].name << "," << rows[r].value << endl;
+    out.precision(precision);
+}
+
+/**
+ * @brief   Write the metrics to a file, as CSV if its name ends in .csv and as JSON otherwise
+ *
+ * @param   path        File to write, replacing any file of that name
+ * @return  bool        true if the file was written
+ */
+bool CMetrics::Write(const char *path) const
+{
+    ofstream file(path);
+    string name(path);
+
+    if (!file)
+        return false;
+    if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".csv") == 0)
+        this->Write_CSV(file);
+    else
+        this->Write_JSON(file);
+    return (bool)file;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file    CPopulation.cpp
+ * @author  Galena Group
+ * @brief   Packed storage of a population of circuit vectors
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include "../includes/CPopulation.h"
+
+/**
+ * @brief   Constructor for a population of size chromosomes, all genes 0
+ *
+ * @param   size        Number of chromosomes
+ */
+template <int N>
+CPopulationN<N>::CPopulationN(int size)
+{
+    this->size = 0;
+    this->Resize(size);
+}
+
+/**
+ * @brief   Number of chromosomes
+ *
+ * @return  int     Number of chromosomes
+ */
+template <int N>
+int CPopulationN<N>::Size() const
+{
+    return this->size;
+}
+
+/**
+ * @brief   Change the number of chromosomes, keeping the first ones. Shrinking keeps the
+ *          buffer, so growing back to a size already reached does not allocate.
+ *
+ * @param   size        Number of chromosomes
+ */
+template <int N>
+void CPopulationN<N>::Resize(int size)
+{
+    this->size = size;
+    this->genes.resize((std::size_t)size * length);
+}
+
+/**
+ * @brief   Packed genes of chromosome i
+ *
+ * @param   i                   Chromosome number
+ * @return  unsigned char*      length genes
+ */
+template <int N>
+unsigned char *CPopulationN<N>::operator[](int i)
+{
+    return &this->genes[(std::size_t)i * length];
+}
+
+/**
+ * @brief   Packed genes of chromosome i
+ *
+ * @param   i                       Chromosome number
+ * @return  const unsigned char*    length genes
+ */
+template <int N>
+const unsigned char *CPopulationN<N>::operator[](int i) const
+{
+    return &this->genes[(std::size_t)i * length];
+}
+
+/**
+ * @brief   Unpack chromosome i into a circuit vector
+ *
+ * @param   i               Chromosome number
+ * @param   chromosome      Array of length genes to fill
+ */
+template <int N>
+void CPopulationN<N>::Get(int i, int *chromosome) const
+{
+    std::copy((*this)[i], (*this)[i] + length, chromosome);
+}
+
+/**
+ * @brief   Overwrite chromosome i with a circuit vector
+ *
+ * @param   i               Chromosome number
+ * @param   chromosome      length genes, each 0 to N + 1
+ */
+template <int N>
+void CPopulationN<N>::Set(int i, const int *chromosome)
+{
+    std::copy(chromosome, chromosome + length, (*this)[i]);
+}
+
+/**
+ * @brief   Overwrite chromosome i with packed genes
+ *
+ * @param   i               Chromosome number
+ * @param   chromosome      length packed genes, for example a chromosome of another population
+ */
+template <int N>
+void CPopulationN<N>::Set(int i, const unsigned char *chromosome)
+{
+    std::copy(chromosome, chromosome + length, (*this)[i]);
+}
+
+/**
+ * @brief   Exchange the chromosomes of two populations. Only the buffers change hands.
+ *
+ * @param   other       Population to swap with
+ */
+template <int N>
+void CPopulationN<N>::Swap(CPopulationN<N> &other)
+{
+    std::swap(this->size, other.size);
+    this->genes.swap(other.genes);
+}
+
+/**
+ * @brief   Bytes of chromosome storage
+ *
+ * @return  std::size_t     Bytes allocated for genes
+ */
+template <int N>
+std::size_t CPopulationN<N>::Bytes() const
+{
+    return this->genes.capacity();
+}
+
+#define INSTANTIATE_POPULATION(UNITS) template class CPopulationN<UNITS>;
+FOR_EACH_UNIT_COUNT(INSTANTIATE_POPULATION)
+#undef INSTANTIATE_POPULATION
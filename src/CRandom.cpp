@@ -0,0 +1,71 @@
+/**
+ * @file    CRandom.cpp
+ * @author  Galena Group
+ * @brief   Counter-based random numbers for reproducible parallel runs
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include "../includes/CRandom.h"
+
+/** Weyl sequence increment of SplitMix64 */
+static const std::uint64_t golden_gamma = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * @brief   SplitMix64 finalizer, a bijective mix of all 64 bits
+ *
+ * @param   x               Value to mix
+ * @return  std::uint64_t   Mixed value
+ */
+static std::uint64_t mix64(std::uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief   Constructor for the stream of one slot in one generation
+ *
+ * @param   seed            Seed of the whole run
+ * @param   generation      Generation number
+ * @param   slot            Slot within the generation
+ */
+CRandom::CRandom(std::uint64_t seed, std::uint64_t generation, std::uint64_t slot)
+{
+    this->key = mix64(mix64(mix64(seed) + generation * golden_gamma) + slot * golden_gamma);
+}
+
+/**
+ * @brief   Next 64 random bits
+ *
+ * @return  std::uint64_t   Random bits
+ */
+std::uint64_t CRandom::Next()
+{
+    this->counter++;
+    return mix64(this->key + this->counter * golden_gamma);
+}
+
+/**
+ * @brief   Random integer in [0, n) by multiply-shift, n must be positive
+ *
+ * @param   n       Number of possible values
+ * @return  int     Random integer
+ */
+int CRandom::Uniform_Int(int n)
+{
+    return (int)(((this->Next() >> 32) * (std::uint64_t)n) >> 32);
+}
+
+/**
+ * @brief   Random double in [0, 1) with 53 random bits
+ *
+ * @return  double  Random double
+ */
+double CRandom::Uniform()
+{
+    return (this->Next() >> 11) * (1.0 / 9007199254740992.0);
+}
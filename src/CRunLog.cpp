@@ -0,0 +1,415 @@
+/**
+ * @file    CRunLog.cpp
+ * @author  Galena Group
+ * @brief   Binary log of the best circuit of every generation
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include <cstring>
+#include "../includes/CRunLog.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+/** Magic bytes at the start of a run log */
+static const char run_log_magic[8] = {'G', 'A', 'R', 'U', 'N', 'L', 'O', 'G'};
+
+/**
+ * @brief   Bytes per record of a log of circuits of unit_count units: the fields of
+ *          run_log_record up to genes, then the genes, padded to a multiple of 8 bytes
+ *
+ * @param   unit_count      Units in the logged circuits
+ * @return  int             Bytes per record
+ */
+int Run_Log_Record_Size(int unit_count)
+{
+    return offsetof(run_log_record, genes) + (2 * unit_count + 1 + 7) / 8 * 8;
+}
+
+/**
+ * @brief   Constructor for a log that is not open, buffering up to capacity records once opened
+ *
+ * @param   capacity        Records the ring buffer holds
+ */
+CRunLog::CRunLog(int capacity)
+{
+    this->capacity = std::max(1, capacity);
+}
+
+/**
+ * @brief   Destructor, closing the log
+ */
+CRunLog::~CRunLog()
+{
+    this->Close();
+}
+
+/**
+ * @brief   Create the file, write the header and start the writer thread. A log that is
+ *          already open is closed first.
+ *
+ * @param   path            File to create, replacing any file of that name
+ * @param   unit_count      Units in the logged circuits, min_units to max_units
+ * @param   seed            Seed of the run
+ * @param   keep            For a resumed run, the records of generations 1 to keep are kept
+ *                          from the log of the same run at path, if it holds them; 0 to
+ *                          start a new log
+ * @return  bool            true if the file was created
+ */
+bool CRunLog::Open(const char *path, int unit_count, unsigned long seed, int keep)
+{
+    this->Close();
+    if (unit_count < min_units || unit_count > max_units)
+        return false;
+
+    // a resumed run rewrites the generations after its checkpoint, so only those before are kept
+    std::vector<unsigned char> kept;
+    if (keep > 0)
+    {
+        CRunLogReader old_log;
+        if (old_log.Open(path) && old_log.Header().unit_count == (std::uint32_t)unit_count &&
+            old_log.Header().seed == seed)
+        {
+            long records = std::min((long)keep, old_log.Size());
+            while (records > 0 && old_log.Generation(records - 1) > keep)
+                records--;
+            kept.resize(records * Run_Log_Record_Size(unit_count));
+            for (long i = 0; i < records; i++)
+            {
+                run_log_record record = old_log[i];
+                std::memcpy(&kept[i * Run_Log_Record_Size(unit_count)], &record, Run_Log_Record_Size(unit_count));
+            }
+        }
+    }
+
+    this->file = std::fopen(path, "wb");
+    if (this->file == NULL)
+        return false;
+
+    run_log_header header;
+    std::memcpy(header.magic, run_log_magic, sizeof(header.magic));
+    header.version = run_log_version;
+    header.record_size = Run_Log_Record_Size(unit_count);
+    header.unit_count = unit_count;
+    header.reserved = 0;
+    header.seed = seed;
+    if (std::fwrite(&header, sizeof(header), 1, this->file) != 1 ||
+        std::fwrite(kept.data(), 1, kept.size(), this->file) != kept.size())
+    {
+        std::fclose(this->file);
+        this->file = NULL;
+        return false;
+    }
+
+    this->unit_count = unit_count;
+    this->record_size = header.record_size;
+    this->ring.assign(this->capacity * this->record_size, 0);
+    this->appended = 0;
+    this->written = 0;
+    this->closing = false;
+    this->failed = false;
+    this->writer = std::thread(&CRunLog::write_records, this);
+    return true;
+}
+
+/**
+ * @brief   Queue the record of a generation. Only waits if the writer thread is a whole
+ *          ring behind. Does nothing if the log is not open.
+ *
+ * @param   generation      Generation, from 1
+ * @param   best_score      Score of the best circuit so far
+ * @param   elapsed         Seconds since the initial population was drawn
+ * @param   stalled         Generations since the best circuit last improved
+ * @param   genes           Packed genes of the best circuit, 2 * unit count + 1 of them
+ */
+void CRunLog::Append(int generation, double best_score, double elapsed, int stalled, const unsigned char *genes)
+{
+    if (this->file == NULL)
+        return;
+
+    run_log_record record;
+    record.generation = generation;
+    record.stalled = stalled;
+    record.best_score = best_score;
+    record.elapsed = elapsed;
+    std::memset(record.genes, 0, sizeof(record.genes));
+    std::memcpy(record.genes, genes, 2 * this->unit_count + 1);
+
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->drained.wait(guard, [this] { return this->appended - this->written < this->capacity; });
+
+    // the writer only reads slots below appended, so this one is ours until it is queued
+    std::memcpy(&this->ring[(this->appended % this->capacity) * this->record_size], &record, this->record_size);
+    this->appended++;
+
+    guard.unlock();
+    this->queued.notify_one();
+}
+
+/**
+ * @brief   Write every queued record, stop the writer thread and close the file. Does
+ *          nothing if the log is not open.
+ *
+ * @return  bool            true if every record was written
+ */
+bool CRunLog::Close()
+{
+    if (this->file == NULL)
+        return true;
+
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->closing = true;
+    }
+    this->queued.notify_one();
+    this->writer.join();
+
+    bool ok = !this->failed;
+    ok = std::fclose(this->file) == 0 && ok;
+    this->file = NULL;
+    return ok;
+}
+
+/**
+ * @brief   True between a successful Open and Close
+ *
+ * @return  bool            true if the log is open
+ */
+bool CRunLog::Is_Open() const
+{
+    return this->file != NULL;
+}
+
+/**
+ * @brief   Number of records appended since Open
+ *
+ * @return  long            Number of records
+ */
+long CRunLog::Size() const
+{
+    return this->appended;
+}
+
+/**
+ * @brief   Body of the writer thread. Takes every record queued so far, writes it without
+ *          holding the lock, and returns once the log closes with nothing left to write.
+ */
+void CRunLog::write_records()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    while (true)
+    {
+        this->queued.wait(guard, [this] { return this->appended > this->written || this->closing; });
+        long start = this->written;
+        long end = this->appended;
+        if (start == end)
+            break;
+
+        guard.unlock();
+        bool ok = true;
+        // the queued records wrap round the end of the ring at most once
+        while (start < end)
+        {
+            long slot = start % this->capacity;
+            long count = std::min(end - start, this->capacity - slot);
+            ok = ok && std::fwrite(&this->ring[slot * this->record_size], this->record_size, count, this->file) ==
+                           (std::size_t)count;
+            start += count;
+        }
+        guard.lock();
+
+        this->written = end;
+        this->failed = this->failed || !ok;
+        this->drained.notify_all();
+    }
+}
+
+/**
+ * @brief   Constructor for a reader with no log open
+ */
+CRunLogReader::CRunLogReader()
+{
+}
+
+/**
+ * @brief   Destructor, closing the log
+ */
+CRunLogReader::~CRunLogReader()
+{
+    this->Close();
+}
+
+/**
+ * @brief   Map a log and check its header. A log that is already open is closed first.
+ *          A record cut short by a run that did not finish is left out.
+ *
+ * @param   path            Log to read
+ * @return  bool            true if the file is a run log this version can read
+ */
+bool CRunLogReader::Open(const char *path)
+{
+    this->Close();
+
+  #ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER file_size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart >= (LONGLONG)sizeof(run_log_header))
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+        return false;
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == NULL)
+        return false;
+    this->data = (const unsigned char *)view;
+    this->bytes = file_size.QuadPart;
+  #else
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+    struct stat status;
+    void *view = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size >= (off_t)sizeof(run_log_header))
+        view = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (view == MAP_FAILED)
+        return false;
+    this->data = (const unsigned char *)view;
+    this->bytes = status.st_size;
+  #endif
+
+    const run_log_header &header = this->Header();
+    if (std::memcmp(header.magic, run_log_magic, sizeof(header.magic)) != 0 || header.version != run_log_version ||
+        (int)header.unit_count < min_units || (int)header.unit_count > max_units ||
+        (int)header.record_size != Run_Log_Record_Size(header.unit_count))
+    {
+        this->Close();
+        return false;
+    }
+    this->record_size = header.record_size;
+    this->size = (this->bytes - sizeof(run_log_header)) / this->record_size;
+    return true;
+}
+
+/**
+ * @brief   Unmap the log. Does nothing if no log is open.
+ */
+void CRunLogReader::Close()
+{
+    if (this->data == NULL)
+        return;
+
+  #ifdef _WIN32
+    UnmapViewOfFile(this->data);
+  #else
+    munmap((void *)this->data, this->bytes);
+  #endif
+    this->data = NULL;
+    this->bytes = 0;
+    this->record_size = 0;
+    this->size = 0;
+}
+
+/**
+ * @brief   Number of complete records
+ *
+ * @return  long            Number of records, 0 if no log is open
+ */
+long CRunLogReader::Size() const
+{
+    return this->size;
+}
+
+/**
+ * @brief   Header of the log. A log must be open.
+ *
+ * @return  const run_log_header&       Header
+ */
+const run_log_header &CRunLogReader::Header() const
+{
+    return *(const run_log_header *)this->data;
+}
+
+/**
+ * @brief   Record i, the record of generation i + 1. i must be below Size().
+ *
+ * @param   i                       Record number
+ * @return  run_log_record          Copy of the record, genes past 2 * unit count + 1 set to 0
+ */
+run_log_record CRunLogReader::operator[](long i) const
+{
+    run_log_record record;
+
+    std::memset(&record, 0, sizeof(record));
+    std::memcpy(&record, this->data + sizeof(run_log_header) + i * this->record_size, this->record_size);
+    return record;
+}
+
+/**
+ * @brief   Generation of record i, without copying the rest of it
+ *
+ * @param   i               Record number, below Size()
+ * @return  int             Generation
+ */
+int CRunLogReader::Generation(long i) const
+{
+    std::int32_t generation;
+
+    std::memcpy(&generation, this->data + sizeof(run_log_header) + i * this->record_size, sizeof(generation));
+    return generation;
+}
+
+/**
+ * @brief   Number of the record of a generation. Records are in order of generation, one
+ *          per generation from 1, so this is generation - 1 unless the log skips
+ *          generations, in which case the record is found by bisection.
+ *
+ * @param   generation      Generation, from 1
+ * @return  long            Record number, -1 if the log does not hold the generation
+ */
+long CRunLogReader::Find(int generation) const
+{
+    if (generation >= 1 && generation <= this->size && this->Generation(generation - 1) == generation)
+        return generation - 1;
+
+    long low = 0, high = this->size;
+    while (low < high)
+    {
+        long middle = low + (high - low) / 2;
+        if (this->Generation(middle) < generation)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low < this->size && this->Generation(low) == generation ? low : -1;
+}
+
+/**
+ * @brief   Unpack the genes of record i into a circuit vector
+ *
+ * @param   i               Record number, below Size()
+ * @param   chromosome      Array of 2 * unit count + 1 genes to fill
+ */
+void CRunLogReader::Get_Genes(long i, int *chromosome) const
+{
+    const unsigned char *genes = this->data + sizeof(run_log_header) + i * this->record_size +
+                                 offsetof(run_log_record, genes);
+
+    for (int j = 0; j < 2 * (int)this->Header().unit_count + 1; j++)
+        chromosome[j] = genes[j];
+}
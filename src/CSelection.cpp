@@ -0,0 +1,115 @@
+/**
+ * @file    CSelection.cpp
+ * @author  Galena Group
+ * @brief   Roulette-wheel, tournament and rank selection of parents
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include "../includes/CSelection.h"
+
+/**
+ * @brief   Constructor for a selection engine
+ *
+ * @param   mode                ROULETTE, TOURNAMENT or RANK
+ * @param   tournament_size     Parents drawn per tournament, at least 1
+ */
+CSelection::CSelection(Selection_Mode mode, int tournament_size)
+{
+    this->mode = mode;
+    this->tournament_size = std::max(1, tournament_size);
+}
+
+/**
+ * @brief   Prepare the selection for the fitness values of one generation
+ *
+ * @param   score       Fitness value of every parent
+ */
+void CSelection::Build(const std::vector<double> &score)
+{
+    int n = score.size();
+
+    this->score = score;
+    this->prefix_sum.resize(n);
+    this->order.resize(n);
+    for (int i = 0; i < n; i++)
+        this->order[i] = i;
+
+    if (this->mode == TOURNAMENT || n == 0)
+        return;
+
+    if (this->mode == RANK)
+    {
+        // worst first, equal scores in parent order
+        std::stable_sort(this->order.begin(), this->order.end(),
+                         [&score](int a, int b) { return score[a] < score[b]; });
+        for (int i = 0; i < n; i++)
+            this->prefix_sum[i] = (i + 1.0) * (i + 2.0) / 2;
+        return;
+    }
+
+    // scores are weights as they are, unless some are not positive
+    double shift = *std::min_element(score.begin(), score.end());
+    if (shift > 0)
+        shift = 0;
+
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += score[i] - shift;
+        this->prefix_sum[i] = sum;
+    }
+
+    // every parent equally bad: choose uniformly
+    if (!(sum > 0))
+    {
+        for (int i = 0; i < n; i++)
+            this->prefix_sum[i] = i + 1;
+    }
+}
+
+/**
+ * @brief   Index of a selected parent
+ *
+ * @param   rng     Random stream of the slot
+ * @return  int     Parent number in the parents set, -1 if Build had no parents
+ */
+int CSelection::Select(CRandom *rng) const
+{
+    int n = this->order.size();
+
+    if (n == 0)
+        return -1;
+
+    if (this->mode == TOURNAMENT)
+    {
+        int best = rng->Uniform_Int(n);
+
+        for (int k = 1; k < this->tournament_size; k++)
+        {
+            int challenger = rng->Uniform_Int(n);
+            if (this->score[challenger] > this->score[best])
+                best = challenger;
+        }
+        return best;
+    }
+
+    // the first parent whose running sum exceeds the draw; parents of weight 0 are never chosen
+    double draw = rng->Uniform() * this->prefix_sum[n - 1];
+    int i = std::upper_bound(this->prefix_sum.begin(), this->prefix_sum.end(), draw) - this->prefix_sum.begin();
+
+    return this->order[std::min(i, n - 1)];
+}
+
+/**
+ * @brief   Number of parents of the last Build
+ *
+ * @return  int     Number of parents
+ */
+int CSelection::Size() const
+{
+    return this->order.size();
+}
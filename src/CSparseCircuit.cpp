@@ -0,0 +1,485 @@
+/**
+ * @file    CSparseCircuit.cpp
+ * @author  Galena Group
+ * @brief   Circuits of hundreds to thousands of units stored as sparse rows
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "../includes/CSparseCircuit.h"
+#include "../includes/CUnit.h"
+
+/**
+ * @brief   Constructor for an empty circuit, to be filled by Assign
+ *
+ * @param   initial_conc        Concentrate feed of the circuit
+ * @param   initial_tails       Tailings feed of the circuit
+ */
+template <class Index>
+CSparseCircuitT<Index>::CSparseCircuitT(int initial_conc, int initial_tails)
+{
+    this->initial_conc = initial_conc;
+    this->initial_tails = initial_tails;
+}
+
+/**
+ * @brief   Constructor for a circuit from a circuit vector. A vector of the wrong length
+ *          leaves the circuit empty.
+ *
+ * @param   chromosome          Circuit vector of 2 * unit count + 1 genes
+ * @param   initial_conc        Concentrate feed of the circuit
+ * @param   initial_tails       Tailings feed of the circuit
+ */
+template <class Index>
+CSparseCircuitT<Index>::CSparseCircuitT(const std::vector<Index> &chromosome, int initial_conc, int initial_tails)
+{
+    this->initial_conc = initial_conc;
+    this->initial_tails = initial_tails;
+    this->Assign(chromosome.data(), chromosome.size());
+}
+
+/**
+ * @brief   Largest number of units the Index can describe. Streams are numbered 2 * unit
+ *          and 2 * unit + 1, so the last one has to fit.
+ *
+ * @return  int     Units
+ */
+template <class Index>
+int CSparseCircuitT<Index>::Max_Units()
+{
+    std::uint64_t units = ((std::uint64_t)std::numeric_limits<Index>::max() - 1) / 2;
+    return (int)std::min(units, (std::uint64_t)std::numeric_limits<int>::max());
+}
+
+/**
+ * @brief   Replace the circuit with the one of a circuit vector. Genes out of range are kept,
+ *          for Check_Validity to refuse, and are taken as links to nowhere.
+ *
+ * @param   chromosome      Circuit vector of 2 * unit count + 1 genes
+ * @param   size            Number of genes
+ * @return  bool            false, leaving the circuit unchanged, if the length is even, the
+ *                          vector is empty or it has more units than Max_Units
+ */
+template <class Index>
+bool CSparseCircuitT<Index>::Assign(const Index *chromosome, std::size_t size)
+{
+    if (size % 2 == 0 || size < 3 || (size - 1) / 2 > (std::size_t)Max_Units())
+        return false;
+
+    this->unit_num = (int)((size - 1) / 2);
+    this->start = chromosome[0];
+    this->links.assign(chromosome + 1, chromosome + size);
+    this->build_rows();
+    return true;
+}
+
+/**
+ * @brief   Build the streams feeding every unit, as compressed sparse rows, and the order the
+ *          units are swept in: reverse postorder of a depth-first search from the feed, which
+ *          puts every unit outside a recycle loop after the units feeding it. Units the feed
+ *          does not reach come last.
+ */
+template <class Index>
+void CSparseCircuitT<Index>::build_rows()
+{
+    const int n = this->unit_num;
+    std::vector<std::uint32_t> fill(n + 1, 0);
+    std::vector<unsigned char> visited(n, 0);
+    std::vector<Index> stack;
+
+    this->feeder_offsets.assign(n + 1, 0);
+    for (int i = 0; i < 2 * n; i++)
+        if (this->links[i] < (std::size_t)n)
+            this->feeder_offsets[this->links[i] + 1]++;
+    for (int u = 0; u < n; u++)
+        this->feeder_offsets[u + 1] += this->feeder_offsets[u];
+
+    this->feeders.resize(this->feeder_offsets[n]);
+    std::copy(this->feeder_offsets.begin(), this->feeder_offsets.end(), fill.begin());
+    for (int i = 0; i < 2 * n; i++)
+        if (this->links[i] < (std::size_t)n)
+            this->feeders[fill[this->links[i]]++] = (Index)i;
+
+    // visited counts the links of a unit the search has followed, 1 on entering it
+    this->order.clear();
+    if (this->start < (std::size_t)n)
+    {
+        stack.push_back(this->start);
+        visited[this->start] = 1;
+    }
+    while (!stack.empty())
+    {
+        Index u = stack.back();
+
+        if (visited[u] == 3)
+        {
+            this->order.push_back(u);
+            stack.pop_back();
+            continue;
+        }
+
+        Index next = this->links[2 * u + visited[u] - 1];
+        visited[u]++;
+        if (next < (std::size_t)n && !visited[next])
+        {
+            visited[next] = 1;
+            stack.push_back(next);
+        }
+    }
+    std::reverse(this->order.begin(), this->order.end());
+    for (int u = 0; u < n; u++)
+        if (!visited[u])
+            this->order.push_back((Index)u);
+
+    this->feed.assign(2 * n, 0);
+    this->streams.assign(4 * n, 0);
+}
+
+/**
+ * @brief   Number of units
+ *
+ * @return  int     Units, 0 for an empty circuit
+ */
+template <class Index>
+int CSparseCircuitT<Index>::Units() const
+{
+    return this->unit_num;
+}
+
+/**
+ * @brief   Units reachable through the feeding streams from a set of units, that is the
+ *          units with a route to one of them
+ *
+ * @param   reached     One flag per unit, set for the units to start from; receives the rest
+ * @param   offsets     Where the feeding streams of every unit start in feeders
+ * @param   feeders     Streams feeding every unit
+ * @return  int         Number of units reached
+ */
+template <class Index>
+static int reach_back(std::vector<unsigned char> &reached, const std::vector<std::uint32_t> &offsets,
+                      const std::vector<Index> &feeders)
+{
+    std::vector<Index> queue;
+
+    for (std::size_t u = 0; u < reached.size(); u++)
+        if (reached[u])
+            queue.push_back((Index)u);
+
+    for (std::size_t head = 0; head < queue.size(); head++)
+    {
+        for (std::uint32_t k = offsets[queue[head]]; k < offsets[queue[head] + 1]; k++)
+        {
+            Index from = feeders[k] / 2;
+            if (!reached[from])
+            {
+                reached[from] = 1;
+                queue.push_back(from);
+            }
+        }
+    }
+    return (int)queue.size();
+}
+
+/**
+ * @brief   Check validity of circuit, by the rules of Validate_Genes: the feed goes to a unit,
+ *          no unit sends a product to itself or both products to the same place, products
+ *          only leave through their own outlet, every unit is reachable from the feed and
+ *          every unit has a route to both outlets
+ *
+ * @return  bool    true if the circuit is valid
+ */
+template <class Index>
+bool CSparseCircuitT<Index>::Check_Validity() const
+{
+    const std::size_t n = this->unit_num;
+    std::vector<unsigned char> from_feed(n, 0), to_conc(n, 0), to_tails(n, 0);
+    std::vector<Index> queue;
+
+    if (n == 0 || this->start >= n)
+        return false;
+
+    for (std::size_t u = 0; u < n; u++)
+    {
+        std::size_t conc_num = this->links[2 * u];
+        std::size_t tails_num = this->links[2 * u + 1];
+
+        if (conc_num == tails_num || conc_num == u || tails_num == u)
+            return false;
+        if (conc_num > n || tails_num > n + 1 || tails_num == n)
+            return false;
+        to_conc[u] = conc_num == n;
+        to_tails[u] = tails_num == n + 1;
+    }
+
+    queue.push_back(this->start);
+    from_feed[this->start] = 1;
+    for (std::size_t head = 0; head < queue.size(); head++)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            Index next = this->links[2 * queue[head] + k];
+            if (next < n && !from_feed[next])
+            {
+                from_feed[next] = 1;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    return queue.size() == n && reach_back(to_conc, this->feeder_offsets, this->feeders) == (int)n &&
+           reach_back(to_tails, this->feeder_offsets, this->feeders) == (int)n;
+}
+
+/**
+ * @brief   Score a circuit based on its performance. Every sweep takes the units in order,
+ *          gathers the feed of each from the streams feeding it, using the streams already
+ *          updated in this sweep, and computes its streams by the model of CUnit::set_values. The
+ *          circuit has converged when no feed rate changed by more than tolerance times the
+ *          largest feed rate, so the same tolerance suits circuits of any size and feed.
+ *
+ * @param   tolerance           Largest change of a feed rate relative to the largest feed rate
+ * @param   max_iterations      Maximum number of sweeps
+ * @return  double              Score, -50000 if the circuit is empty or does not converge
+ */
+template <class Index>
+double CSparseCircuitT<Index>::Evaluate_Circuit(double tolerance, int max_iterations)
+{
+    // tau = c / (flow_conc + flow_tails), so R = K tau / (1 + K tau) = K c / (s + K c)
+    const double a_conc = K_conc * V * phi * rho;
+    const double a_tails = K_tails * V * phi * rho;
+    const std::size_t n = this->unit_num;
+    double performance = 0;
+    bool converged = false;
+
+    this->iterations = 0;
+    if (n == 0 || this->start >= n)
+        return -50000;
+
+    std::fill(this->feed.begin(), this->feed.end(), 0.0);
+    std::fill(this->streams.begin(), this->streams.end(), 0.0);
+
+    while (!converged && this->iterations < max_iterations)
+    {
+        double change = 0;
+        double largest = 0;
+
+        for (std::size_t i = 0; i < n; i++)
+        {
+            Index u = this->order[i];
+            double flow_conc = u == this->start ? this->initial_conc : 0;
+            double flow_tails = u == this->start ? this->initial_tails : 0;
+
+            for (std::uint32_t k = this->feeder_offsets[u]; k < this->feeder_offsets[u + 1]; k++)
+            {
+                flow_conc += this->streams[2 * (std::size_t)this->feeders[k]];
+                flow_tails += this->streams[2 * (std::size_t)this->feeders[k] + 1];
+            }
+
+            change = std::max(change, std::fabs(flow_conc - this->feed[2 * u]));
+            change = std::max(change, std::fabs(flow_tails - this->feed[2 * u + 1]));
+            largest = std::max(largest, std::max(flow_conc, flow_tails));
+            this->feed[2 * u] = flow_conc;
+            this->feed[2 * u + 1] = flow_tails;
+
+            // To stop overflow errors, as Evaluate_Circuit of CCircuitN
+            if ((flow_conc + flow_tails) / 3000 < 1e-10)
+            {
+                flow_conc = 1e-7;
+                flow_tails = 1e-7;
+            }
+
+            double R_conc = a_conc / (flow_conc + flow_tails + a_conc);
+            double R_tails = a_tails / (flow_conc + flow_tails + a_tails);
+            double *stream = &this->streams[4 * (std::size_t)u];
+
+            stream[0] = flow_conc * R_conc;
+            stream[1] = flow_tails * R_tails;
+            stream[2] = flow_conc * (1 - R_conc);
+            stream[3] = flow_tails * (1 - R_tails);
+        }
+        this->iterations++;
+
+        if (!std::isfinite(change))
+            return -50000;
+        converged = change <= tolerance * largest;
+    }
+
+    if (!converged)
+        return -50000;
+
+    for (std::size_t u = 0; u < n; u++)
+        if (this->links[2 * u] == n)
+            performance += this->streams[4 * u] * 100 - this->streams[4 * u + 1] * 500;
+    return performance;
+}
+
+/**
+ * @brief   Number of sweeps used by the last Evaluate_Circuit call
+ *
+ * @return  int     Sweeps, including the last one that found nothing changing
+ */
+template <class Index>
+int CSparseCircuitT<Index>::Last_Iterations() const
+{
+    return this->iterations;
+}
+
+/**
+ * @brief   Bytes held by the circuit: the links, the sparse rows, the sweep order and the
+ *          feed rates and streams of the solver
+ *
+ * @return  std::size_t     Bytes allocated, including the object itself
+ */
+template <class Index>
+std::size_t CSparseCircuitT<Index>::Bytes() const
+{
+    return sizeof(*this) + (this->links.capacity() + this->feeders.capacity() + this->order.capacity()) * sizeof(Index) +
+           this->feeder_offsets.capacity() * sizeof(std::uint32_t) +
+           (this->feed.capacity() + this->streams.capacity()) * sizeof(double);
+}
+
+/**
+ * @brief   Overwrite a circuit vector with a random circuit that is valid by construction, as
+ *          the initial population of the genetic algorithm draws them when repair fails. The
+ *          units are linked into a random tree from the feed unit, so every unit is
+ *          reachable; the leaves of the tree send their products to the two outlets, so every
+ *          unit has a route to both. A unit with one link left over sends that product to a
+ *          random unit with probability recycle, closing a recycle loop, and otherwise to its
+ *          outlet. Building the tree takes one step per unit.
+ *
+ * @param   chromosome      Circuit vector to overwrite, resized to 2 * unit_num + 1 genes
+ * @param   unit_num        Number of units, at most CSparseCircuitT<Index>::Max_Units()
+ * @param   rng             Random stream
+ * @param   recycle         Probability that a link left over goes to another unit
+ */
+template <class Index>
+void Sparse_Random_Circuit(std::vector<Index> &chromosome, int unit_num, CRandom *rng, double recycle)
+{
+    std::vector<Index> order(unit_num);
+    std::vector<std::size_t> free_links;
+    std::vector<unsigned char> linked(2 * unit_num + 1, 0);
+
+    for (int i = 0; i < unit_num; i++)
+    {
+        int j = rng->Uniform_Int(i + 1);
+        order[i] = order[j];
+        order[j] = (Index)i;
+    }
+
+    chromosome.assign(2 * unit_num + 1, 0);
+    chromosome[0] = order[0];
+    free_links.push_back(order[0] * 2 + 1);
+    free_links.push_back(order[0] * 2 + 2);
+
+    // the first k units of the tree have k + 1 free links, one of which takes unit k
+    for (int k = 1; k < unit_num; k++)
+    {
+        int pick = rng->Uniform_Int((int)free_links.size());
+        std::size_t gene = free_links[pick];
+
+        chromosome[gene] = order[k];
+        linked[gene] = 1;
+        free_links[pick] = free_links.back();
+        free_links.pop_back();
+        free_links.push_back(order[k] * 2 + 1);
+        free_links.push_back(order[k] * 2 + 2);
+    }
+
+    for (int i = 0; i < unit_num; i++)
+    {
+        Index &conc = chromosome[i * 2 + 1];
+        Index &tails = chromosome[i * 2 + 2];
+        bool conc_free = !linked[i * 2 + 1];
+        bool tails_free = !linked[i * 2 + 2];
+
+        if (conc_free)
+            conc = (Index)unit_num;
+        if (tails_free)
+            tails = (Index)(unit_num + 1);
+
+        // a unit other than itself and its other destination
+        if (conc_free != tails_free && unit_num >= 3 && rng->Uniform() < recycle)
+        {
+            Index &link = conc_free ? conc : tails;
+            Index other = conc_free ? tails : conc;
+            int destination;
+
+            while ((destination = rng->Uniform_Int(unit_num)) == i || destination == (int)other)
+                ;
+            link = (Index)destination;
+        }
+    }
+}
+
+/**
+ * @brief   Mutate: change one gene of a circuit vector to another value its position allows,
+ *          the feed to any unit, a concentrate link to a unit or the concentrate outlet and a
+ *          tailings link to a unit or the tailings outlet, never to the unit itself or to
+ *          the destination of its other product. The result may still be invalid.
+ *
+ * @param   chromosome      Circuit vector of 2 * unit count + 1 genes
+ * @param   rng             Random stream
+ * @return  int             Position of the gene changed
+ */
+template <class Index>
+int Sparse_Mutate(std::vector<Index> &chromosome, CRandom *rng)
+{
+    const int n = (int)(chromosome.size() - 1) / 2;
+    int gene = rng->Uniform_Int(2 * n + 1);
+
+    if (gene == 0)
+    {
+        chromosome[0] = (Index)rng->Uniform_Int(n);
+        return gene;
+    }
+
+    int unit = (gene - 1) / 2;
+    bool conc = gene % 2 == 1;
+    Index other = chromosome[conc ? gene + 1 : gene - 1];
+    int destination;
+
+    // n stands for the outlet of the product
+    do
+    {
+        destination = rng->Uniform_Int(n + 1);
+        if (destination == n && !conc)
+            destination = n + 1;
+    } while (destination == unit || (destination == (int)other && (int)other < n));
+
+    chromosome[gene] = (Index)destination;
+    return gene;
+}
+
+/**
+ * @brief   Crossover: swap the genes of two circuit vectors from the start up to a random
+ *          point, as crossover does for the genetic algorithm. The children may be invalid.
+ *
+ * @param   father      One circuit vector
+ * @param   mother      Another circuit vector of the same length
+ * @param   rng         Random stream
+ * @return  int         Number of genes swapped, 0 if the lengths differ
+ */
+template <class Index>
+int Sparse_Crossover(std::vector<Index> &father, std::vector<Index> &mother, CRandom *rng)
+{
+    if (father.size() != mother.size())
+        return 0;
+
+    int random = rng->Uniform_Int((int)father.size());
+    std::swap_ranges(father.begin(), father.begin() + random, mother.begin());
+    return random;
+}
+
+#define INSTANTIATE_SPARSE(INDEX) \
+    template class CSparseCircuitT<INDEX>; \
+    template void Sparse_Random_Circuit<INDEX>(std::vector<INDEX> &, int, CRandom *, double); \
+    template int Sparse_Mutate<INDEX>(std::vector<INDEX> &, CRandom *); \
+    template int Sparse_Crossover<INDEX>(std::vector<INDEX> &, std::vector<INDEX> &, CRandom *);
+INSTANTIATE_SPARSE(std::uint16_t)
+INSTANTIATE_SPARSE(std::uint32_t)
+#undef INSTANTIATE_SPARSE
@@ -2,7 +2,7 @@
  * @file      Genetic_Algorithm.cpp
  * @author    Galena Group, Yang Bai, Tengteng Huang, Xiao Teng
  * @brief     For genetic algorithm implementation
- * @version   0.5
+ * @version   0.6
  * @date      2022-03-25
  *
  * @copyright Copyright (c) 2022
@@ -17,362 +17,2335 @@
 #include <algorithm>
 #include <cstdlib>
 #include <ctime>
-#include <fstream>
+#include <unordered_set>
+#include <array>
+#include <chrono>
 
 #include "../includes/CCircuit.h"
+#include "../includes/CCircuitBatch.h"
+#include "../includes/CCheckpoint.h"
+#include "../includes/CFitnessCache.h"
+#include "../includes/CMetrics.h"
+#include "../includes/CPopulation.h"
+#include "../includes/CRandom.h"
+#include "../includes/CRunLog.h"
+#include "../includes/CSelection.h"
 #include "../includes/Genetic_Algorithm.h"
+#include "../includes/Genetic_Algorithm_internal.h"
 
 using namespace std;
 
 #ifdef Parallel
-#include <omp.h>
+  #ifdef _OPENMP
+    #include <omp.h>
+  #else
+    #undef Parallel   // built without OpenMP, run on one thread
+  #endif
 #endif
 
 /**
- * @brief   Fill in parent vector by randomly generating numbers
+ * @brief   Switch the phase metrics are timing. Does nothing unless Metrics is defined.
  *
- * @param   parent      Empty vector for loading parent
- * @param   unit_num    Number of circuit units
+ * @param   metrics             Metrics, NULL for none
+ * @param   phase               Phase to switch to
+ * @return  Metrics_Phase       Phase left, to enter again when done
  */
-void create_parent(vector<int> *parent, int unit_num)
+static inline Metrics_Phase enter_phase(CMetrics *metrics, Metrics_Phase phase)
 {
-    int i;
-    int concentrate_channel = 0;
-    int tailings_channel = 0;
-    bool valid = false;
-    vector<int> temp(2 * unit_num + 1);
-
-    while (valid == false)
-    {
-        i = rand() % unit_num;
-        temp[0] = i;
-        for (int i = 0; i < unit_num; i++)
-        {
-            while ((concentrate_channel = rand() % (unit_num + 2)) == i)
-                ;
-            temp[i * 2 + 1] = (concentrate_channel);
-            while ((tailings_channel = rand() % (unit_num + 2)) == i || concentrate_channel == tailings_channel)
-                ;
-            temp[i * 2 + 2] = (tailings_channel);
-        }
-
-        CCircuit circuit(temp);
-
-        if (circuit.Check_Validity() && (circuit.Evaluate_Circuit() > 50))
-            valid = true;
-    }
-
-    for (int i = 0; i < 2 * unit_num + 1; i++)
-        parent->push_back(temp[i]);
+    #ifdef Metrics
+      if (metrics != NULL)
+          return metrics->Enter(phase);
+    #else
+      (void)metrics;
+      (void)phase;
+    #endif
+    return PHASE_OTHER;
 }
 
 /**
- * @brief   Create a set of parent vectors
+ * @brief   Count the last evaluation of a circuit in the metrics. Does nothing unless
+ *          Metrics is defined.
  *
- * @param   parent_set      Empty vector for loading multiple parents
- * @param   unit_num        Number of circuit units
- * @param   set_num         Number of Parents
+ * @param   metrics     Metrics, NULL for none
+ * @param   circuit     Circuit just evaluated
+ * @param   score       Score of the evaluation
  */
-void create_chromosome_set(vector<vector<int> > *parent_set, int unit_num, int set_num)
+template <int N>
+static inline void count_evaluation(CMetrics *metrics, CCircuitN<N> &circuit, double score)
 {
-    vector<int> temp[set_num];
-
-    for (int i = 0; i < set_num; i++)
-    {
-        create_parent(&temp[i], unit_num);
-        parent_set->push_back(temp[i]);
-    }
+    #ifdef Metrics
+      if (metrics != NULL)
+          metrics->Count_Evaluation(circuit.Last_Iterations(), score != -50000, circuit.Last_Clamps(), circuit.Aborted());
+    #else
+      (void)metrics;
+      (void)circuit;
+      (void)score;
+    #endif
 }
 
 /**
- * @brief   Calculate fitness value for parent set
+ * @brief   Look up a fitness value, one thread at a time. A cache is only shared by the
+ *          threads of the team that owns it, so a team of one (an island) takes no lock.
  *
- * @param   score               Empty vector for loading fitness value
- * @param   parent_set          Parent vector that already load
- * @param   tolerance           Error tolerance
- * @param   max_iterations      Maximum number of iterations
+ * @param   cache       Fitness cache
+ * @param   key         Canonical key
+ * @param   score       Fitness value if found
+ * @return  bool        true if the key was found
  */
-void calculate_fitness_value(vector<double> *score, vector<vector<int> > parent_set, double tolerance, int max_iterations)
+template <int N>
+static bool cache_find(CFitnessCacheN<N> *cache, const circuit_key<N> &key, double &score)
 {
-    double temp = 0.0;
+    bool found;
 
-    for (int i = 0; i < parent_set.size(); i++)
-    {
-        CCircuit *circuit = new CCircuit(parent_set[i]);
-        temp = circuit->Evaluate_Circuit();
-        score->push_back(temp);
-    }
+    #ifdef Parallel
+      if (omp_get_num_threads() > 1)
+      {
+        #pragma omp critical(fitness_cache)
+        found = cache->Find(key, score);
+        return found;
+      }
+    #endif
+    found = cache->Find(key, score);
+
+    return found;
 }
 
 /**
- * @brief   Select best parent in parent set and put it into child set
+ * @brief   Store a fitness value, one thread at a time
  *
- * @param   child_set       Vector for loading child vector
- * @param   score           Vector for fitness value
- * @param   parent_set      Vector for Parents set
+ * @param   cache       Fitness cache
+ * @param   key         Canonical key
+ * @param   score       Fitness value
  */
-double best_parent2child(vector<vector<int> > &child_set, vector<double> score, vector<vector<int> > parent_set)
+template <int N>
+static void cache_insert(CFitnessCacheN<N> *cache, const circuit_key<N> &key, double score)
 {
-    int max_num = 0;
-    double max_value = 0;
-    child_set.resize(NUM_CHILDREN);
-
     #ifdef Parallel
-      #pragma omp parallel for
-        for (int i = 0; i < score.size(); i++)
-        {
-            if (score[i] > max_value)
-            {
-                max_num = i;
-                max_value = score[i];
-            }
-        }
-    #endif
-
-    #ifndef Parallel
-      for (int i = 0; i < score.size(); i++)
+      if (omp_get_num_threads() > 1)
       {
-          if (score[i] > max_value)
-          {
-              max_num = i;
-              max_value = score[i];
-          }
+        #pragma omp critical(fitness_cache)
+        cache->Insert(key, score);
+        return;
       }
     #endif
+    cache->Insert(key, score);
+}
 
-    child_set[0]=parent_set[max_num];
-    return max_value;
+/**
+ * @brief   Look up the fitness value of a chromosome, evaluating and caching it on a miss.
+ *          The cache is keyed by the canonical form, so relabelled circuits share one entry.
+ *          The canonical form is also what gets evaluated: relabellings can differ in the
+ *          last bits of their score, and the cached value must not depend on which one a
+ *          thread happened to reach first.
+ *
+ * @param   chromosome          Circuit vector
+ * @param   cache               Fitness cache shared by every evaluation path
+ * @param   score               Fitness value of the chromosome
+ * @param   tolerance           Error tolerance of the solver
+ * @param   max_iterations      Most iterations of the solver
+ * @param   check_validity      If true, invalid circuits are rejected before evaluation
+ * @param   key                 If not NULL, receives the canonical key of the chromosome
+ * @param   metrics             If not NULL, counts the evaluation
+ * @param   evaluations         If not NULL, incremented if the circuit was simulated
+ * @return  bool                false if the circuit is invalid
+ */
+template <int N>
+static bool cached_fitness(const gene_array<N> &chromosome, CFitnessCacheN<N> *cache, double &score, double tolerance,
+                           int max_iterations, bool check_validity, circuit_key<N> *key = NULL,
+                           CMetrics *metrics = NULL, unsigned long *evaluations = NULL)
+{
+    CCircuitN<N> circuit(chromosome.data());
+    int canonical[2 * N + 1];
+
+    // most random candidates are invalid, so reject them before hashing
+    if (check_validity && !circuit.Check_Validity())
+        return false;
+
+    circuit.Canonical_Form(canonical);
+    circuit_key<N> canonical_key = CFitnessCacheN<N>::Make_Key(canonical);
+
+    if (key != NULL)
+        *key = canonical_key;
+
+    if (cache_find(cache, canonical_key, score))
+        return true;
+
+    // circuit is done with, so it is the scratch of the canonical one
+    score = Evaluate_Genes(gene_span<unsigned char>{canonical_key.data(), canonical_key.size()}, circuit, SOLVER,
+                           (const double *)NULL, tolerance, max_iterations);
+    cache_insert(cache, canonical_key, score);
+    count_evaluation(metrics, circuit, score);
+    if (evaluations != NULL)
+        (*evaluations)++;
+    return true;
 }
 
 /**
- * @brief   Randomly select a parent
+ * @brief   Score the misses of a round in single precision, BATCH_SIZE circuits at a time,
+ *          and choose the ones to evaluate again in double precision: the SCREEN_TOP best,
+ *          those within SCREEN_MARGIN of the threshold and, to count how often the rest
+ *          would have been decided otherwise, one in SCREEN_AUDIT of the others. Circuits
+ *          whose waste piles up are rejected outright, as Evaluate_Circuit does at a threshold.
  *
- * @param   parent_set      Vector for Parent set
- * @param   score           Vector for fitness value
- * @return  int             Parent number in the parents set
+ * @param   candidates      Candidates of the round, with their keys
+ * @param   scratch         Working storage with the misses; receives the slots to refine
+ *                          in refine and the screened scores of the misses in scores
+ * @param   threshold       Score a candidate must beat to be kept
  */
-int select_parent(vector<vector<int> > parent_set, vector<double> score)
+template <int N>
+static void screen_candidates(vector<ga_candidate<N> > &candidates, ga_scratch *scratch, double threshold)
 {
-    double over_score = 0.0;
-    double probability = 0.0;
-    vector<double> sum_probability_map;
-    double sum_probability = 0.0;
+    vector<int> &misses = scratch->misses;
+    vector<int> &genes = scratch->genes;
+    vector<double> &scores = scratch->scores;
+    vector<int> &ranked = scratch->ranked;
+    vector<double> &estimates = scratch->estimates;
+    vector<char> &audit = scratch->audit;
+    int miss_num = misses.size();
+    int others = 0;
+    CCircuitN<N> circuit;
 
-    #ifdef Parallel
-      #pragma omp parallel reduction(+:over_score)
-        for (int i = 0; i < score.size(); i++)
+    genes.resize(miss_num * (2 * N + 1));
+    scores.resize(miss_num);
+    audit.assign(miss_num, 0);
+    ranked.clear();
+    scratch->refine.clear();
+
+    // the key of a circuit is its canonical form, one gene per byte
+    for (int m = 0; m < miss_num; m++)
+    {
+        ga_candidate<N> &candidate = candidates[misses[m]];
+
+        circuit.Assign(gene_span<unsigned char>{candidate.key.data(), candidate.key.size()});
+        if (threshold > -HUGE_VAL && circuit.Waste_Overflows())
         {
-            over_score += score[i];
+            candidate.score = scores[m] = -50000;
+            candidate.aborted = true;
+            candidate.saved_sweeps = scratch->max_iterations;
+            audit[m] = -1;
+            continue;
         }
-    #endif
+        for (int j = 0; j < 2 * N + 1; j++)
+            genes[ranked.size() * (2 * N + 1) + j] = candidate.key[j];
+        ranked.push_back(m);
+    }
 
-    #ifndef Parallel
-      for (int i = 0; i < score.size(); i++)
-      {
-          over_score += score[i];
-      }
+    int screen_num = ranked.size();
+
+    estimates.resize(screen_num);
+
+    #ifdef Parallel
+      #pragma omp parallel for schedule(dynamic)
     #endif
+    for (int r = 0; r < screen_num; r += BATCH_SIZE)
+    {
+        CCircuitBatchN<N> batch(&genes[r * (2 * N + 1)], min(BATCH_SIZE, screen_num - r));
+        batch.Screen_Circuits(&estimates[r], SCREEN_TOLERANCE, scratch->max_iterations);
+    }
 
-    for (int i = 0; i < score.size(); i++)
+    for (int r = 0; r < screen_num; r++)
     {
-        sum_probability = sum_probability + score[i] / over_score;
-        sum_probability_map.push_back(sum_probability);
+        int m = ranked[r];
+
+        scores[m] = candidates[misses[m]].score = estimates[r];
+        candidates[misses[m]].screened = true;
     }
-    probability = (rand() % 100) / 100.0;
-    for (int i = 0; i < sum_probability_map.size(); i++)
+
+    // ties go to the earlier slot, so the choice does not depend on the thread count
+    int top = min(SCREEN_TOP, screen_num);
+    partial_sort(ranked.begin(), ranked.begin() + top, ranked.end(), [&scores](int a, int b) {
+        return scores[a] != scores[b] ? scores[a] > scores[b] : a < b;
+    });
+    for (int r = 0; r < top; r++)
+        candidates[misses[ranked[r]]].screened = false;
+
+    for (int m = 0; m < miss_num; m++)
     {
-        if (probability <= sum_probability_map[i])
+        ga_candidate<N> &candidate = candidates[misses[m]];
+
+        if (candidate.screened && fabs(scores[m] - threshold) <= SCREEN_MARGIN)
+            candidate.screened = false;
+        else if (candidate.screened && others++ % SCREEN_AUDIT == 0)
         {
-            return i;
+            candidate.screened = false;
+            audit[m] = 1;
         }
+
+        if (!candidate.screened && !candidate.aborted)
+            scratch->refine.push_back(misses[m]);
     }
-    return score.size() / 2;
+    scratch->screening.screened += screen_num;
 }
 
 /**
- * @brief   Judge whether the event occurs by given probability
+ * @brief   Count the screened decisions that evaluating again in double precision changed
  *
- * @param   x       Probability
- * @return  int     whether the event occurs by given probability
+ * @param   candidates      Candidates of the round, the refined ones with their exact scores
+ * @param   scratch         Working storage after screen_candidates, which receives the counts
+ * @param   threshold       Score a candidate must beat to be kept
  */
-static int get_rand(double x)
+template <int N>
+static void count_screening(const vector<ga_candidate<N> > &candidates, ga_scratch *scratch, double threshold)
 {
-    double p = rand() % 100 / 100.0;
+    ga_screening &screening = scratch->screening;
 
-    if (p >= x)
-        return 1;
+    for (int m = 0; m < (int)scratch->misses.size(); m++)
+    {
+        const ga_candidate<N> &candidate = candidates[scratch->misses[m]];
+        bool flipped = (scratch->scores[m] > threshold) != (candidate.score > threshold);
 
-    return 0;
+        if (candidate.screened || scratch->audit[m] < 0)
+            continue;
+        if (scratch->audit[m])
+        {
+            screening.audited++;
+            screening.audited_flips += flipped;
+        }
+        else
+        {
+            screening.refined++;
+            screening.refined_flips += flipped;
+        }
+    }
 }
 
 /**
- * @brief   Crossover: Swap a portion of one parent vector with a portion of another parent vector 
+ * @brief   Make the best score of a set of circuits exact: while the best circuit has a
+ *          screened score, evaluate it in double precision and look again, so that the
+ *          best score a run reports never comes from screening. Does nothing unless
+ *          Screening is defined.
  *
- * @param   father      One parent vector
- * @param   mother      Another parent vector
+ * @param   score           Fitness value of every circuit; exact scores replace screened ones
+ * @param   keys            Canonical key of every circuit
+ * @param   cache           Fitness cache, which receives the exact scores
+ * @param   scratch         Solver settings of the population, which counts the evaluations
+ * @return  bool            true if a score changed
  */
-void crossover(vector<int> &father, vector<int> &mother)
+template <int N>
+static bool refine_best(vector<double> &score, const vector<circuit_key<N> > &keys, CFitnessCacheN<N> *cache,
+                        ga_scratch *scratch)
 {
-    int random = 0;
-    int temp;
+  bool changed = false;
 
-    if ((get_rand(CROSSOVER_PRO)) == 1)
-        return;
+  #ifdef Screening
+    if (score.empty())
+      return false;
 
-    random = rand() % (2*NUM_UNIT+1);
+    int first = max_element(score.begin(), score.end()) - score.begin();
+    int best = first;
 
-    for (int i = 0; i < random; i++)
+    // a circuit the cache no longer holds may still have a screened score
+    while (!cache->Exact(keys[best]))
     {
-        temp = father[i];
-        father[i] = mother[i];
-        mother[i] = temp;
+      CCircuitN<N> circuit;
+      double flows[2 * N];
+      double exact = Evaluate_Genes(gene_span<unsigned char>{keys[best].data(), keys[best].size()}, circuit, SOLVER,
+                                    (const double *)NULL, scratch->tolerance, scratch->max_iterations);
+
+      if (exact != -50000)
+        circuit.Get_Flows(flows);
+      cache->Insert(keys[best], exact, exact != -50000 ? flows : NULL);
+      count_evaluation(scratch->metrics, circuit, exact);
+      scratch->evaluations++;
+      scratch->screening.elite_refined++;
+
+      circuit_key<N> key = keys[best];
+      for (int i = 0; i < (int)score.size(); i++)
+      {
+        if (keys[i] == key)
+          score[i] = exact;
+      }
+      best = max_element(score.begin(), score.end()) - score.begin();
+      changed = true;
     }
+    scratch->screening.elite_changes += best != first;
+  #else
+    (void)score;
+    (void)keys;
+    (void)cache;
+    (void)scratch;
+  #endif
+
+  return changed;
 }
 
 /**
- * @brief   Mutate: Random changes in the numbers in the vector
+ * @brief   Check and score every candidate of a round, in parallel. Unseen circuits are
+ *          evaluated once each, in canonical form, from the steady state of the candidate's
+ *          parent when it is known. The cache is read and written in slot order, so the
+ *          first slot to produce a circuit decides its warm start and the scores do not
+ *          depend on the number of threads. Evaluations stop as soon as the score cannot
+ *          beat the threshold, or with Estimate_Threshold is estimated not to, and a stopped
+ *          evaluation is not cached. With Screening, only the circuits screen_candidates
+ *          picks are evaluated in full, and the others keep and cache their single-precision
+ *          scores, marked as screened.
  *
- * @param   before      Vector to mutate
+ * @param   candidates      Candidates with genes (and parent, for children) filled in
+ * @param   cache           Fitness cache
+ * @param   scratch         Working storage, reused by every round, with the solver settings;
+ *                          counts the evaluations
+ * @param   warm            Steady states of the parents and sweep counters, NULL for a cold start
+ * @param   threshold       Score a candidate must beat to be kept, -HUGE_VAL to score every
+ *                          candidate in full. Batch_Evaluation always scores in full, but for
+ *                          the choices of Screening.
  */
-void mutate(vector<int> &before)
+template <int N>
+void evaluate_candidates(vector<ga_candidate<N> > &candidates, CFitnessCacheN<N> *cache,
+                         ga_scratch *scratch, ga_warm_start<N> *warm, double threshold)
 {
-    if ((get_rand(MUTATE_PRO)) == 1)
-        return;
+    int n = candidates.size();
+    vector<int> &misses = scratch->misses;
 
-    int random_unit_num = rand() % (2*NUM_UNIT+1);
-    int random = rand() % (NUM_UNIT+2);
+    misses.clear();
 
-    before[random_unit_num] = random;
-}
+    Metrics_Phase caller = enter_phase(scratch->metrics, PHASE_VALIDITY);
 
-/**
- * @brief   Produce child vectors from a list of parent vectors
- * 
- * @return  double  highest score
- */
-double Genetic_Algorithm(void)
-{
-  srand((unsigned)time(0));
+#ifdef Batch_Evaluation
+    // keys first, then the unseen circuits are simulated BATCH_SIZE at a time
 
-  #ifdef Print
-      ofstream outfile;
-      outfile.open("data.txt");
-  #endif
-
-  // variable 
-  vector< vector<int> > parent_set;
-  vector<double>        fitness_score;
-  vector< vector<int> > child_set;
-  child_set.resize(NUM_CHILDREN);
-  int father_num, mother_num = 0;
-  vector<int> father, mother;
-  vector <double> emp;
-  int k =0;
-  double the_max_value = 0;
-  double finalsocre;
+    #ifdef Parallel
+      #pragma omp parallel for schedule(dynamic, 16)
+    #endif
+    for (int i = 0; i < n; i++)
+    {
+        candidates[i].valid = Validate_Genes<N>(gene_span<int>{candidates[i].genes.data(), candidates[i].genes.size()});
+        candidates[i].aborted = false;
+        candidates[i].saved_sweeps = 0;
+        candidates[i].screened = false;
+        if (candidates[i].valid)
+            candidates[i].key = CCircuitN<N>(candidates[i].genes.data()).Canonical_Key();
+    }
 
-   #ifdef DO_TIMING
+    enter_phase(scratch->metrics, PHASE_EVALUATION);
+
+    for (int i = 0; i < n; i++)
+    {
+        if (candidates[i].valid && !cache->Find(candidates[i].key, candidates[i].score))
+            misses.push_back(i);
+    }
+
+    int miss_num = misses.size();
+    vector<int> &genes = scratch->genes;
+
+    scratch->evaluations += miss_num;
+
+    // the slots simulated in double precision and their scores
+    vector<int> *evaluated = &misses;
+    vector<double> *exact = &scratch->scores;
+    #ifdef Screening
+      screen_candidates(candidates, scratch, threshold);
+      evaluated = &scratch->refine;
+      exact = &scratch->refined;
+    #endif
+    int evaluated_num = evaluated->size();
+
+    // the key of a circuit is its canonical form, one gene per byte
+    genes.resize(evaluated_num * (2 * N + 1));
+    exact->resize(evaluated_num);
+    for (int e = 0; e < evaluated_num; e++)
+    {
+        for (int j = 0; j < 2 * N + 1; j++)
+            genes[e * (2 * N + 1) + j] = candidates[(*evaluated)[e]].key[j];
+    }
 
     #ifdef Parallel
-      double start = omp_get_wtime();
+      #pragma omp parallel for schedule(dynamic)
     #endif
+    for (int e = 0; e < evaluated_num; e += BATCH_SIZE)
+    {
+        CCircuitBatchN<N> batch(&genes[e * (2 * N + 1)], min(BATCH_SIZE, evaluated_num - e));
+        batch.Evaluate_Circuits(&(*exact)[e], scratch->tolerance, scratch->max_iterations);
+    }
 
-    #ifndef Parallel
-      clock_t  start = clock();
+    for (int e = 0; e < evaluated_num; e++)
+    {
+        candidates[(*evaluated)[e]].score = (*exact)[e];
+        // the batch evaluator does not report its sweeps
+        #ifdef Metrics
+          if (scratch->metrics != NULL)
+              scratch->metrics->Count_Evaluation(0, (*exact)[e] != -50000, 0, false);
+        #endif
+    }
+
+    #ifdef Screening
+      count_screening(candidates, scratch, threshold);
     #endif
 
-  #endif
+    for (int m = 0; m < miss_num; m++)
+    {
+        ga_candidate<N> &candidate = candidates[misses[m]];
+
+        if (candidate.screened)
+            cache->Insert_Screened(candidate.key, candidate.score);
+        else if (!candidate.aborted)
+            cache->Insert(candidate.key, candidate.score);
+    }
+#else
+    vector<int> &first = scratch->first;
+    vector<int> &by_key = scratch->by_key;
 
-  // Step 1: Start with the vectors representing the initial random collection of valid circuits.
-  create_chromosome_set(&parent_set, NUM_UNIT, NUM_PARENT);
+    first.assign(n, -1);
+    by_key.clear();
 
-  while(k<MAX_EVOLUTIONS)
-  {
+    // most random candidates are invalid, so reject them before anything else
+    #ifdef Parallel
+      #pragma omp parallel for schedule(dynamic, 16)
+    #endif
+    for (int i = 0; i < n; i++)
+    {
+        int canonical[2 * N + 1];
 
-    // Step 2: Calculate the fitness value for each of these vectors.
-    calculate_fitness_value(&fitness_score, parent_set, TOLERANCE, MAX_ITERATIONS);
+        candidates[i].valid = Validate_Genes<N>(gene_span<int>{candidates[i].genes.data(), candidates[i].genes.size()});
+        candidates[i].has_flows = false;
+        candidates[i].aborted = false;
+        candidates[i].saved_sweeps = 0;
+        candidates[i].screened = false;
+        if (!candidates[i].valid)
+            continue;
+        CCircuitN<N>(candidates[i].genes.data()).Canonical_Form(canonical, candidates[i].order.data());
+        candidates[i].key = CFitnessCacheN<N>::Make_Key(canonical);
+    }
 
-    // Step 3: Find best parent and put it into child_set
-    the_max_value=best_parent2child(child_set, fitness_score, parent_set);
+    enter_phase(scratch->metrics, PHASE_EVALUATION);
 
-    for(int i=1;i<NUM_CHILDREN;i++)
+    for (int i = 0; i < n; i++)
     {
-      child_set[i] = child_set[0];
+        if (candidates[i].valid && !cache->Find(candidates[i].key, candidates[i].score))
+            by_key.push_back(i);
     }
-     
-    int child_num=1;
 
-    while(NUM_CHILDREN>child_num)
+    // later slots with a circuit already being evaluated in this round share its score:
+    // sorted by key and then slot, the first slot of every run of equal keys is evaluated
+    sort(by_key.begin(), by_key.end(), [&candidates](int a, int b) {
+        return candidates[a].key != candidates[b].key ? candidates[a].key < candidates[b].key : a < b;
+    });
+    for (int j = 0; j < (int)by_key.size(); j++)
     {
-      // Step 4: Select a pair of the parent vectors with a probability that depends on the fitness value
-      father_num = select_parent(parent_set, fitness_score);
-      mother_num = select_parent(parent_set, fitness_score);
-      while(father_num == mother_num)
-      {
-        mother_num = select_parent(parent_set, fitness_score);
-      }
-      father = parent_set[father_num];
-      mother = parent_set[mother_num];
+        if (j > 0 && candidates[by_key[j]].key == candidates[by_key[j - 1]].key)
+            first[by_key[j]] = first[by_key[j - 1]] >= 0 ? first[by_key[j - 1]] : by_key[j - 1];
+        else
+            misses.push_back(by_key[j]);
+    }
+    sort(misses.begin(), misses.end());
 
-      // Step 5: Crossover
-      crossover(father, mother);
+    int miss_num = misses.size();
+    unsigned long cold = 0, cold_sweeps = 0, warmed = 0, warm_sweeps = 0;
+    double tolerance = scratch->tolerance;
+    int max_iterations = scratch->max_iterations;
+    bool estimate = false;
 
-      // Step 6: Mutate
-      mutate(father);
-      mutate(mother);
+    // stopping on an estimate can throw away a circuit that beats the threshold
+    #ifdef Estimate_Threshold
+      estimate = true;
+    #endif
 
-      // Step 7: Check validity
-      CCircuit *Cfather = new CCircuit(father);
-      CCircuit *Cmother = new CCircuit(mother);
+    scratch->evaluations += miss_num;
 
-      if (Cfather->Check_Validity() && Cfather->Evaluate_Circuit() > 0)
-      {
-        // Step 8: Add father to child list
-        child_set[child_num] = father;
-        child_num++;
-      }
+    // the slots evaluated in full
+    vector<int> *evaluated = &misses;
+    #ifdef Screening
+      screen_candidates(candidates, scratch, threshold);
+      evaluated = &scratch->refine;
+    #endif
+    int evaluated_num = evaluated->size();
 
-      if (Cmother->Check_Validity() && Cmother->Evaluate_Circuit() > 0)
-      {
-        // Step 8: Add mother to child list
-        child_set[child_num] = mother;
-        child_num++;
-      }
+    #ifdef Parallel
+      #pragma omp parallel for schedule(dynamic, 4) reduction(+ : cold, cold_sweeps, warmed, warm_sweeps)
+    #endif
+    for (int e = 0; e < evaluated_num; e++)
+    {
+        ga_candidate<N> &candidate = candidates[(*evaluated)[e]];
+        CCircuitN<N> circuit;
+        double flows[2 * N];
+
+        // canonical unit c is unit order[c] of the child, which has the number it had in the parent
+        bool warm_started = warm != NULL && candidate.parent >= 0 &&
+                            candidate.parent < (int)warm->known.size() && warm->known[candidate.parent];
+        if (warm_started)
+        {
+            const double *parent_flows = &warm->flows[(size_t)candidate.parent * 2 * N];
 
-      delete Cfather;
-      delete Cmother;
+            for (int c = 0; c < N; c++)
+            {
+                flows[2 * c] = parent_flows[2 * candidate.order[c]];
+                flows[2 * c + 1] = parent_flows[2 * candidate.order[c] + 1];
+            }
+        }
+
+        // the key is the canonical circuit vector, one gene per byte
+        candidate.score = Evaluate_Genes(gene_span<unsigned char>{candidate.key.data(), candidate.key.size()}, circuit,
+                                         SOLVER, warm_started ? flows : NULL, tolerance, max_iterations, threshold,
+                                         estimate);
+        candidate.aborted = circuit.Aborted();
+        candidate.saved_sweeps = circuit.Saved_Sweeps();
+        count_evaluation(scratch->metrics, circuit, candidate.score);
+        if (candidate.score != -50000 && !candidate.aborted)
+        {
+            circuit.Get_Flows(candidate.flows.data());
+            candidate.has_flows = true;
+        }
+
+        if (warm_started)
+        {
+            warmed++;
+            warm_sweeps += circuit.Last_Iterations();
+        }
+        else
+        {
+            cold++;
+            cold_sweeps += circuit.Last_Iterations();
+        }
     }
 
-    #ifdef Print
-      for(int i=0;i <(1+2*NUM_UNIT) ; i++)
-      {
-        outfile << child_set[0][i]<<" ";
-      }
-      outfile << fitness_score[0]<<endl;
+    #ifdef Screening
+      count_screening(candidates, scratch, threshold);
     #endif
 
-    parent_set = child_set;
-    finalsocre = fitness_score[0];
-    fitness_score = emp;
-    k++;
-    cout<<"k = "<<k<<" "<<"the max value = "<<the_max_value<<endl;
-  } 
-   #ifdef DO_TIMING
+    for (int m = 0; m < miss_num; m++)
+    {
+        ga_candidate<N> &candidate = candidates[misses[m]];
+
+        if (candidate.screened)
+            cache->Insert_Screened(candidate.key, candidate.score);
+        else if (!candidate.aborted)
+            cache->Insert(candidate.key, candidate.score, candidate.has_flows ? candidate.flows.data() : NULL);
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        if (first[i] >= 0)
+            candidates[i].score = candidates[first[i]].score;
+    }
+
+    if (warm != NULL)
+    {
+        warm->cold_evaluations += cold;
+        warm->cold_sweeps += cold_sweeps;
+        warm->warm_evaluations += warmed;
+        warm->warm_sweeps += warm_sweeps;
+    }
+#endif
+
+    enter_phase(scratch->metrics, caller);
+}
+
+/**
+ * @brief   Look up the steady state of one parent, renumbered from the canonical units
+ *          stored in the cache back to the parent's own units
+ *
+ * @param   warm            Feed rates of the parents, sized for parent_set; receives those of parent i
+ * @param   i               Parent to look up
+ * @param   parent_set      Parents
+ * @param   cache           Fitness cache, not modified
+ */
+template <int N>
+static void parent_steady_state(ga_warm_start<N> *warm, int i, const CPopulationN<N> &parent_set,
+                                CFitnessCacheN<N> *cache)
+{
+    gene_array<N> parent;
+    int canonical[2 * N + 1];
+    int order[N];
+    double flows[2 * N];
+
+    parent_set.Get(i, parent.data());
+    CCircuitN<N>(parent.data()).Canonical_Form(canonical, order);
+    warm->known[i] = cache->Find_Flows(CFitnessCacheN<N>::Make_Key(canonical), flows);
+    if (!warm->known[i])
+        return;
+
+    for (int c = 0; c < N; c++)
+    {
+        warm->flows[(size_t)i * 2 * N + 2 * order[c]] = flows[2 * c];
+        warm->flows[(size_t)i * 2 * N + 2 * order[c] + 1] = flows[2 * c + 1];
+    }
+}
+
+/**
+ * @brief   Look up the steady state of every parent
+ *
+ * @param   warm            Receives the feed rates of the parents
+ * @param   parent_set      Parents of the generation
+ * @param   cache           Fitness cache, not modified
+ */
+template <int N>
+static void parent_steady_states(ga_warm_start<N> *warm, const CPopulationN<N> &parent_set, CFitnessCacheN<N> *cache)
+{
+    int n = parent_set.Size();
 
+    warm->flows.resize((size_t)n * 2 * N);
+    warm->known.assign(n, 0);
+
+    // Find_Flows only reads the cache, so the parents can be looked up together
     #ifdef Parallel
-      double end = omp_get_wtime();
-      cout << " Runtime: " << (double)(end - start) << " s" << endl;
+      #pragma omp parallel for schedule(dynamic, 16)
     #endif
+    for (int i = 0; i < n; i++)
+        parent_steady_state(warm, i, parent_set, cache);
+}
 
-    #ifndef Parallel
-      clock_t  end = clock();
-      cout << " Runtime: " << (double)(end - start) / CLOCKS_PER_SEC << " s" << endl;
-    #endif
+/**
+ * @brief   Overwrite a chromosome with random genes, never linking a unit to itself
+ *          and never sending both products of a unit to the same place
+ *
+ * @param   temp        Chromosome to overwrite
+ * @param   rng         Random stream of the slot
+ */
+template <int N>
+void random_chromosome(gene_array<N> *temp, CRandom *rng)
+{
+    const int unit_num = N;
+    int concentrate_channel = 0;
+    int tailings_channel = 0;
 
-  #endif
+    (*temp)[0] = rng->Uniform_Int(unit_num);
+    for (int i = 0; i < unit_num; i++)
+    {
+        while ((concentrate_channel = rng->Uniform_Int(unit_num + 2)) == i)
+            ;
+        (*temp)[i * 2 + 1] = (concentrate_channel);
+        while ((tailings_channel = rng->Uniform_Int(unit_num + 2)) == i || concentrate_channel == tailings_channel)
+            ;
+        (*temp)[i * 2 + 2] = (tailings_channel);
+    }
+}
 
-  #ifdef Print
-      outfile.close();
-  #endif
-  return finalsocre ;
+/**
+ * @brief   A random destination for a product of a unit: another unit or the outlet of the product
+ *
+ * @param   unit        The unit the product leaves
+ * @param   other       Destination of the other product of the unit, never chosen
+ * @param   outlet      Outlet of the product, N or N + 1
+ * @param   rng         Random stream of the slot
+ * @return  int         Destination
+ */
+template <int N>
+static int random_destination(int unit, int other, int outlet, CRandom *rng)
+{
+    int destination;
+
+    // N stands for the outlet
+    while ((destination = rng->Uniform_Int(N + 1)) == unit || destination == other)
+        ;
+    return destination == N ? outlet : destination;
+}
+
+/**
+ * @brief   Overwrite a chromosome with a random circuit that is valid by construction.
+ *          The units are linked into a random tree from the feed unit, so every unit is
+ *          reachable; the leaves of the tree send their products to the two outlets, so
+ *          every unit has a route to both; the links left over go anywhere allowed.
+ *
+ * @param   temp        Chromosome to overwrite
+ * @param   rng         Random stream of the slot
+ */
+template <int N>
+void tree_chromosome(gene_array<N> *temp, CRandom *rng)
+{
+    int order[N];
+
+    for (int i = 0; i < N; i++)
+    {
+        int j = rng->Uniform_Int(i + 1);
+        order[i] = order[j];
+        order[j] = i;
+    }
+
+    (*temp)[0] = order[0];
+    for (int i = 1; i < 2 * N + 1; i++)
+        (*temp)[i] = -1;
+
+    // the first k units of the tree have k + 1 free links, one of which takes unit k
+    for (int k = 1; k < N; k++)
+    {
+        int pick = rng->Uniform_Int(k + 1);
+
+        for (int j = 0; j < k && pick >= 0; j++)
+        {
+            for (int link = 0; link < 2 && pick >= 0; link++)
+            {
+                int &gene = (*temp)[order[j] * 2 + 1 + link];
+                if (gene < 0 && pick-- == 0)
+                    gene = order[k];
+            }
+        }
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        int &conc = (*temp)[i * 2 + 1];
+        int &tails = (*temp)[i * 2 + 2];
+
+        if (conc < 0 && tails < 0)
+        {
+            conc = N;
+            tails = N + 1;
+        }
+        else if (conc < 0)
+            conc = random_destination<N>(i, tails, N, rng);
+        else if (tails < 0)
+            tails = random_destination<N>(i, conc, N + 1, rng);
+    }
 }
+
+/**
+ * @brief   A random unit of a set
+ *
+ * @param   units       Units, one bit each, at least one
+ * @param   rng         Random stream of the slot
+ * @return  int         Unit number
+ */
+static int random_unit(std::uint32_t units, CRandom *rng)
+{
+    for (int pick = rng->Uniform_Int(__builtin_popcount(units)); pick > 0; pick--)
+        units &= units - 1;
+    return __builtin_ctz(units);
+}
+
+/**
+ * @brief   Turn an invalid chromosome into a valid one by changing as few genes as it can.
+ *          Genes out of range point to the outlet of their product; then, one gene per
+ *          step, an unreachable unit is linked from a reachable one, or a unit without a
+ *          route to an outlet sends that product straight to it.
+ *
+ * @param   genes       Chromosome to repair
+ * @param   rng         Random stream of the slot
+ * @return  bool        true if genes is now valid
+ */
+template <int N>
+bool repair_chromosome(gene_array<N> &genes, CRandom *rng)
+{
+    gene_span<int> span = {genes.data(), genes.size()};
+
+    if (genes[0] < 0 || genes[0] >= N)
+        genes[0] = rng->Uniform_Int(N);
+
+    for (int i = 0; i < N; i++)
+    {
+        int &conc = genes[i * 2 + 1];
+        int &tails = genes[i * 2 + 2];
+
+        if (conc < 0 || conc > N || conc == i)
+            conc = N;
+        if (tails < 0 || tails > N + 1 || tails == N || tails == i || tails == conc)
+            tails = N + 1;
+    }
+
+    // every step fixes a unit, though it may cut off another; give up after a few rounds
+    for (int step = 0; step < 4 * N; step++)
+    {
+        circuit_reach reached = Circuit_Reach<N>(span);
+
+        if (reached.from_feed != reached.all)
+        {
+            // a reached unit never already links to an unreached one
+            int unit = random_unit(reached.all & ~reached.from_feed, rng);
+            int from = random_unit(reached.from_feed, rng);
+            genes[from * 2 + 1 + rng->Uniform_Int(2)] = unit;
+        }
+        else if (reached.to_conc != reached.all)
+            genes[random_unit(reached.all & ~reached.to_conc, rng) * 2 + 1] = N;
+        else if (reached.to_tails != reached.all)
+            genes[random_unit(reached.all & ~reached.to_tails, rng) * 2 + 2] = N + 1;
+        else
+            return true;
+    }
+    return Validate_Genes<N>(span);
+}
+
+/**
+ * @brief   Overwrite a chromosome with a random valid circuit: random genes, repaired if
+ *          they are invalid. Tree circuits are all valid but seldom score well, so a
+ *          random tree is only the fallback for genes repair cannot mend.
+ *
+ * @param   temp        Chromosome to overwrite
+ * @param   rng         Random stream of the slot
+ * @return  bool        true if the random genes were invalid and had to be repaired or replaced
+ */
+template <int N>
+bool valid_chromosome(gene_array<N> *temp, CRandom *rng)
+{
+    random_chromosome<N>(temp, rng);
+    if (Validate_Genes<N>(gene_span<int>{temp->data(), temp->size()}))
+        return false;
+
+    if (!repair_chromosome<N>(*temp, rng))
+        tree_chromosome<N>(temp, rng);
+    return true;
+}
+
+/**
+ * @brief   Create a set of parent vectors. Candidates are drawn in rounds, candidate i of
+ *          round r from its own random stream, and accepted in order, so the set depends
+ *          only on the seed and not on the number of threads.
+ *
+ * @param   parent_set      Population that receives set_num parents
+ * @param   set_num         Number of Parents
+ * @param   cache           Fitness cache
+ * @param   seed            Seed of the run
+ * @param   acceptance      If not NULL, counts what became of the candidates
+ * @param   scratch         Working storage and solver settings of the population, which times
+ *                          the phases and counts the evaluations; NULL for storage of its own
+ *                          and the default settings
+ */
+template <int N>
+void create_chromosome_set(CPopulationN<N> *parent_set, int set_num, CFitnessCacheN<N> *cache, unsigned long seed,
+                           ga_acceptance *acceptance, ga_scratch *scratch)
+{
+    vector<ga_candidate<N> > candidates(SEED_CANDIDATES);
+    unordered_set<circuit_key<N>, circuit_key_hash<N> > seen;
+    ga_scratch own_scratch;
+    int accepted = 0;
+    int last_accepted = 0;
+
+    if (scratch == NULL)
+        scratch = &own_scratch;
+    CMetrics *metrics = scratch->metrics;
+    Metrics_Phase caller = enter_phase(metrics, PHASE_INIT);
+
+    parent_set->Resize(set_num);
+    for (int round = 0; accepted < set_num; round++)
+    {
+        #ifdef Parallel
+          #pragma omp parallel for
+        #endif
+        for (int i = 0; i < SEED_CANDIDATES; i++)
+        {
+            // generation 0 is the initial population
+            CRandom rng(seed, 0, (unsigned long)round * SEED_CANDIDATES + i);
+
+            #ifdef Repair
+              candidates[i].repaired = valid_chromosome<N>(&candidates[i].genes, &rng);
+            #else
+              random_chromosome<N>(&candidates[i].genes, &rng);
+            #endif
+        }
+
+        // small circuits may never score above 50 or have set_num distinct good
+        // designs, so once SEED_ROUNDS rounds pass without a new parent take any
+        // circuit that scores at all
+        bool relaxed = round - last_accepted >= SEED_ROUNDS;
+        double threshold = relaxed ? 0 : 50;
+
+        evaluate_candidates(candidates, cache, scratch, (ga_warm_start<N> *)NULL, threshold);
+
+        for (int i = 0; i < SEED_CANDIDATES && accepted < set_num; i++)
+        {
+            bool taken = candidates[i].valid && candidates[i].score > threshold;
+
+            #ifdef Deduplicate
+              taken = taken && (seen.insert(candidates[i].key).second || relaxed);
+            #endif
+
+            if (acceptance != NULL)
+                acceptance->Count(candidates[i], taken);
+            if (!taken)
+                continue;
+
+            parent_set->Set(accepted, candidates[i].genes.data());
+            accepted++;
+            last_accepted = round;
+        }
+    }
+
+    enter_phase(metrics, caller);
+}
+
+/**
+ * @brief   Calculate fitness value for parent set
+ *
+ * @param   score               Empty vector for loading fitness value
+ * @param   parent_set          Parent vector that already load
+ * @param   tolerance           Error tolerance
+ * @param   max_iterations      Maximum number of iterations
+ * @param   cache               Fitness cache
+ * @param   keys                If not NULL, receives the canonical key of every parent
+ * @param   metrics             If not NULL, counts the evaluations
+ * @param   evaluations         If not NULL, increased by the number of parents simulated
+ */
+template <int N>
+void calculate_fitness_value(vector<double> *score, const CPopulationN<N> &parent_set, double tolerance, int max_iterations, CFitnessCacheN<N> *cache,
+                             vector<circuit_key<N> > *keys, CMetrics *metrics, unsigned long *evaluations)
+{
+    int n = parent_set.Size();
+    unsigned long simulated = 0;
+
+    score->resize(n);
+    if (keys != NULL)
+        keys->resize(n);
+
+    #ifdef Parallel
+      #pragma omp parallel for schedule(dynamic, 4) reduction(+ : simulated)
+    #endif
+    for (int i = 0; i < n; i++)
+    {
+        gene_array<N> parent;
+
+        parent_set.Get(i, parent.data());
+        cached_fitness(parent, cache, (*score)[i], tolerance, max_iterations, false,
+                       keys != NULL ? &(*keys)[i] : NULL, metrics, &simulated);
+    }
+
+    if (evaluations != NULL)
+        *evaluations += simulated;
+}
+
+/**
+ * @brief   Select best parent in parent set and put it into child set
+ *
+ * @param   child_set       Vector for loading child vector
+ * @param   score           Vector for fitness value
+ * @param   parent_set      Vector for Parents set
+ * @param   children        Number of children the child set holds
+ */
+template <int N>
+double best_parent2child(CPopulationN<N> &child_set, const vector<double> &score, const CPopulationN<N> &parent_set,
+                         int children)
+{
+    int max_num = 0;
+    double max_value = 0;
+    child_set.Resize(children);
+
+    // a serial scan keeps the first of equal scores, whatever the thread count
+    for (int i = 0; i < (int)score.size(); i++)
+    {
+        if (score[i] > max_value)
+        {
+            max_num = i;
+            max_value = score[i];
+        }
+    }
+
+    child_set.Set(0, parent_set[max_num]);
+    return max_value;
+}
+
+/**
+ * @brief   Judge whether the event occurs by given probability
+ *
+ * @param   x       Probability
+ * @param   rng     Random stream of the slot
+ * @return  int     whether the event occurs by given probability
+ */
+static int get_rand(double x, CRandom *rng)
+{
+    double p = rng->Uniform_Int(100) / 100.0;
+
+    if (p >= x)
+        return 1;
+
+    return 0;
+}
+
+/**
+ * @brief   Crossover: Swap a portion of one parent vector with a portion of another parent vector
+ *
+ * @param   father          One parent vector
+ * @param   mother          Another parent vector
+ * @param   rng             Random stream of the slot
+ * @param   probability     Probability of a crossover
+ * @return  int             Number of genes swapped from the start of the vectors
+ */
+template <int N>
+int crossover(gene_array<N> &father, gene_array<N> &mother, CRandom *rng, double probability)
+{
+    int random = 0;
+    int temp;
+
+    if ((get_rand(probability, rng)) == 1)
+        return 0;
+
+    random = rng->Uniform_Int(2*N+1);
+
+    for (int i = 0; i < random; i++)
+    {
+        temp = father[i];
+        father[i] = mother[i];
+        mother[i] = temp;
+    }
+    return random;
+}
+
+/**
+ * @brief   Mutate: Random changes in the numbers in the vector
+ *
+ * @param   before          Vector to mutate
+ * @param   rng             Random stream of the slot
+ * @param   probability     Probability of a mutation
+ */
+template <int N>
+void mutate(gene_array<N> &before, CRandom *rng, double probability)
+{
+    if ((get_rand(probability, rng)) == 1)
+        return;
+
+    int random_unit_num = rng->Uniform_Int(2*N+1);
+    int random = rng->Uniform_Int(N+2);
+
+    before[random_unit_num] = random;
+}
+
+/**
+ * @brief   Select, cross and mutate a pair of parents into a pair of children
+ *
+ * @param   parent_set      Vector for Parents set
+ * @param   selection       Selection built on the fitness values of the parents
+ * @param   config          Probabilities of crossover and mutation
+ * @param   rng             Random stream of the slot
+ * @param   father          Receives the first child, and the parent it takes most genes from
+ * @param   mother          Receives the second child, and the parent it takes most genes from
+ */
+template <int N>
+static void breed_pair(const CPopulationN<N> &parent_set, const CSelection &selection, const ga_config &config,
+                       CRandom *rng, ga_candidate<N> &father, ga_candidate<N> &mother)
+{
+    // Step 4: Select a pair of the parent vectors with a probability that depends on the fitness value
+    int father_num = selection.Select(rng);
+    int mother_num = selection.Select(rng);
+    while (father_num == mother_num)
+    {
+        mother_num = selection.Select(rng);
+    }
+    parent_set.Get(father_num, father.genes.data());
+    parent_set.Get(mother_num, mother.genes.data());
+
+    // Step 5: Crossover
+    int swapped = crossover<N>(father.genes, mother.genes, rng, config.crossover_probability);
+    father.parent = swapped <= N ? father_num : mother_num;
+    mother.parent = swapped <= N ? mother_num : father_num;
+
+    // Step 6: Mutate
+    mutate<N>(father.genes, rng, config.mutate_probability);
+    mutate<N>(mother.genes, rng, config.mutate_probability);
+
+    // invalid children are mended rather than thrown away
+    father.repaired = false;
+    mother.repaired = false;
+    #ifdef Repair
+      if (!Validate_Genes<N>(gene_span<int>{father.genes.data(), father.genes.size()}))
+          father.repaired = repair_chromosome<N>(father.genes, rng);
+      if (!Validate_Genes<N>(gene_span<int>{mother.genes.data(), mother.genes.size()}))
+          mother.repaired = repair_chromosome<N>(mother.genes, rng);
+    #endif
+}
+
+/**
+ * @brief   Decide whether a valid child joins the child set when deduplication is on
+ *
+ * @param   child_keys      Canonical keys of the children chosen so far
+ * @param   key             Canonical key of the candidate child
+ * @param   duplicates      Number of duplicates rejected so far in this generation
+ * @return  bool            true if the child should be added
+ */
+template <int N>
+static bool is_new_child(vector<circuit_key<N> > &child_keys, const circuit_key<N> &key, int &duplicates)
+{
+    #ifdef Deduplicate
+      // at most one key per child, few enough to scan
+      if (find(child_keys.begin(), child_keys.end(), key) == child_keys.end())
+      {
+          child_keys.push_back(key);
+      }
+      else if (duplicates < MAX_DUPLICATES)
+      {
+          duplicates++;
+          return false;
+      }
+    #else
+      (void)child_keys;
+      (void)key;
+      (void)duplicates;
+    #endif
+
+    return true;
+}
+
+/**
+ * @brief   Steps 2 to 8 for one generation: score the parents, keep the best and
+ *          breed the rest of the children, which become the next parents
+ *
+ * @param   population      Population to evolve
+ * @param   k               Number of the generation, from 0
+ */
+template <int N>
+void evolve_generation(ga_population<N> &population, int k)
+{
+  CPopulationN<N> &parent_set = population.parent_set;
+  CPopulationN<N> &child_set = population.child_set;
+  vector<double> &fitness_score = population.fitness_score;
+  vector<ga_candidate<N> > &candidates = population.candidates;
+  const ga_config &config = population.config;
+  CMetrics *metrics = population.scratch.metrics;
+  int duplicates = 0;
+
+  #ifdef Metrics
+    if (metrics != NULL)
+      metrics->Begin_Generation();
+  #endif
+
+  // Step 2: Calculate the fitness value for each of these vectors.
+  enter_phase(metrics, PHASE_FITNESS);
+  calculate_fitness_value(&fitness_score, parent_set, config.tolerance, config.max_iterations, &population.cache,
+                          &population.parent_keys, metrics, &population.scratch.evaluations);
+
+  // Step 3: Find best parent and put it into child_set
+  enter_phase(metrics, PHASE_ELITE);
+  refine_best(fitness_score, population.parent_keys, &population.cache, &population.scratch);
+  population.the_max_value=best_parent2child<N>(child_set, fitness_score, parent_set, config.children);
+  enter_phase(metrics, PHASE_SELECTION);
+  population.selection.Build(fitness_score);
+  #ifdef Warm_Start
+    enter_phase(metrics, PHASE_EVALUATION);
+    parent_steady_states(&population.warm, parent_set, &population.cache);
+  #endif
+  enter_phase(metrics, PHASE_OTHER);
+
+  // every other child is bred below, so the best parent is not copied into their slots
+  int child_num=1;
+
+  #ifdef Deduplicate
+    // reject children that are relabelled copies of ones already chosen,
+    // unless the population has collapsed so far that nothing new turns up
+    population.child_keys.clear();
+    gene_array<N> best;
+    child_set.Get(0, best.data());
+    population.child_keys.push_back(CCircuitN<N>(best.data()).Canonical_Key());
+  #endif
+
+  for (int round = 0; config.children > child_num; round++)
+  {
+    // Steps 4 to 6, one pair per missing child, each pair from the stream of its slot
+    int pairs = config.children - child_num;
+    candidates.resize(2 * pairs);
+    enter_phase(metrics, PHASE_BREEDING);
+
+    #ifdef Parallel
+      #pragma omp parallel for
+    #endif
+    for (int i = 0; i < pairs; i++)
+    {
+      // generation 0 is the initial population
+      CRandom rng(population.seed, k + 1, (unsigned long)round * config.children + i);
+      breed_pair<N>(parent_set, population.selection, config, &rng, candidates[2 * i], candidates[2 * i + 1]);
+    }
+
+    // Step 7: Check validity
+    #ifdef Warm_Start
+      evaluate_candidates(candidates, &population.cache, &population.scratch, &population.warm, 0.0);
+    #else
+      evaluate_candidates(candidates, &population.cache, &population.scratch, (ga_warm_start<N> *)NULL, 0.0);
+    #endif
+    enter_phase(metrics, PHASE_OTHER);
+
+    // Step 8: Add children to child list in slot order, father before mother
+    for (int i = 0; i < 2 * pairs && child_num < config.children; i++)
+    {
+      bool taken = candidates[i].valid && candidates[i].score > 0 &&
+                   is_new_child<N>(population.child_keys, candidates[i].key, duplicates);
+
+      population.children.Count(candidates[i], taken);
+      if (taken)
+      {
+        child_set.Set(child_num, candidates[i].genes.data());
+        child_num++;
+      }
+    }
+  }
+
+  population.finalsocre = fitness_score[0];
+  parent_set.Swap(child_set);
+  fitness_score.clear();
+
+  #ifdef Metrics
+    if (metrics != NULL)
+      metrics->End_Generation();
+  #endif
+}
+
+/**
+ * @brief   Move the best parents of every island to its neighbours, where they replace
+ *          the worst parents. Every island sends what it held before the exchange, and
+ *          an island's best parent is never replaced.
+ *
+ * @param   islands         Islands between two generations
+ * @param   migrants        Number of parents each island sends to each neighbour
+ * @param   topology        RING sends to the next island, ALL_TO_ALL to every other island
+ */
+template <int N>
+static void migrate(vector<ga_population<N> > &islands, int migrants, Migration_Topology topology)
+{
+  int island_num = islands.size();
+  vector< vector<int> > order(island_num);
+  vector< CPopulationN<N> > incoming(island_num);
+
+  // rank the parents of every island, best first
+  for (int i = 0; i < island_num; i++)
+  {
+    vector<double> &score = islands[i].fitness_score;
+
+    calculate_fitness_value(&score, islands[i].parent_set, islands[i].config.tolerance,
+                            islands[i].config.max_iterations, &islands[i].cache, (vector<circuit_key<N> > *)NULL,
+                            islands[i].scratch.metrics, &islands[i].scratch.evaluations);
+    order[i].resize(score.size());
+    for (int j = 0; j < (int)order[i].size(); j++)
+      order[i][j] = j;
+    stable_sort(order[i].begin(), order[i].end(), [&score](int a, int b) { return score[a] > score[b]; });
+  }
+
+  for (int from = 0; from < island_num; from++)
+  {
+    int sent = min(migrants, (int)order[from].size());
+
+    for (int step = 1; step < island_num; step++)
+    {
+      int to = (from + step) % island_num;
+
+      for (int j = 0; j < sent; j++)
+      {
+        incoming[to].Resize(incoming[to].Size() + 1);
+        incoming[to].Set(incoming[to].Size() - 1, islands[from].parent_set[order[from][j]]);
+      }
+
+      if (topology == RING)
+        break;
+    }
+  }
+
+  for (int i = 0; i < island_num; i++)
+  {
+    int replaced = min(incoming[i].Size(), (int)order[i].size() - 1);
+
+    for (int j = 0; j < replaced; j++)
+      islands[i].parent_set.Set(order[i][order[i].size() - 1 - j], incoming[i][j]);
+    islands[i].fitness_score.clear();
+  }
+}
+
+/**
+ * @brief   Fraction of the parents of the last generation that are distinct circuits,
+ *          relabellings of a circuit counted once
+ *
+ * @param   population      Population after evolve_generation
+ * @return  double          Distinct circuits over parents, 1 for no parents
+ */
+template <int N>
+static double parent_diversity(ga_population<N> &population)
+{
+  vector<circuit_key<N> > &keys = population.parent_keys;
+  int distinct = 0;
+
+  // the keys are not needed again until the next generation overwrites them
+  sort(keys.begin(), keys.end());
+  for (int i = 0; i < (int)keys.size(); i++)
+    distinct += i == 0 || keys[i] != keys[i - 1];
+  return keys.empty() ? 1 : (double)distinct / keys.size();
+}
+
+/**
+ * @brief   The first stopping criterion a run meets after a generation
+ *
+ * @param   progress        State of the run after the generation
+ * @param   stopping        Stopping criteria
+ * @return  Stop_Reason     RUNNING if no criterion is met
+ */
+static Stop_Reason stop_reason(const ga_progress &progress, const stopping_criteria &stopping)
+{
+  if (stopping.target_score != 0 && progress.best_score >= stopping.target_score)
+    return TARGET_REACHED;
+  if (stopping.stall_generations > 0 && progress.stalled >= stopping.stall_generations)
+    return STALLED;
+  if (progress.diversity < stopping.min_diversity)
+    return LOW_DIVERSITY;
+  if (stopping.time_budget > 0 && progress.elapsed >= stopping.time_budget)
+    return OUT_OF_TIME;
+  if (progress.generation >= stopping.max_generations)
+    return MAX_GENERATIONS;
+  return RUNNING;
+}
+
+#ifdef Metrics
+/**
+ * @brief   Copy the counts of candidates into the metrics
+ *
+ * @param   metrics         Counts in the metrics
+ * @param   acceptance      Counts of the population
+ */
+void copy_acceptance(candidate_metrics &metrics, const ga_acceptance &acceptance)
+{
+  metrics.drawn = acceptance.drawn;
+  metrics.repaired = acceptance.repaired;
+  metrics.invalid = acceptance.invalid;
+  metrics.rejected = acceptance.rejected;
+  metrics.accepted = acceptance.accepted;
+}
+#endif
+
+/**
+ * @brief   Print what became of the candidates a population looked at
+ *
+ * @param   name            What the candidates were for
+ * @param   acceptance      Counts of the candidates
+ */
+#ifdef DO_TIMING
+static void print_acceptance(const char *name, const ga_acceptance &acceptance)
+{
+  double drawn = max(1UL, acceptance.drawn);
+
+  cout << " " << name << ": " << acceptance.drawn << " drawn, " << 100 * acceptance.accepted / drawn
+       << "% accepted, " << 100 * acceptance.invalid / drawn << "% invalid, " << 100 * acceptance.repaired / drawn
+       << "% repaired, " << 100 * acceptance.rejected / drawn << "% rejected for their score, "
+       << acceptance.aborted << " evaluations stopped at the threshold, projected to save "
+       << acceptance.saved_sweeps << " sweeps" << endl;
+}
+#endif
+
+/**
+ * @brief   Print how often screening would have changed a decision. Refined circuits
+ *          had their decision put right; the audited sample estimates how many of the
+ *          circuits left to their screened score were decided wrongly.
+ *
+ * @param   screening       Counts of the population
+ */
+#if defined(Screening) && defined(DO_TIMING)
+static void print_screening(const ga_screening &screening)
+{
+  double refined = max(1UL, screening.refined);
+  double audited = max(1UL, screening.audited);
+
+  cout << " Screening: " << screening.screened << " screened, " << screening.refined << " refined ("
+       << 100 * screening.refined_flips / refined << "% changed decisions), " << screening.audited << " audited ("
+       << 100 * screening.audited_flips / audited << "% changed decisions), " << screening.elite_refined
+       << " best parents refined, changing the best in " << screening.elite_changes << " generations" << endl;
+}
+#endif
+
+/**
+ * @brief   Parameters and compile switches of this build that change the course of a run
+ *          and are not in ga_config. A checkpoint stores them, and a run is only resumed by
+ *          a build that would have run it the same way.
+ *
+ * @return  vector      Parameter values in a fixed order
+ */
+static vector<double> build_parameters()
+{
+  double switches = 0;
+
+  #ifdef Warm_Start
+    switches += 1;
+  #endif
+  #ifdef Repair
+    switches += 2;
+  #endif
+  #ifdef Deduplicate
+    switches += 4;
+  #endif
+  #ifdef Batch_Evaluation
+    switches += 8;
+  #endif
+  #ifdef Screening
+    switches += 16;
+  #endif
+  #ifdef Estimate_Threshold
+    switches += 32;
+  #endif
+
+  return {CACHE_SIZE, SOLVER, SELECTION, TOURNAMENT_SIZE, MAX_DUPLICATES, BATCH_SIZE, switches,
+          SCREEN_TOLERANCE, SCREEN_TOP, SCREEN_MARGIN, SCREEN_AUDIT};
+}
+
+/**
+ * @brief   Check the parameters of a run
+ *
+ * @param   config      Parameters of the run
+ * @return  bool        true if a run can go ahead with them
+ */
+static bool valid_config(const ga_config &config)
+{
+  // selection draws two different parents, and the children are the next parents
+  return config.parents >= 2 && config.children >= 2 && config.crossover_probability >= 0 &&
+         config.crossover_probability <= 1 && config.mutate_probability >= 0 && config.mutate_probability <= 1 &&
+         config.tolerance > 0 && config.max_iterations >= 1;
+}
+
+/**
+ * @brief   Save everything the rest of a run depends on after a generation: its parameters, the parents,
+ *          the fitness cache in order of use, as cached scores and steady states decide
+ *          how children are scored, and the counters. Random numbers are drawn from
+ *          streams keyed by the seed and the generation, so the seed is their whole state.
+ *
+ * @param   population      Population after evolve_generation
+ * @param   progress        State of the run after the generation
+ * @param   stopping        Stopping criteria of the run
+ * @param   checkpoint      Where to write the checkpoint and how often
+ * @return  bool            true if the checkpoint was written
+ */
+template <int N>
+static bool write_checkpoint(const ga_population<N> &population, const ga_progress &progress,
+                             const stopping_criteria &stopping, const checkpoint_settings &checkpoint)
+{
+  CCheckpointWriter writer;
+  vector<double> build = build_parameters();
+  vector<circuit_key<N> > keys;
+  vector<fitness_entry<N> > entries;
+  int parents = population.parent_set.Size();
+
+  writer.Write_Value((uint64_t)population.seed);
+  writer.Write_Value((uint64_t)build.size());
+  writer.Write(build.data(), build.size() * sizeof(double));
+  writer.Write_Value(population.config);
+  writer.Write_Value(stopping);
+  writer.Write_String(checkpoint.file);
+  writer.Write_Value(checkpoint.interval);
+
+  writer.Write_Value(progress.generation);
+  writer.Write_Value(progress.best_score);
+  writer.Write_Value(progress.stalled);
+  writer.Write_Value(progress.diversity);
+  writer.Write_Value(progress.elapsed);
+  writer.Write_Value(progress.evaluations);
+
+  writer.Write_Value(population.the_max_value);
+  writer.Write_Value(population.finalsocre);
+  writer.Write_Value(parents);
+  if (parents > 0)
+    writer.Write(population.parent_set[0], (size_t)parents * CPopulationN<N>::length);
+  writer.Write_Value(population.initial);
+  writer.Write_Value(population.children);
+  writer.Write_Value(population.warm.cold_evaluations);
+  writer.Write_Value(population.warm.cold_sweeps);
+  writer.Write_Value(population.warm.warm_evaluations);
+  writer.Write_Value(population.warm.warm_sweeps);
+
+  population.cache.Get_Entries(keys, entries);
+  writer.Write_Value(population.cache.hits);
+  writer.Write_Value(population.cache.misses);
+  writer.Write_Value(population.cache.evictions);
+  writer.Write_Value((uint64_t)keys.size());
+  writer.Write(keys.data(), keys.size() * sizeof(circuit_key<N>));
+  writer.Write(entries.data(), entries.size() * sizeof(fitness_entry<N>));
+
+  return writer.Commit(checkpoint.file.c_str(), N);
+}
+
+/**
+ * @brief   Restore the state write_checkpoint saved after the run settings, which
+ *          Resume_Genetic_Algorithm has already read
+ *
+ * @param   reader          Checkpoint, read up to the state of the generation
+ * @param   population      Population built with the seed and parameters of the checkpoint
+ * @param   progress        Receives the state of the run after the generation
+ * @return  bool            false if the checkpoint does not hold a whole population
+ */
+template <int N>
+static bool read_checkpoint(CCheckpointReader &reader, ga_population<N> &population, ga_progress &progress)
+{
+  int parents = 0;
+  uint64_t entry_num = 0;
+
+  bool ok = reader.Read_Value(progress.generation) && reader.Read_Value(progress.best_score) &&
+            reader.Read_Value(progress.stalled) && reader.Read_Value(progress.diversity) &&
+            reader.Read_Value(progress.elapsed) && reader.Read_Value(progress.evaluations);
+
+  ok = ok && reader.Read_Value(population.the_max_value) && reader.Read_Value(population.finalsocre) &&
+       reader.Read_Value(parents) && parents >= 0 &&
+       parents <= max(population.config.parents, population.config.children);
+  if (!ok)
+    return false;
+  population.parent_set.Resize(parents);
+  ok = (parents == 0 || reader.Read(population.parent_set[0], (size_t)parents * CPopulationN<N>::length)) &&
+       reader.Read_Value(population.initial) && reader.Read_Value(population.children) &&
+       reader.Read_Value(population.warm.cold_evaluations) && reader.Read_Value(population.warm.cold_sweeps) &&
+       reader.Read_Value(population.warm.warm_evaluations) && reader.Read_Value(population.warm.warm_sweeps);
+
+  unsigned long hits = 0, misses = 0, evictions = 0;
+  ok = ok && reader.Read_Value(hits) && reader.Read_Value(misses) && reader.Read_Value(evictions) &&
+       reader.Read_Value(entry_num) && entry_num <= CACHE_SIZE;
+  if (!ok)
+    return false;
+
+  // entries come least recently used first, so inserting them in turn restores the order of eviction
+  vector<circuit_key<N> > keys(entry_num);
+  vector<fitness_entry<N> > entries(entry_num);
+  ok = reader.Read(keys.data(), keys.size() * sizeof(circuit_key<N>)) &&
+       reader.Read(entries.data(), entries.size() * sizeof(fitness_entry<N>)) && reader.Done();
+  if (!ok)
+    return false;
+  population.cache.Clear();
+  for (size_t i = 0; i < keys.size(); i++)
+    population.cache.Insert_Entry(keys[i], entries[i]);
+  population.cache.hits = hits;
+  population.cache.misses = misses;
+  population.cache.evictions = evictions;
+  population.scratch.evaluations = progress.evaluations;
+  return true;
+}
+
+/**
+ * @brief   Produce child vectors from a list of parent vectors. Every random number is
+ *          drawn from a stream keyed by the seed, the generation and the slot it is used
+ *          in, and candidates are accepted in slot order, so a seed gives the same result
+ *          for any number of threads. The run stops at the first stopping criterion met;
+ *          only OUT_OF_TIME depends on the speed of the machine.
+ *
+ *          A run resumed from a checkpoint carries on exactly as the run that wrote it.
+ *
+ * @param   seed            Seed of the run
+ * @param   config          Parameters of the run
+ * @param   stopping        Stopping criteria
+ * @param   checkpoint      Where to write checkpoints and how often
+ * @param   callback        Called after every generation, NULL for none
+ * @param   user_data       Passed to callback
+ * @param   resume          Checkpoint to resume from, read up to the state of its generation,
+ *                          or NULL to start a new run
+ * @return  double          highest score
+ */
+template <int N>
+static double genetic_algorithm(unsigned long seed, const ga_config &config, const stopping_criteria &stopping,
+                                const checkpoint_settings &checkpoint, progress_callback callback, void *user_data,
+                                CCheckpointReader *resume = NULL)
+{
+  ga_population<N> population(seed, config);
+  ga_progress progress;
+  int k =0;
+
+   #ifdef DO_TIMING
+
+    #ifdef Parallel
+      double start = omp_get_wtime();
+    #endif
+
+    #ifndef Parallel
+      clock_t  start = clock();
+    #endif
+
+  #endif
+
+  #ifdef Metrics
+    population.metrics.Start();
+    population.scratch.metrics = &population.metrics;
+    progress.metrics = &population.metrics;
+  #endif
+
+  // Step 1: Start with the vectors representing the initial random collection of valid circuits,
+  // or with the parents of the generation the checkpoint was written after.
+  progress.best_circuit.resize(2 * N + 1);
+  if (resume == NULL)
+  {
+    create_chromosome_set<N>(&population.parent_set, config.parents, &population.cache, seed, &population.initial,
+                             &population.scratch);
+    progress.stop = stopping.max_generations > 0 ? RUNNING : MAX_GENERATIONS;
+  }
+  else if (read_checkpoint(*resume, population, progress))
+  {
+    k = progress.generation;
+    population.parent_set.Get(0, progress.best_circuit.data());
+    progress.stop = stop_reason(progress, stopping);
+  }
+  else
+  {
+    cerr << "Cannot resume from a checkpoint that does not hold a whole population" << endl;
+    return 0;
+  }
+
+  #ifdef Print
+    CRunLog log;
+    if (!log.Open(RUN_LOG_FILE, N, seed, k))
+      cerr << "Cannot write the run log " << RUN_LOG_FILE << endl;
+  #endif
+
+  // a resumed run counts the seconds before its checkpoint as spent already
+  auto evolution_start = chrono::steady_clock::now() - chrono::duration_cast<chrono::steady_clock::duration>(
+                                                            chrono::duration<double>(progress.elapsed));
+
+  while (progress.stop == RUNNING)
+  {
+    evolve_generation(population, k);
+    k++;
+
+    if (config.print_interval > 0 && k % config.print_interval == 0)
+      cout<<"k = "<<k<<" "<<"the max value = "<<population.the_max_value<<endl;
+
+    // the best parent is kept, so it is the first parent of the next generation
+    progress.stalled = k > 1 && population.the_max_value <= progress.best_score ? progress.stalled + 1 : 0;
+    progress.generation = k;
+    progress.best_score = population.the_max_value;
+    population.parent_set.Get(0, progress.best_circuit.data());
+    progress.diversity = parent_diversity(population);
+    progress.elapsed = chrono::duration<double>(chrono::steady_clock::now() - evolution_start).count();
+    progress.evaluations = population.scratch.evaluations;
+    progress.stop = stop_reason(progress, stopping);
+
+    #ifdef Metrics
+      copy_acceptance(population.metrics.initial, population.initial);
+      copy_acceptance(population.metrics.children, population.children);
+    #endif
+
+    #ifdef Print
+      log.Append(k, progress.best_score, progress.elapsed, progress.stalled, population.parent_set[0]);
+    #endif
+
+    if (callback != NULL && !callback(progress, user_data) && progress.stop == RUNNING)
+      progress.stop = CALLBACK_STOP;
+
+    if (checkpoint.interval > 0 && (k % checkpoint.interval == 0 || progress.stop != RUNNING) &&
+        !write_checkpoint(population, progress, stopping, checkpoint))
+      cerr << "Cannot write the checkpoint " << checkpoint.file << endl;
+  }
+  #ifdef DO_TIMING
+
+    #ifdef Parallel
+      double end = omp_get_wtime();
+      cout << " Runtime: " << (double)(end - start) << " s" << endl;
+    #endif
+
+    #ifndef Parallel
+      clock_t  end = clock();
+      cout << " Runtime: " << (double)(end - start) / CLOCKS_PER_SEC << " s" << endl;
+    #endif
+
+    cout << " Fitness cache: hits = " << population.cache.hits << ", misses = " << population.cache.misses
+         << ", evictions = " << population.cache.evictions << ", entries = " << population.cache.Size() << endl;
+    #ifdef Warm_Start
+      const ga_warm_start<N> &warm = population.warm;
+      cout << " Children evaluated from the circuit feed: " << warm.cold_evaluations << ", "
+           << (double)warm.cold_sweeps / max(1UL, warm.cold_evaluations) << " sweeps each; from a parent: "
+           << warm.warm_evaluations << ", " << (double)warm.warm_sweeps / max(1UL, warm.warm_evaluations)
+           << " sweeps each" << endl;
+    #endif
+    print_acceptance("Initial population", population.initial);
+    print_acceptance("Children", population.children);
+    #ifdef Screening
+      print_screening(population.scratch.screening);
+    #endif
+    const char *reasons[] = {"running", "max generations", "stalled", "low diversity", "out of time",
+                             "target reached", "stopped by the callback"};
+    cout << " Stopped after " << k << " generations: " << reasons[progress.stop] << endl;
+
+  #endif
+
+  #ifdef Print
+    if (!log.Close())
+      cerr << "Cannot write the run log " << RUN_LOG_FILE << endl;
+  #endif
+
+  #ifdef Metrics
+    population.metrics.Stop();
+    if (!population.metrics.Write(METRICS_FILE))
+      cerr << "Cannot write the metrics " << METRICS_FILE << endl;
+  #endif
+  // the score of the first parent lags a generation behind the best circuit found
+  return progress.best_score;
+}
+
+/**
+ * @brief   Island model: independent populations, one per thread, that exchange their
+ *          best parents every migration_interval generations. Islands only meet at the
+ *          exchange, which is serial, so a seed gives the same result for any number of
+ *          threads.
+ *
+ * @param   seed                    Seed of the run
+ * @param   island_num              Number of islands
+ * @param   generations             Number of generations
+ * @param   migration_interval      Generations between exchanges, 0 for isolated islands
+ * @param   migrants                Parents each island sends to each neighbour
+ * @param   topology                RING or ALL_TO_ALL
+ * @param   config                  Parameters of every island
+ * @return  double                  highest score over the islands
+ */
+template <int N>
+static double island_genetic_algorithm(unsigned long seed, int island_num, int generations,
+                                       int migration_interval, int migrants, Migration_Topology topology,
+                                       const ga_config &config)
+{
+  vector<ga_population<N> > islands;
+  double best = 0;
+
+  if (island_num < 1)
+    island_num = 1;
+  if (migration_interval < 1)
+    migration_interval = generations;
+
+  // island seeds come from a generation no population uses
+  islands.reserve(island_num);
+  for (int i = 0; i < island_num; i++)
+    islands.emplace_back(CRandom(seed, ~0UL, i).Next(), config);
+
+  #ifdef Metrics
+    // the islands are in place, so their metrics stay where the scratch points
+    for (int i = 0; i < island_num; i++)
+    {
+      islands[i].metrics.Start();
+      islands[i].scratch.metrics = &islands[i].metrics;
+    }
+  #endif
+
+  #ifdef DO_TIMING
+    #ifdef Parallel
+      double start = omp_get_wtime();
+    #else
+      clock_t  start = clock();
+    #endif
+  #endif
+
+  // Step 1 on every island; nested loops inside run on the island's thread
+  #ifdef Parallel
+    #pragma omp parallel for schedule(static, 1)
+  #endif
+  for (int i = 0; i < island_num; i++)
+    create_chromosome_set<N>(&islands[i].parent_set, config.parents, &islands[i].cache, islands[i].seed,
+                             &islands[i].initial, &islands[i].scratch);
+
+  for (int k = 0; k < generations; k += migration_interval)
+  {
+    int epoch = min(migration_interval, generations - k);
+
+    #ifdef Parallel
+      #pragma omp parallel for schedule(static, 1)
+    #endif
+    for (int i = 0; i < island_num; i++)
+    {
+      for (int g = 0; g < epoch; g++)
+        evolve_generation(islands[i], k + g);
+    }
+
+    if (k + epoch < generations && island_num > 1)
+      migrate(islands, migrants, topology);
+
+    if (config.print_interval > 0)
+    {
+      best = 0;
+      for (int i = 0; i < island_num; i++)
+        best = max(best, islands[i].the_max_value);
+      cout<<"k = "<<k + epoch<<" "<<"the max value = "<<best<<endl;
+    }
+  }
+
+  #ifdef DO_TIMING
+    #ifdef Parallel
+      cout << " Runtime: " << omp_get_wtime() - start << " s" << endl;
+    #else
+      cout << " Runtime: " << (double)(clock() - start) / CLOCKS_PER_SEC << " s" << endl;
+    #endif
+
+    ga_acceptance initial, children;
+    ga_screening screening;
+    for (int i = 0; i < island_num; i++)
+    {
+      initial.Add(islands[i].initial);
+      children.Add(islands[i].children);
+      screening.Add(islands[i].scratch.screening);
+    }
+    print_acceptance("Initial population", initial);
+    print_acceptance("Children", children);
+    #ifdef Screening
+      print_screening(screening);
+    #endif
+  #endif
+
+  #ifdef Metrics
+    CMetrics metrics;
+    for (int i = 0; i < island_num; i++)
+    {
+      islands[i].metrics.Stop();
+      copy_acceptance(islands[i].metrics.initial, islands[i].initial);
+      copy_acceptance(islands[i].metrics.children, islands[i].children);
+      metrics.Add(islands[i].metrics);
+    }
+    if (!metrics.Write(METRICS_FILE))
+      cerr << "Cannot write the metrics " << METRICS_FILE << endl;
+  #endif
+
+  best = 0;
+  for (int i = 0; i < island_num; i++)
+    best = max(best, islands[i].finalsocre);
+  return best;
+}
+
+/**
+ * @brief   Steady-state engine: breed STEADY_STATE_CHILDREN children at a time with the
+ *          operators of the generational loop and let each child, in slot order, replace
+ *          the worst member of the population if it scores higher and is not a relabelling
+ *          of a member. A min-heap on fitness keeps the worst member at hand. Members keep
+ *          their scores, so only new circuits are ever evaluated, and nothing is copied but
+ *          the children that join; children that cannot beat the worst member stop being
+ *          evaluated early. A generation is the config.children - 1 children the generational
+ *          loop would breed, rounded up to whole steps, so the stopping criteria and the
+ *          progress callback mean the same in both engines. Every step draws from its own
+ *          random streams and replaces serially, so a seed gives the same result for any
+ *          number of threads.
+ *
+ * @param   seed            Seed of the run
+ * @param   config          Parameters of the run; the members are the config.parents circuits
+ *                          of the initial population
+ * @param   stopping        Stopping criteria
+ * @param   callback        Called after every generation, NULL for none
+ * @param   user_data       Passed to callback
+ * @return  double          highest score
+ */
+template <int N>
+static double steady_state_genetic_algorithm(unsigned long seed, const ga_config &config,
+                                             const stopping_criteria &stopping, progress_callback callback,
+                                             void *user_data)
+{
+  ga_population<N> population(seed, config);
+  CPopulationN<N> &members = population.parent_set;
+  vector<double> &score = population.fitness_score;
+  vector<ga_candidate<N> > &candidates = population.candidates;
+  vector<circuit_key<N> > keys;
+  vector<int> heap;
+  ga_progress progress;
+  CMetrics *metrics = NULL;
+  int pairs = max(1, STEADY_STATE_CHILDREN / 2);
+  int steps = (config.children - 1 + 2 * pairs - 1) / (2 * pairs);
+  unsigned long step = 0;
+  int k = 0;
+
+  // with this order the heap keeps the member with the lowest score at the top
+  auto worse = [&score](int a, int b) { return score[a] > score[b]; };
+
+  #ifdef DO_TIMING
+    #ifdef Parallel
+      double start = omp_get_wtime();
+    #else
+      clock_t  start = clock();
+    #endif
+  #endif
+
+  #ifdef Metrics
+    population.metrics.Start();
+    metrics = population.scratch.metrics = &population.metrics;
+    progress.metrics = &population.metrics;
+  #endif
+
+  // Step 1 and 2, once: the members and their scores
+  create_chromosome_set<N>(&members, config.parents, &population.cache, seed, &population.initial,
+                           &population.scratch);
+  enter_phase(metrics, PHASE_FITNESS);
+  calculate_fitness_value(&score, members, config.tolerance, config.max_iterations, &population.cache, &keys, metrics,
+                          &population.scratch.evaluations);
+  #ifdef Warm_Start
+    enter_phase(metrics, PHASE_EVALUATION);
+    parent_steady_states(&population.warm, members, &population.cache);
+    ga_warm_start<N> *warm = &population.warm;
+  #else
+    ga_warm_start<N> *warm = NULL;
+  #endif
+  enter_phase(metrics, PHASE_OTHER);
+
+  heap.resize(members.Size());
+  for (int i = 0; i < (int)heap.size(); i++)
+    heap[i] = i;
+  make_heap(heap.begin(), heap.end(), worse);
+
+  #ifdef Print
+    CRunLog log;
+    if (!log.Open(RUN_LOG_FILE, N, seed))
+      cerr << "Cannot write the run log " << RUN_LOG_FILE << endl;
+  #endif
+
+  auto evolution_start = chrono::steady_clock::now();
+  progress.best_circuit.resize(2 * N + 1);
+  progress.stop = stopping.max_generations > 0 ? RUNNING : MAX_GENERATIONS;
+
+  while (progress.stop == RUNNING)
+  {
+    #ifdef Metrics
+      if (metrics != NULL)
+        metrics->Begin_Generation();
+    #endif
+
+    for (int s = 0; s < steps; s++, step++)
+    {
+      enter_phase(metrics, PHASE_SELECTION);
+      population.selection.Build(score);
+      candidates.resize(2 * pairs);
+
+      // Steps 4 to 6, one pair per slot; generation 0 of the streams is the initial population
+      enter_phase(metrics, PHASE_BREEDING);
+      #ifdef Parallel
+        #pragma omp parallel for
+      #endif
+      for (int i = 0; i < pairs; i++)
+      {
+        CRandom rng(seed, step + 1, i);
+        breed_pair<N>(members, population.selection, config, &rng, candidates[2 * i], candidates[2 * i + 1]);
+      }
+
+      // Step 7, stopping every evaluation that cannot beat the worst member
+      evaluate_candidates(candidates, &population.cache, &population.scratch, warm, score[heap[0]]);
+      enter_phase(metrics, PHASE_OTHER);
+
+      // Step 8 in place: each child that joins replaces the worst member
+      for (int i = 0; i < 2 * pairs; i++)
+      {
+        ga_candidate<N> &child = candidates[i];
+        int worst = heap[0];
+        bool taken = child.valid && !child.aborted && child.score > score[worst] &&
+                     find(keys.begin(), keys.end(), child.key) == keys.end();
+
+        population.children.Count(child, taken);
+        if (!taken)
+          continue;
+
+        pop_heap(heap.begin(), heap.end(), worse);
+        members.Set(worst, child.genes.data());
+        score[worst] = child.score;
+        keys[worst] = child.key;
+        push_heap(heap.begin(), heap.end(), worse);
+        if (warm != NULL)
+          parent_steady_state(warm, worst, members, &population.cache);
+      }
+    }
+    k++;
+
+    #ifdef Metrics
+      if (metrics != NULL)
+        metrics->End_Generation();
+    #endif
+
+    // the first of equal best scores, as best_parent2child picks it
+    if (refine_best(score, keys, &population.cache, &population.scratch))
+      make_heap(heap.begin(), heap.end(), worse);
+    int best = max_element(score.begin(), score.end()) - score.begin();
+    population.the_max_value = score[best];
+
+    if (config.print_interval > 0 && k % config.print_interval == 0)
+      cout<<"k = "<<k<<" "<<"the max value = "<<population.the_max_value<<endl;
+
+    // parent_diversity sorts the keys it is given, so it gets a copy
+    population.parent_keys = keys;
+    progress.stalled = k > 1 && population.the_max_value <= progress.best_score ? progress.stalled + 1 : 0;
+    progress.generation = k;
+    progress.best_score = population.the_max_value;
+    members.Get(best, progress.best_circuit.data());
+    progress.diversity = parent_diversity(population);
+    progress.elapsed = chrono::duration<double>(chrono::steady_clock::now() - evolution_start).count();
+    progress.evaluations = population.scratch.evaluations;
+    progress.stop = stop_reason(progress, stopping);
+
+    #ifdef Metrics
+      copy_acceptance(population.metrics.initial, population.initial);
+      copy_acceptance(population.metrics.children, population.children);
+    #endif
+
+    #ifdef Print
+      log.Append(k, progress.best_score, progress.elapsed, progress.stalled, members[best]);
+    #endif
+
+    if (callback != NULL && !callback(progress, user_data) && progress.stop == RUNNING)
+      progress.stop = CALLBACK_STOP;
+  }
+
+  #ifdef DO_TIMING
+    #ifdef Parallel
+      cout << " Runtime: " << omp_get_wtime() - start << " s" << endl;
+    #else
+      cout << " Runtime: " << (double)(clock() - start) / CLOCKS_PER_SEC << " s" << endl;
+    #endif
+    cout << " Fitness cache: hits = " << population.cache.hits << ", misses = " << population.cache.misses
+         << ", evictions = " << population.cache.evictions << ", entries = " << population.cache.Size() << endl;
+    print_acceptance("Initial population", population.initial);
+    print_acceptance("Children", population.children);
+    #ifdef Screening
+      print_screening(population.scratch.screening);
+    #endif
+  #endif
+
+  #ifdef Print
+    if (!log.Close())
+      cerr << "Cannot write the run log " << RUN_LOG_FILE << endl;
+  #endif
+
+  #ifdef Metrics
+    population.metrics.Stop();
+    if (!population.metrics.Write(METRICS_FILE))
+      cerr << "Cannot write the metrics " << METRICS_FILE << endl;
+  #endif
+  return progress.best_score;
+}
+
+/**
+ * @brief   Produce child vectors from a list of parent vectors, seeded from the clock
+ *
+ * @return  double  highest score
+ */
+double Genetic_Algorithm(void)
+{
+  return Genetic_Algorithm((unsigned long)time(0));
+}
+
+/**
+ * @brief   Produce child vectors from a list of parent vectors, for circuits of NUM_UNIT units
+ *
+ * @param   seed    Seed of the run
+ * @return  double  highest score
+ */
+double Genetic_Algorithm(unsigned long seed)
+{
+  return Genetic_Algorithm(seed, NUM_UNIT);
+}
+
+/**
+ * @brief   Produce child vectors from a list of parent vectors, for circuits of any size
+ *          built into the library. With Islands defined this runs the island model.
+ *
+ * @param   seed        Seed of the run
+ * @param   unit_num    Number of circuit units, min_units to max_units
+ * @return  double      highest score, 0 if the size is not built in
+ */
+double Genetic_Algorithm(unsigned long seed, int unit_num)
+{
+  return Genetic_Algorithm(seed, unit_num, stopping_criteria());
+}
+
+/**
+ * @brief   Produce child vectors until a stopping criterion is met, for circuits of any size
+ *          built into the library. The callback sees the best circuit so far after every
+ *          generation and may stop the run. With Islands defined this runs the island model
+ *          for stopping.max_generations generations, without the other criteria.
+ *
+ * @param   seed        Seed of the run
+ * @param   unit_num    Number of circuit units, min_units to max_units
+ * @param   stopping    Stopping criteria
+ * @param   callback    Called after every generation, NULL for none
+ * @param   user_data   Passed to callback
+ * @return  double      highest score, 0 if the size is not built in
+ */
+double Genetic_Algorithm(unsigned long seed, int unit_num, const stopping_criteria &stopping,
+                         progress_callback callback, void *user_data)
+{
+  return Genetic_Algorithm(seed, unit_num, stopping, checkpoint_settings(), callback, user_data);
+}
+
+/**
+ * @brief   Produce child vectors until a stopping criterion is met, writing a checkpoint
+ *          every checkpoint.interval generations and when the run stops, with the
+ *          parameters defined in Genetic_Algorithm.h
+ *
+ * @param   seed        Seed of the run
+ * @param   unit_num    Number of circuit units, min_units to max_units
+ * @param   stopping    Stopping criteria
+ * @param   checkpoint  Where to write checkpoints and how often
+ * @param   callback    Called after every generation, NULL for none
+ * @param   user_data   Passed to callback
+ * @return  double      highest score, 0 if the size is not built in
+ */
+double Genetic_Algorithm(unsigned long seed, int unit_num, const stopping_criteria &stopping,
+                         const checkpoint_settings &checkpoint, progress_callback callback, void *user_data)
+{
+  return Genetic_Algorithm(seed, unit_num, ga_config(), stopping, checkpoint, callback, user_data);
+}
+
+/**
+ * @brief   Produce child vectors with the population sizes, probabilities and solver settings
+ *          of config, until a stopping criterion is met, writing a checkpoint every
+ *          checkpoint.interval generations and when the run stops. With Islands defined this
+ *          runs the island model, and with Steady_State the steady-state engine; neither
+ *          writes checkpoints. Runs with different configs share nothing, so they can go
+ *          on at the same time on different threads.
+ *
+ * @param   seed        Seed of the run
+ * @param   unit_num    Number of circuit units, min_units to max_units
+ * @param   config      Parameters of the run
+ * @param   stopping    Stopping criteria
+ * @param   checkpoint  Where to write checkpoints and how often
+ * @param   callback    Called after every generation, NULL for none
+ * @param   user_data   Passed to callback
+ * @return  double      highest score, 0 if the size is not built in or config is out of range
+ */
+double Genetic_Algorithm(unsigned long seed, int unit_num, const ga_config &config, const stopping_criteria &stopping,
+                         const checkpoint_settings &checkpoint, progress_callback callback, void *user_data)
+{
+  #ifdef Islands
+    return Island_Genetic_Algorithm(seed, unit_num, NUM_ISLANDS, stopping.max_generations, MIGRATION_INTERVAL,
+                                    NUM_MIGRANTS, MIGRATION_TOPOLOGY, config);
+  #endif
+  #ifdef Steady_State
+    return Steady_State_Genetic_Algorithm(seed, unit_num, config, stopping, callback, user_data);
+  #endif
+
+  if (!valid_config(config))
+  {
+    cerr << "Genetic_Algorithm: the parameters are out of range" << endl;
+    return 0;
+  }
+
+  switch (unit_num)
+  {
+    #define GENETIC_ALGORITHM_CASE(UNITS) \
+    case UNITS: \
+      return genetic_algorithm<UNITS>(seed, config, stopping, checkpoint, callback, user_data);
+    FOR_EACH_UNIT_COUNT(GENETIC_ALGORITHM_CASE)
+    #undef GENETIC_ALGORITHM_CASE
+  }
+
+  cerr << "Genetic_Algorithm: circuits of " << unit_num << " units are not built in, use "
+       << min_units << " to " << max_units << endl;
+  return 0;
+}
+
+/**
+ * @brief   Carry on the run that wrote a checkpoint with the seed, parameters, stopping
+ *          criteria and checkpoint settings it was started with. The generations after the checkpoint
+ *          are the ones the run would have bred had it never stopped, so a seed gives the
+ *          same result however often its run is stopped and resumed. A run that had met a
+ *          stopping criterion returns at once; one stopped by its callback carries on.
+ *
+ * @param   path        Checkpoint written by a run of this build
+ * @param   callback    Called after every generation, NULL for none
+ * @param   user_data   Passed to callback
+ * @return  double      highest score, 0 if the checkpoint cannot be resumed
+ */
+double Resume_Genetic_Algorithm(const char *path, progress_callback callback, void *user_data)
+{
+  CCheckpointReader reader;
+  uint64_t seed = 0, parameter_num = 0;
+  ga_config config;
+  stopping_criteria stopping;
+  checkpoint_settings checkpoint;
+  vector<double> build = build_parameters();
+  vector<double> parameters;
+
+  if (!reader.Open(path))
+  {
+    cerr << "Resume_Genetic_Algorithm: " << path << " is not a complete checkpoint" << endl;
+    return 0;
+  }
+
+  bool ok = reader.Read_Value(seed) && reader.Read_Value(parameter_num) && parameter_num == build.size();
+  if (ok)
+  {
+    parameters.resize(parameter_num);
+    ok = reader.Read(parameters.data(), parameter_num * sizeof(double)) && parameters == build &&
+         reader.Read_Value(config) && valid_config(config) && reader.Read_Value(stopping) &&
+         reader.Read_String(checkpoint.file) && reader.Read_Value(checkpoint.interval);
+  }
+  if (!ok)
+  {
+    cerr << "Resume_Genetic_Algorithm: " << path << " was written by a build with other parameters" << endl;
+    return 0;
+  }
+
+  switch (reader.Unit_Count())
+  {
+    #define RESUME_CASE(UNITS) \
+    case UNITS: \
+      return genetic_algorithm<UNITS>(seed, config, stopping, checkpoint, callback, user_data, &reader);
+    FOR_EACH_UNIT_COUNT(RESUME_CASE)
+    #undef RESUME_CASE
+  }
+
+  cerr << "Resume_Genetic_Algorithm: circuits of " << reader.Unit_Count() << " units are not built in" << endl;
+  return 0;
+}
+
+/**
+ * @brief   Island model of the genetic algorithm for circuits of any size built into the library
+ *
+ * @param   seed                    Seed of the run
+ * @param   unit_num                Number of circuit units, min_units to max_units
+ * @param   island_num              Number of islands
+ * @param   generations             Number of generations
+ * @param   migration_interval      Generations between exchanges, 0 for isolated islands
+ * @param   migrants                Parents each island sends to each neighbour
+ * @param   topology                RING or ALL_TO_ALL
+ * @param   config                  Parameters of every island
+ * @return  double                  highest score, 0 if the size is not built in or config is out of range
+ */
+double Island_Genetic_Algorithm(unsigned long seed, int unit_num, int island_num, int generations,
+                                int migration_interval, int migrants, Migration_Topology topology,
+                                const ga_config &config)
+{
+  if (!valid_config(config))
+  {
+    cerr << "Island_Genetic_Algorithm: the parameters are out of range" << endl;
+    return 0;
+  }
+
+  switch (unit_num)
+  {
+    #define ISLAND_CASE(UNITS) \
+    case UNITS: \
+      return island_genetic_algorithm<UNITS>(seed, island_num, generations, migration_interval, migrants, topology, \
+                                             config);
+    FOR_EACH_UNIT_COUNT(ISLAND_CASE)
+    #undef ISLAND_CASE
+  }
+
+  cerr << "Island_Genetic_Algorithm: circuits of " << unit_num << " units are not built in, use "
+       << min_units << " to " << max_units << endl;
+  return 0;
+}
+
+/**
+ * @brief   Steady-state engine for circuits of any size built into the library
+ *
+ * @param   seed        Seed of the run
+ * @param   unit_num    Number of circuit units, min_units to max_units
+ * @param   stopping    Stopping criteria
+ * @param   callback    Called after every generation, NULL for none
+ * @param   user_data   Passed to callback
+ * @return  double      highest score, 0 if the size is not built in
+ */
+double Steady_State_Genetic_Algorithm(unsigned long seed, int unit_num, const stopping_criteria &stopping,
+                                      progress_callback callback, void *user_data)
+{
+  return Steady_State_Genetic_Algorithm(seed, unit_num, ga_config(), stopping, callback, user_data);
+}
+
+/**
+ * @brief   Steady-state engine with the population size, probabilities and solver settings
+ *          of config, for circuits of any size built into the library
+ *
+ * @param   seed        Seed of the run
+ * @param   unit_num    Number of circuit units, min_units to max_units
+ * @param   config      Parameters of the run
+ * @param   stopping    Stopping criteria
+ * @param   callback    Called after every generation, NULL for none
+ * @param   user_data   Passed to callback
+ * @return  double      highest score, 0 if the size is not built in or config is out of range
+ */
+double Steady_State_Genetic_Algorithm(unsigned long seed, int unit_num, const ga_config &config,
+                                      const stopping_criteria &stopping, progress_callback callback, void *user_data)
+{
+  if (!valid_config(config))
+  {
+    cerr << "Steady_State_Genetic_Algorithm: the parameters are out of range" << endl;
+    return 0;
+  }
+
+  switch (unit_num)
+  {
+    #define STEADY_STATE_CASE(UNITS) \
+    case UNITS: \
+      return steady_state_genetic_algorithm<UNITS>(seed, config, stopping, callback, user_data);
+    FOR_EACH_UNIT_COUNT(STEADY_STATE_CASE)
+    #undef STEADY_STATE_CASE
+  }
+
+  cerr << "Steady_State_Genetic_Algorithm: circuits of " << unit_num << " units are not built in, use "
+       << min_units << " to " << max_units << endl;
+  return 0;
+}
+
+#define INSTANTIATE_STAGES(UNITS) \
+  template void random_chromosome<UNITS>(gene_array<UNITS> *temp, CRandom *rng); \
+  template void tree_chromosome<UNITS>(gene_array<UNITS> *temp, CRandom *rng); \
+  template bool repair_chromosome<UNITS>(gene_array<UNITS> &genes, CRandom *rng); \
+  template bool valid_chromosome<UNITS>(gene_array<UNITS> *temp, CRandom *rng); \
+  template void create_chromosome_set<UNITS>(CPopulationN<UNITS> *parent_set, int set_num, \
+                                             CFitnessCacheN<UNITS> *cache, unsigned long seed, \
+                                             ga_acceptance *acceptance, ga_scratch *scratch); \
+  template void calculate_fitness_value<UNITS>(vector<double> *score, const CPopulationN<UNITS> &parent_set, \
+                                               double tolerance, int max_iterations, CFitnessCacheN<UNITS> *cache, \
+                                               vector<circuit_key<UNITS> > *keys, CMetrics *metrics, \
+                                               unsigned long *evaluations); \
+  template double best_parent2child<UNITS>(CPopulationN<UNITS> &child_set, const vector<double> &score, \
+                                           const CPopulationN<UNITS> &parent_set, int children); \
+  template int crossover<UNITS>(gene_array<UNITS> &father, gene_array<UNITS> &mother, CRandom *rng, \
+                                double probability); \
+  template void mutate<UNITS>(gene_array<UNITS> &before, CRandom *rng, double probability); \
+  template void evaluate_candidates<UNITS>(vector<ga_candidate<UNITS> > &candidates, CFitnessCacheN<UNITS> *cache, \
+                                           ga_scratch *scratch, ga_warm_start<UNITS> *warm, double threshold); \
+  template void evolve_generation<UNITS>(ga_population<UNITS> &population, int k);
+FOR_EACH_UNIT_COUNT(INSTANTIATE_STAGES)
+#undef INSTANTIATE_STAGES
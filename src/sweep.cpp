@@ -0,0 +1,402 @@
+/**
+ * @file    sweep.cpp
+ * @author  Galena Group
+ * @brief   Runs the genetic algorithm over a grid of parameter values, several seeded
+ *          replicates per grid point, on every core, and writes one CSV row per grid point
+ * @version 0.1
+ * @date    2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/Genetic_Algorithm.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+/** Parameters a sweep can vary, as named on the command line */
+static const char *parameter_names[] = {"parents", "children", "crossover", "mutate", "tolerance",
+                                        "iterations", "generations", "stall"};
+
+/**
+ * @brief   One parameter of the grid and the values it takes
+ */
+struct sweep_axis
+{
+    /** One of parameter_names */
+    string name;
+    /** Values, in the order given */
+    vector<double> values;
+};
+
+/**
+ * @brief   Parameters of one grid point
+ */
+struct sweep_point
+{
+    /** Parameters of the genetic algorithm */
+    ga_config config;
+    /** When its runs stop */
+    stopping_criteria stopping;
+    /** Value of every axis, in the order of the axes */
+    vector<double> values;
+};
+
+/**
+ * @brief   Outcome of one run of a grid point
+ */
+struct sweep_run
+{
+    /** Highest score */
+    double best_score = 0;
+    /** Generation in which the highest score was first reached */
+    int best_generation = 0;
+    /** Generations run */
+    int generations = 0;
+    /** Wall time of the run, the initial population included */
+    double seconds = 0;
+    /** Circuits simulated */
+    unsigned long evaluations = 0;
+};
+
+/**
+ * @brief   Progress callback keeping what a sweep reports about a run
+ *
+ * @param   progress        State of the run
+ * @param   user_data       sweep_run to fill
+ * @return  bool            always true
+ */
+static bool record(const ga_progress &progress, void *user_data)
+{
+    sweep_run *run = (sweep_run *)user_data;
+
+    if (progress.stalled == 0)
+        run->best_generation = progress.generation;
+    run->generations = progress.generation;
+    run->evaluations = progress.evaluations;
+    return true;
+}
+
+/**
+ * @brief   Read the values of an axis: numbers separated by commas, each either a value or
+ *          a range first:last:step that includes last
+ *
+ * @param   text        Values as given on the command line
+ * @param   values      Receives the values
+ * @return  bool        false if the text is not a list of values
+ */
+static bool parse_values(const string &text, vector<double> &values)
+{
+    size_t start = 0;
+
+    while (start <= text.size())
+    {
+        size_t comma = text.find(',', start);
+        string item = text.substr(start, comma == string::npos ? string::npos : comma - start);
+        double range[3];
+        int parts = 0;
+        size_t from = 0;
+
+        while (parts < 3)
+        {
+            char *end;
+            range[parts] = strtod(item.c_str() + from, &end);
+            if (end == item.c_str() + from)
+                return false;
+            parts++;
+            from = end - item.c_str();
+            if (item[from] != ':')
+                break;
+            from++;
+        }
+        if (from != item.size() || parts == 2)
+            return false;
+
+        if (parts == 1)
+            values.push_back(range[0]);
+        else if (range[2] > 0 && range[1] >= range[0])
+        {
+            // a step that does not divide the range evenly stops short of last
+            int steps = (int)floor((range[1] - range[0]) / range[2] + 1e-9);
+            for (int i = 0; i <= steps; i++)
+                values.push_back(range[0] + i * range[2]);
+        }
+        else
+            return false;
+
+        if (comma == string::npos)
+            break;
+        start = comma + 1;
+    }
+    return !values.empty();
+}
+
+/**
+ * @brief   Set one parameter of a grid point
+ *
+ * @param   point       Grid point
+ * @param   name        One of parameter_names
+ * @param   value       Value of the parameter
+ */
+static void set_parameter(sweep_point &point, const string &name, double value)
+{
+    if (name == "parents")
+        point.config.parents = (int)value;
+    else if (name == "children")
+        point.config.children = (int)value;
+    else if (name == "crossover")
+        point.config.crossover_probability = value;
+    else if (name == "mutate")
+        point.config.mutate_probability = value;
+    else if (name == "tolerance")
+        point.config.tolerance = value;
+    else if (name == "iterations")
+        point.config.max_iterations = (int)value;
+    else if (name == "generations")
+        point.stopping.max_generations = (int)value;
+    else if (name == "stall")
+        point.stopping.stall_generations = (int)value;
+}
+
+/**
+ * @brief   Every combination of the values of the axes, the last axis varying fastest
+ *
+ * @param   axes        Axes of the grid
+ * @param   base        Parameters of the axes not given and of the stopping criteria
+ * @return  vector      Grid points
+ */
+static vector<sweep_point> grid_points(const vector<sweep_axis> &axes, const sweep_point &base)
+{
+    vector<sweep_point> points(1, base);
+
+    for (size_t a = 0; a < axes.size(); a++)
+    {
+        vector<sweep_point> expanded;
+
+        for (size_t p = 0; p < points.size(); p++)
+        {
+            for (size_t v = 0; v < axes[a].values.size(); v++)
+            {
+                sweep_point point = points[p];
+                set_parameter(point, axes[a].name, axes[a].values[v]);
+                point.values.push_back(axes[a].values[v]);
+                expanded.push_back(point);
+            }
+        }
+        points.swap(expanded);
+    }
+    return points;
+}
+
+/**
+ * @brief   Write one row per grid point: the values of the axes, then over the replicates
+ *          the mean, standard deviation, lowest and highest best score, the fraction of
+ *          runs that reached the goal, and the mean generations to the best score,
+ *          generations, seconds and evaluations
+ *
+ * @param   out         Stream to write to
+ * @param   axes        Axes of the grid
+ * @param   points      Grid points
+ * @param   runs        Runs of every grid point, replicate by replicate
+ * @param   goal        Score a run must reach to count as reaching the goal
+ */
+static void write_results(ostream &out, const vector<sweep_axis> &axes, const vector<sweep_point> &points,
+                          const vector<vector<sweep_run> > &runs, double goal)
+{
+    streamsize precision = out.precision(10);
+
+    for (size_t a = 0; a < axes.size(); a++)
+        out << axes[a].name << ",";
+    out << "replicates,best_score_mean,best_score_sd,best_score_min,best_score_max,reached,"
+        << "generations_to_best_mean,generations_mean,seconds_mean,evaluations_mean" << endl;
+
+    for (size_t p = 0; p < points.size(); p++)
+    {
+        const vector<sweep_run> &replicates = runs[p];
+        double n = replicates.size();
+        double sum = 0, squares = 0, lowest = HUGE_VAL, highest = -HUGE_VAL;
+        double reached = 0, to_best = 0, generations = 0, seconds = 0, evaluations = 0;
+
+        for (size_t r = 0; r < replicates.size(); r++)
+        {
+            const sweep_run &run = replicates[r];
+
+            sum += run.best_score;
+            lowest = min(lowest, run.best_score);
+            highest = max(highest, run.best_score);
+            reached += run.best_score >= goal - 1e-6;
+            to_best += run.best_generation;
+            generations += run.generations;
+            seconds += run.seconds;
+            evaluations += run.evaluations;
+        }
+
+        // scores agree to many digits, so the deviations are summed after the mean
+        double mean = sum / n;
+        for (size_t r = 0; r < replicates.size(); r++)
+            squares += (replicates[r].best_score - mean) * (replicates[r].best_score - mean);
+        double sd = n > 1 ? sqrt(squares / (n - 1)) : 0;
+
+        for (size_t a = 0; a < axes.size(); a++)
+            out << points[p].values[a] << ",";
+        out << n << "," << mean << "," << sd << "," << lowest << "," << highest << "," << reached / n << ","
+            << to_best / n << "," << generations / n << "," << seconds / n << "," << evaluations / n << endl;
+    }
+    out.precision(precision);
+}
+
+/**
+ * @brief   Print how to run the sweep
+ *
+ * @param   program     Name of the program
+ */
+static void usage(const char *program)
+{
+    cerr << "usage: " << program << " [--units n] [--replicates r] [--seed s] [--target score] [--time seconds]"
+         << " [--threads n] [--output file] [name=values ...]" << endl
+         << "  name is one of";
+    for (const char *name : parameter_names)
+        cerr << " " << name;
+    cerr << endl << "  values are numbers separated by commas, each a value or first:last:step" << endl;
+}
+
+/**
+ * @brief   Run every grid point once per replicate. Runs are handed out one at a time to
+ *          whichever thread is free, each run on a single thread, so the cores stay busy
+ *          however long the runs of a grid point take. Replicate r of every grid point runs
+ *          with seed + r, and a seed gives the same result on any number of threads, so a
+ *          sweep gives the same results whatever --threads is.
+ *
+ * @return  int     0 if the results were written
+ */
+int main(int argc, char *argv[])
+{
+    int units = NUM_UNIT;
+    int replicates = 10;
+    unsigned long seed = 1;
+    int threads = 0;
+    const char *output = "sweep.csv";
+    sweep_point base;
+    vector<sweep_axis> axes;
+
+    // progress lines of runs going on side by side would interleave
+    base.config.print_interval = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *equals = strchr(argv[i], '=');
+
+        if (!strcmp(argv[i], "--units") && i + 1 < argc)
+            units = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--replicates") && i + 1 < argc)
+            replicates = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--target") && i + 1 < argc)
+            base.stopping.target_score = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+            base.stopping.time_budget = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            output = argv[++i];
+        else if (equals != NULL && argv[i][0] != '-')
+        {
+            sweep_axis axis;
+            axis.name.assign(argv[i], equals - argv[i]);
+            if (find_if(begin(parameter_names), end(parameter_names),
+                        [&axis](const char *name) { return axis.name == name; }) == end(parameter_names) ||
+                !parse_values(equals + 1, axis.values))
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            axes.push_back(axis);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    #if defined(Print) || defined(Metrics)
+      cerr << "sweep: built with Print or Metrics, every run writes the same file" << endl;
+    #endif
+
+    vector<sweep_point> points = grid_points(axes, base);
+    vector<vector<sweep_run> > runs(points.size(), vector<sweep_run>(replicates));
+    int run_num = points.size() * replicates;
+    int done = 0;
+    bool failed = false;
+
+    #ifdef _OPENMP
+      // a run started by the sweep evaluates on its own thread
+      omp_set_max_active_levels(1);
+      if (threads > 0)
+          omp_set_num_threads(threads);
+    #endif
+
+    // neighbouring runs belong to different grid points, so slow points are spread out
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int j = 0; j < run_num; j++)
+    {
+        int p = j % points.size();
+        int r = j / points.size();
+        sweep_run &run = runs[p][r];
+        auto start = chrono::steady_clock::now();
+
+        run.best_score = Genetic_Algorithm(seed + r, units, points[p].config, points[p].stopping,
+                                           checkpoint_settings(), record, &run);
+        run.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        #pragma omp critical(sweep_progress)
+        {
+            done++;
+            // a run that returns at once had parameters out of range or an unknown size
+            failed = failed || (run.best_score == 0 && run.generations == 0);
+            cerr << "[" << done << "/" << run_num << "] point " << p + 1 << " seed " << seed + r << ": "
+                 << run.best_score << " at generation " << run.best_generation << ", " << run.seconds << " s"
+                 << endl;
+        }
+    }
+
+    if (failed)
+    {
+        cerr << "sweep: some runs did not start, see the messages above" << endl;
+        return 1;
+    }
+
+    // without a target, a run reaches the goal if it finds the best circuit of the sweep
+    double goal = base.stopping.target_score;
+    double sweep_best = 0;
+    for (size_t p = 0; p < runs.size(); p++)
+    {
+        for (size_t r = 0; r < runs[p].size(); r++)
+            sweep_best = max(sweep_best, runs[p][r].best_score);
+    }
+    if (goal == 0)
+        goal = sweep_best;
+
+    ofstream file(output);
+    write_results(file, axes, points, runs, goal);
+    if (!file)
+    {
+        cerr << "sweep: cannot write " << output << endl;
+        return 1;
+    }
+    return 0;
+}
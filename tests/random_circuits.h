@@ -0,0 +1,37 @@
+/**
+ * @file random_circuits.h
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#pragma once
+
+#include <cstdlib>
+#include "../includes/CCircuit.h"
+
+/**
+ * @brief   Random valid circuit vector, drawn from rand() until it passes Check_Validity as
+ *          the genetic algorithm drew its parents before Repair, so that srand picks the sample
+ *
+ * @param   chromosome      Array of length 2 * num_units + 1 to fill
+ */
+static void random_valid_circuit(int *chromosome)
+{
+    do
+    {
+        chromosome[0] = rand() % num_units;
+        for (int i = 0; i < num_units; i++)
+        {
+            int conc, tails;
+            while ((conc = rand() % (num_units + 2)) == i)
+                ;
+            while ((tails = rand() % (num_units + 2)) == i || tails == conc)
+                ;
+            chromosome[i * 2 + 1] = conc;
+            chromosome[i * 2 + 2] = tails;
+        }
+    } while (!CCircuit(chromosome).Check_Validity());
+}
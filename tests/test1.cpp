@@ -27,10 +27,19 @@ int main(int argc, char *argv[])
     int vector3[2 * num_units + 1] = {7, 4, 3, 5, 9, 10, 6, 6, 8, 8, 1, 2, 4, 
                                     0, 2, 0, 11, 5, 7, 6, 2};
 
+    // valid test case - valid test case 1 with its units renumbered
+    int vector4[2 * num_units + 1] = {3, 1, 5, 2, 6, 10, 11, 7, 0, 10, 11, 6, 4,
+                                    10, 11, 9, 1, 10, 11, 8, 2};
+
+    // invalid test case 2 - units 8 and 9 only reach the concentrate outlet
+    int vector5[2 * num_units + 1] = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11,
+                                    7, 11, 8, 11, 10, 9, 10, 8};
+
     CCircuit circuit0(vector0);
     CCircuit circuit1(vector1);
     CCircuit circuit2(vector2);
     CCircuit circuit3(vector3);
+    CCircuit circuit4(vector4);
 
     std::cout << "Check validity of circuit0:" << std::endl;
     if (circuit0.Check_Validity())
@@ -56,4 +65,40 @@ int main(int argc, char *argv[])
     else
         std::cout << "fail" << std::endl;
 
+    std::cout << "Check canonical form of renumbered circuit0:" << std::endl;
+    if (circuit4.Check_Validity() && circuit0.Canonical_Key() == circuit4.Canonical_Key())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Check canonical form of circuit0 and circuit1 differ:" << std::endl;
+    if (circuit0.Canonical_Key() != circuit1.Canonical_Key())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Check validity of a circuit with units that cannot reach both outlets:" << std::endl;
+    if (CCircuit(vector5).Check_Validity())
+        std::cout << "fail" << std::endl;
+    else
+        std::cout << "pass" << std::endl;
+
+    // the same checks on genes read in place, one at a time and packed back to back
+    const int length = 2 * num_units + 1;
+    int *circuits[4] = {vector0, vector2, vector5, vector3};
+    unsigned char packed[4 * length];
+    bool valid[4];
+
+    for (int c = 0; c < 4; c++)
+        for (int i = 0; i < length; i++)
+            packed[c * length + i] = (unsigned char)circuits[c][i];
+
+    std::cout << "Check validity of genes in place:" << std::endl;
+    if (Validate_Genes<num_units>(gene_span<int>{vector0, length}) &&
+        !Validate_Genes<num_units>(gene_span<int>{vector5, length}) &&
+        !Validate_Genes<num_units>(gene_span<int>{vector0, length - 2}) &&
+        Validate_Batch<num_units>(packed, 4, valid) == 2 && valid[0] && !valid[1] && !valid[2] && valid[3])
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
 }
@@ -0,0 +1,76 @@
+/**
+ * @file test10.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <iostream>
+#include "../includes/CCircuit.h"
+#include "../includes/CPopulation.h"
+
+int main(int argc, char *argv[])
+{
+    int vec1[2 * num_units + 1] = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                                   10, 11, 10, 11, 10, 11, 10, 11};
+    int vec2[2 * num_units + 1] = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11,
+                                   7, 11, 8, 11, 9, 11, 10, 11};
+    int out[2 * num_units + 1];
+
+    CPopulation parents(3), children(2);
+    bool same = true;
+
+    parents.Set(1, vec1);
+    parents.Get(1, out);
+    for (int i = 0; i < CPopulation::length; i++)
+        same = same && out[i] == vec1[i] && parents[1][i] == vec1[i];
+
+    std::cout << "Set and Get round trip:" << std::endl;
+    if (same && parents.Size() == 3 && parents.Bytes() >= 3 * CPopulation::length)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // chromosomes are back to back, one byte per gene
+    std::cout << "Chromosomes are contiguous:" << std::endl;
+    if (parents[1] == parents[0] + CPopulation::length && parents[2] == parents[1] + CPopulation::length)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    children.Set(0, vec2);
+    children.Set(1, parents[1]);
+    const unsigned char *parent_genes = parents[0];
+    const unsigned char *child_genes = children[0];
+    parents.Swap(children);
+
+    std::cout << "Swap exchanges the buffers:" << std::endl;
+    if (parents.Size() == 2 && children.Size() == 3 && parents[0] == child_genes && children[0] == parent_genes &&
+        parents[0][2] == 11 && parents[1][2] == 2)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a population that shrinks and grows back keeps its buffer
+    children.Resize(1);
+    children.Resize(3);
+
+    std::cout << "Resize within capacity keeps the buffer:" << std::endl;
+    if (children[0] == parent_genes && children.Size() == 3)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // other sizes are packed the same way
+    int vec4[2 * 4 + 1] = {0, 1, 5, 2, 5, 3, 5, 4, 5};
+    CPopulationN<4> small(1);
+    small.Set(0, vec4);
+
+    std::cout << "Four unit population:" << std::endl;
+    if (CPopulationN<4>::length == 9 && small[0][8] == 5 && small[0][1] == 1)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
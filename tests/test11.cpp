@@ -0,0 +1,83 @@
+/**
+ * @file test11.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "../includes/CCircuit.h"
+#include "../includes/CFitnessCache.h"
+#include "../includes/Genetic_Algorithm.h"
+#include "../includes/Genetic_Algorithm_internal.h"
+
+/** Number of calls to operator new so far */
+static std::atomic<long> allocations(0);
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    void *memory = std::malloc(size > 0 ? size : 1);
+    if (memory == NULL)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+int main(int argc, char *argv[])
+{
+    int vec1[2 * num_units + 1] = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                                   10, 11, 10, 11, 10, 11, 10, 11};
+    int vec2[2 * num_units + 1] = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11,
+                                   7, 11, 8, 11, 9, 11, 10, 11};
+    circuit_key<num_units> packed2 = CFitnessCache::Make_Key(vec2);
+    CCircuit scratch;
+
+    long before = allocations;
+    double score1 = Evaluate_Genes(gene_span<int>{vec1, 2 * num_units + 1}, scratch);
+    double score2 = Evaluate_Genes(gene_span<unsigned char>{packed2.data(), packed2.size()}, scratch, NEWTON);
+    double short_span = Evaluate_Genes(gene_span<int>{vec1, 2 * num_units}, scratch);
+    long used = allocations - before;
+
+    std::cout << "Evaluate_Genes on int and packed genes:" << std::endl;
+    if (std::fabs(score1 + 979.269) < 0.01 && std::fabs(score2 - 57.7668) < 0.01 && short_span == -50000)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Evaluate_Genes does not allocate:" << std::endl;
+    if (used == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a small cache fills within the first generations, after which every insert evicts
+    ga_population<num_units> population(7);
+    population.cache = CFitnessCache(256);
+    create_chromosome_set<num_units>(&population.parent_set, NUM_PARENT, &population.cache, population.seed);
+
+    int k = 0;
+    for (; k < 50; k++)
+        evolve_generation(population, k);
+
+    before = allocations;
+    for (; k < 100; k++)
+        evolve_generation(population, k);
+    used = allocations - before;
+
+    std::cout << "Generations allocate nothing in steady state:" << std::endl;
+    if (used == 0 && population.cache.evictions > 0 && population.the_max_value > 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail " << used << " allocations" << std::endl;
+}
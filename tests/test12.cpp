@@ -0,0 +1,103 @@
+/**
+ * @file test12.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <iostream>
+#include "../includes/CCircuit.h"
+#include "../includes/CRandom.h"
+#include "../includes/Genetic_Algorithm.h"
+#include "../includes/Genetic_Algorithm_internal.h"
+
+/**
+ * @brief   Draw circuits of N units with a generator and count the valid ones
+ *
+ * @param   generator       Fills a chromosome from a random stream
+ * @param   draws           Number of circuits
+ * @return  int             Number of valid circuits
+ */
+template <int N, class Generator>
+static int valid_draws(Generator generator, int draws)
+{
+    int valid = 0;
+
+    for (int i = 0; i < draws; i++)
+    {
+        gene_array<N> genes;
+        CRandom rng(12, 0, i);
+
+        generator(&genes, &rng);
+        valid += Validate_Genes<N>(gene_span<int>{genes.data(), genes.size()});
+    }
+    return valid;
+}
+
+int main(int argc, char *argv[])
+{
+    const int draws = 2000;
+
+    std::cout << "Random trees are valid:" << std::endl;
+    if (valid_draws<4>(tree_chromosome<4>, draws) == draws && valid_draws<10>(tree_chromosome<10>, draws) == draws &&
+        valid_draws<32>(tree_chromosome<32>, draws) == draws)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Generated circuits are valid:" << std::endl;
+    if (valid_draws<4>(valid_chromosome<4>, draws) == draws && valid_draws<10>(valid_chromosome<10>, draws) == draws &&
+        valid_draws<32>(valid_chromosome<32>, draws) == draws)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // units 8 and 9 only reach the concentrate outlet
+    gene_array<num_units> dead_end = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11,
+                                      7, 11, 8, 11, 10, 9, 10, 8};
+    gene_array<num_units> repaired = dead_end;
+    circuit_reach reached = Circuit_Reach<num_units>(gene_span<int>{dead_end.data(), dead_end.size()});
+    CRandom rng(12, 1, 0);
+    int changed = 0;
+
+    std::cout << "Reachability of a circuit with dead ends:" << std::endl;
+    if (reached.all == 0x3ff && reached.from_feed == 0x3ff && reached.to_conc == 0x3ff && reached.to_tails == 0xff)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    bool mended = repair_chromosome<num_units>(repaired, &rng);
+    for (int i = 0; i < 2 * num_units + 1; i++)
+        changed += repaired[i] != dead_end[i];
+
+    std::cout << "Repair changes few genes:" << std::endl;
+    if (mended && changed >= 1 && changed <= 2 &&
+        Validate_Genes<num_units>(gene_span<int>{repaired.data(), repaired.size()}))
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a valid circuit is left as it is
+    gene_array<num_units> valid = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                                   10, 11, 10, 11, 10, 11, 10, 11};
+    gene_array<num_units> unchanged = valid;
+
+    std::cout << "Repair keeps valid circuits:" << std::endl;
+    if (repair_chromosome<num_units>(unchanged, &rng) && unchanged == valid)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // genes out of range, links to itself and products sent to the wrong outlet
+    gene_array<num_units> broken = {12, 0, 0, 11, 10, 3, 3, 4, 11, 5, 11, 6, 11,
+                                    7, 11, 8, 11, 9, 11, 10, 11};
+
+    std::cout << "Repair mends structural faults:" << std::endl;
+    if (repair_chromosome<num_units>(broken, &rng) &&
+        Validate_Genes<num_units>(gene_span<int>{broken.data(), broken.size()}))
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test13.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/Genetic_Algorithm.h"
+
+/**
+ * @brief   What a run reported through its progress callback
+ */
+struct progress_record
+{
+    /** Progress after the last generation */
+    ga_progress last;
+    /** Number of calls */
+    int calls = 0;
+    /** True if every call came one generation after the one before */
+    bool in_order = true;
+    /** True if the best score never fell */
+    bool never_worse = true;
+    /** Generation at which to ask the run to stop, 0 for never */
+    int stop_at = 0;
+};
+
+/**
+ * @brief   Progress callback recording what it is given
+ *
+ * @param   progress        State of the run
+ * @param   user_data       progress_record to fill
+ * @return  bool            false once the generation to stop at is reached
+ */
+static bool record(const ga_progress &progress, void *user_data)
+{
+    progress_record *run = (progress_record *)user_data;
+
+    run->in_order = run->in_order && progress.generation == run->calls + 1;
+    run->never_worse = run->never_worse && (run->calls == 0 || progress.best_score >= run->last.best_score);
+    run->calls++;
+    run->last = progress;
+    return run->stop_at == 0 || progress.generation < run->stop_at;
+}
+
+/**
+ * @brief   Run the genetic algorithm on seed 7 with some stopping criteria
+ *
+ * @param   stopping        Stopping criteria
+ * @param   run             Receives the progress
+ * @return  double          Score returned by the run
+ */
+static double run_with(const stopping_criteria &stopping, progress_record &run)
+{
+    return Genetic_Algorithm(7, num_units, stopping, record, &run);
+}
+
+int main(int argc, char *argv[])
+{
+    stopping_criteria stopping;
+    progress_record asked;
+    asked.stop_at = 20;
+    double score = run_with(stopping, asked);
+    double best_score = Circuit_Performance(asked.last.best_circuit, SUBSTITUTION, 1e-6, 1000);
+
+    // the callback is the one deciding, so the run was still going when it was called
+    std::cout << "Callback sees every generation and the best circuit:" << std::endl;
+    if (asked.calls == 20 && asked.in_order && asked.never_worse && asked.last.stop == RUNNING &&
+        score == asked.last.best_score && std::fabs(best_score - score) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    stopping.max_generations = 10;
+    progress_record limited;
+    run_with(stopping, limited);
+
+    std::cout << "Stop after max_generations:" << std::endl;
+    if (limited.calls == 10 && limited.last.stop == MAX_GENERATIONS)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    stopping.max_generations = MAX_EVOLUTIONS;
+    stopping.stall_generations = 30;
+    progress_record stalled;
+    run_with(stopping, stalled);
+
+    std::cout << "Stop when the best circuit stops improving:" << std::endl;
+    if (stalled.last.stop == STALLED && stalled.last.stalled == 30 && stalled.calls < MAX_EVOLUTIONS)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    stopping.stall_generations = 0;
+    stopping.target_score = 300;
+    progress_record reached;
+    score = run_with(stopping, reached);
+
+    std::cout << "Stop at the target score:" << std::endl;
+    if (reached.last.stop == TARGET_REACHED && score == reached.last.best_score && score >= 300 &&
+        reached.calls < MAX_EVOLUTIONS)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    stopping.target_score = 0;
+    stopping.min_diversity = 0.5;
+    progress_record collapsed;
+    run_with(stopping, collapsed);
+
+    std::cout << "Stop when the parents are mostly copies:" << std::endl;
+    if (collapsed.last.stop == LOW_DIVERSITY && collapsed.last.diversity < 0.5 && collapsed.calls < MAX_EVOLUTIONS)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    stopping.min_diversity = 0;
+    stopping.time_budget = 0.1;
+    progress_record timed;
+    run_with(stopping, timed);
+
+    std::cout << "Stop when the time budget runs out:" << std::endl;
+    if (timed.last.stop == OUT_OF_TIME && timed.last.elapsed >= 0.1 && timed.calls < MAX_EVOLUTIONS)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file test14.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cstdio>
+#include <iostream>
+#include "../includes/CRunLog.h"
+
+/**
+ * @brief   Genes of the circuit logged at a generation, made up so every record differs
+ *
+ * @param   generation      Generation
+ * @param   unit_count      Units in the circuit
+ * @param   genes           Array of 2 * unit_count + 1 genes to fill
+ */
+static void genes_of(int generation, int unit_count, unsigned char *genes)
+{
+    for (int i = 0; i < 2 * unit_count + 1; i++)
+        genes[i] = (generation + i) % (unit_count + 2);
+}
+
+/**
+ * @brief   Check a record holds what was logged at its generation
+ *
+ * @param   record          Record read back
+ * @param   generation      Generation it should hold
+ * @param   unit_count      Units in the circuit
+ * @return  bool            true if every field matches
+ */
+static bool holds(const run_log_record &record, int generation, int unit_count)
+{
+    unsigned char genes[2 * max_units + 1] = {0};
+    genes_of(generation, unit_count, genes);
+
+    bool same = record.generation == generation && record.best_score == generation * 0.5 &&
+                record.elapsed == generation * 1e-3 && record.stalled == generation % 7;
+    for (int i = 0; i < 2 * max_units + 1; i++)
+        same = same && record.genes[i] == genes[i];
+    return same;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = "test14.bin";
+    const int generations = 5000;
+    const int unit_count = 10;
+    unsigned char genes[2 * max_units + 1];
+
+    // a ring much smaller than the log wraps many times and makes Append wait for the writer
+    CRunLog log(16);
+    bool opened = log.Open(path, unit_count, 7);
+    for (int k = 1; k <= generations; k++)
+    {
+        genes_of(k, unit_count, genes);
+        log.Append(k, k * 0.5, k * 1e-3, k % 7, genes);
+    }
+    bool closed = log.Close();
+
+    std::cout << "Log every generation through a small ring:" << std::endl;
+    if (opened && closed && !log.Is_Open() && log.Size() == generations)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    CRunLogReader reader;
+    bool read = reader.Open(path);
+    bool same = read && reader.Size() == generations;
+    for (long i = 0; same && i < reader.Size(); i++)
+        same = holds(reader[i], i + 1, unit_count);
+
+    std::cout << "Read back every record in order:" << std::endl;
+    if (same && reader.Header().unit_count == unit_count && reader.Header().seed == 7 &&
+        reader.Header().record_size == 48)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    int chromosome[2 * unit_count + 1];
+    reader.Get_Genes(2999, chromosome);
+    genes_of(3000, unit_count, genes);
+    bool unpacked = true;
+    for (int i = 0; i < 2 * unit_count + 1; i++)
+        unpacked = unpacked && chromosome[i] == genes[i];
+
+    std::cout << "Random access by generation:" << std::endl;
+    if (unpacked && reader.Find(3000) == 2999 && holds(reader[2999], 3000, unit_count) && reader.Find(0) == -1 &&
+        reader.Find(generations + 1) == -1)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+    reader.Close();
+
+    // a log that skips generations is searched
+    log.Open(path, 4, 8);
+    for (int k = 10; k <= 1000; k += 10)
+    {
+        genes_of(k, 4, genes);
+        log.Append(k, k * 0.5, k * 1e-3, k % 7, genes);
+    }
+    log.Close();
+
+    // a run cut short leaves a partial record at the end
+    std::FILE *file = std::fopen(path, "ab");
+    std::fwrite(genes, 1, 20, file);
+    std::fclose(file);
+
+    std::cout << "Sparse log with a partial record:" << std::endl;
+    if (reader.Open(path) && reader.Size() == 100 && reader.Header().unit_count == 4 &&
+        reader.Find(370) == 36 && holds(reader[36], 370, 4) && reader.Find(375) == -1 && reader.Find(2) == -1)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+    reader.Close();
+
+    // anything else is refused
+    file = std::fopen(path, "wb");
+    std::fputs("0 1 2 3 4 4 5 6 7 7 8 8 9 10 11 10 11 10 11 10 11 24.8\n", file);
+    std::fclose(file);
+    bool refused = !reader.Open(path) && !reader.Open("no such file.bin") && !log.Open(path, max_units + 1, 0);
+
+    std::cout << "Refuse files that are not run logs:" << std::endl;
+    if (refused && reader.Size() == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+    std::remove(path);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file test15.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../includes/CCircuit.h"
+#include "../includes/CMetrics.h"
+#include "../includes/Genetic_Algorithm.h"
+#include "../includes/Genetic_Algorithm_internal.h"
+
+// the metrics are compiled out unless Metrics is defined, so this test is built with it
+// defined and linked with the build of the genetic algorithm that has it too
+#ifndef Metrics
+#error test15 must be built with Metrics defined
+#endif
+
+int main(int argc, char *argv[])
+{
+    // a unit of this circuit runs dry and has its feed reset in the first sweeps
+    int dry[2 * num_units + 1] = {1, 7, 11, 10, 6, 10, 8, 10, 0, 0, 9,
+                                  10, 3, 3, 11, 6, 2, 4, 11, 6, 5};
+    int vec1[2 * num_units + 1] = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                                   10, 11, 10, 11, 10, 11, 10, 11};
+    CCircuit circuit;
+
+    Evaluate_Genes(gene_span<int>{dry, 2 * num_units + 1}, circuit);
+    int dry_clamps = circuit.Last_Clamps();
+    Evaluate_Genes(gene_span<int>{vec1, 2 * num_units + 1}, circuit);
+
+    std::cout << "Count the feed resets of an evaluation:" << std::endl;
+    if (dry_clamps > 0 && circuit.Last_Clamps() == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // evaluations are counted from every thread
+    CMetrics counted;
+    #pragma omp parallel for
+    for (int i = 0; i < 10000; i++)
+        counted.Count_Evaluation(3, i % 10 != 0, i % 2, i % 5 == 0);
+
+    std::cout << "Count evaluations on every thread:" << std::endl;
+    if (counted.evaluations == 10000 && counted.sweeps == 30000 && counted.failures == 1000 &&
+        counted.clamps == 5000 && counted.aborted == 2000)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    ga_population<num_units> population(7);
+    CMetrics &metrics = population.metrics;
+    metrics.Start();
+    population.scratch.metrics = &metrics;
+    create_chromosome_set<num_units>(&population.parent_set, NUM_PARENT, &population.cache, population.seed,
+                                     &population.initial, &population.scratch);
+    for (int k = 0; k < 30; k++)
+        evolve_generation(population, k);
+    copy_acceptance(metrics.initial, population.initial);
+    copy_acceptance(metrics.children, population.children);
+    metrics.Stop();
+
+    // phases do not overlap, so they add up to the time since Start
+    double phases = 0;
+    bool all_timed = true;
+    for (int p = PHASE_INIT; p < phase_count; p++)
+    {
+        phases += metrics.Seconds((Metrics_Phase)p);
+        all_timed = all_timed && metrics.Seconds((Metrics_Phase)p) > 0;
+    }
+    phases += metrics.Seconds(PHASE_OTHER);
+
+    std::cout << "Time every phase of a run:" << std::endl;
+    if (all_timed && std::fabs(phases - metrics.Elapsed()) < 1e-9 && metrics.generations == 30 &&
+        metrics.fastest_generation > 0 && metrics.fastest_generation <= metrics.slowest_generation &&
+        metrics.generation_seconds <= metrics.Elapsed())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // every evaluation missed the cache once, and the cache holds what was not aborted
+    std::cout << "Count the evaluations of a run:" << std::endl;
+    if (metrics.evaluations > 0 && metrics.evaluations == population.cache.Size() + metrics.aborted &&
+        metrics.sweeps > metrics.evaluations && metrics.initial.drawn == population.initial.drawn &&
+        metrics.children.accepted == 30 * (NUM_CHILDREN - 1))
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::ostringstream json, csv;
+    metrics.Write_JSON(json);
+    metrics.Write_CSV(csv);
+    std::string evaluations = std::to_string(metrics.evaluations);
+
+    std::cout << "Export as JSON and CSV:" << std::endl;
+    if (json.str().find("\"solver\": {\"evaluations\": " + evaluations + ",") != std::string::npos &&
+        json.str().find("\"phase_seconds\": {\"total\": ") != std::string::npos &&
+        csv.str().find("section,name,value\n") == 0 &&
+        csv.str().find("\nsolver,evaluations," + evaluations + "\n") != std::string::npos &&
+        csv.str().find("\ngenerations,count,30\n") != std::string::npos)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
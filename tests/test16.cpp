@@ -0,0 +1,146 @@
+/**
+ * @file test16.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/Genetic_Algorithm.h"
+
+/**
+ * @brief   What a run reported through its progress callback, generation by generation
+ */
+struct trajectory
+{
+    /** Progress after every generation, in order */
+    std::vector<ga_progress> generations;
+    /** Generation after which to copy the checkpoint as a killed run would leave it, 0 for never */
+    int kill_at = 0;
+    /** Checkpoint the run writes */
+    const char *checkpoint = NULL;
+    /** Where to copy the checkpoint */
+    const char *left_behind = NULL;
+};
+
+/**
+ * @brief   Copy a file
+ *
+ * @param   from        File to copy
+ * @param   to          Copy to write
+ */
+static void copy_file(const char *from, const char *to)
+{
+    std::ifstream source(from, std::ios::binary);
+    std::ofstream copy(to, std::ios::binary);
+    copy << source.rdbuf();
+}
+
+/**
+ * @brief   Progress callback recording every generation
+ *
+ * @param   progress        State of the run
+ * @param   user_data       trajectory to fill
+ * @return  bool            always true
+ */
+static bool record(const ga_progress &progress, void *user_data)
+{
+    trajectory *run = (trajectory *)user_data;
+
+    run->generations.push_back(progress);
+    if (progress.generation == run->kill_at)
+        copy_file(run->checkpoint, run->left_behind);
+    return true;
+}
+
+/**
+ * @brief   Check two runs went through the same generations
+ *
+ * @param   full        Run that was never stopped
+ * @param   resumed     Run resumed from a checkpoint
+ * @param   from        First generation of the resumed run
+ * @return  bool        true if every generation of the resumed run matches
+ */
+static bool same_generations(const trajectory &full, const trajectory &resumed, int from)
+{
+    bool same = !resumed.generations.empty() &&
+                resumed.generations.size() + from - 1 == full.generations.size();
+
+    for (size_t i = 0; same && i < resumed.generations.size(); i++)
+    {
+        const ga_progress &a = full.generations[from - 1 + i];
+        const ga_progress &b = resumed.generations[i];
+        same = a.generation == b.generation && a.best_score == b.best_score && a.best_circuit == b.best_circuit &&
+               a.stalled == b.stalled && a.diversity == b.diversity;
+    }
+    return same;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = "test16.bin";
+    const char *killed = "test16_killed.bin";
+    stopping_criteria stopping;
+    checkpoint_settings checkpoint;
+    stopping.max_generations = 60;
+    checkpoint.file = path;
+    checkpoint.interval = 20;
+
+    // a run that is never stopped, leaving the checkpoint of generation 40 behind at generation 45
+    trajectory full;
+    full.kill_at = 45;
+    full.checkpoint = path;
+    full.left_behind = killed;
+    double full_score = Genetic_Algorithm(7, num_units, stopping, checkpoint, record, &full);
+
+    std::ifstream temporary(std::string(path) + ".tmp");
+    std::cout << "Write checkpoints atomically:" << std::endl;
+    if (full.generations.size() == 60 && std::ifstream(path).good() && std::ifstream(killed).good() &&
+        !temporary.good())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // resuming the run killed after generation 45 breeds generations 41 to 60 again
+    trajectory resumed;
+    double resumed_score = Resume_Genetic_Algorithm(killed, record, &resumed);
+
+    std::cout << "Resume bit-identically from the last checkpoint:" << std::endl;
+    if (same_generations(full, resumed, 41) && resumed_score == full_score)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the checkpoint written when the run stopped holds a finished run
+    trajectory finished;
+    double finished_score = Resume_Genetic_Algorithm(path, record, &finished);
+
+    std::cout << "Resume a finished run:" << std::endl;
+    if (finished.generations.empty() && finished_score == full_score)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a damaged or missing checkpoint is refused
+    std::fstream damaged(killed, std::ios::in | std::ios::out | std::ios::binary);
+    damaged.seekp(100);
+    damaged.put('\x7f');
+    damaged.close();
+    trajectory refused;
+
+    std::cout << "Refuse damaged checkpoints:" << std::endl;
+    if (Resume_Genetic_Algorithm(killed, record, &refused) == 0 &&
+        Resume_Genetic_Algorithm("no such checkpoint.bin", record, &refused) == 0 && refused.generations.empty())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::remove(path);
+    std::remove(killed);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file test17.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/Genetic_Algorithm.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * @brief   What a run reported through its progress callback
+ */
+struct progress_record
+{
+    /** Progress after the last generation */
+    ga_progress last;
+    /** Number of calls */
+    int calls = 0;
+    /** True if the best score never fell */
+    bool never_worse = true;
+};
+
+/**
+ * @brief   Progress callback recording what it is given
+ *
+ * @param   progress        State of the run
+ * @param   user_data       progress_record to fill
+ * @return  bool            always true
+ */
+static bool record(const ga_progress &progress, void *user_data)
+{
+    progress_record *run = (progress_record *)user_data;
+
+    run->never_worse = run->never_worse && (run->calls == 0 || progress.best_score >= run->last.best_score);
+    run->calls++;
+    run->last = progress;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    double exact = 375.495;
+    unsigned long seed = 6;
+    stopping_criteria stopping;
+    stopping.target_score = exact;
+
+    #ifdef _OPENMP
+      omp_set_num_threads(1);
+    #endif
+    progress_record serial;
+    double serial_score = Steady_State_Genetic_Algorithm(seed, num_units, stopping, record, &serial);
+
+    #ifdef _OPENMP
+      omp_set_num_threads(4);
+    #endif
+    progress_record parallel;
+    double parallel_score = Steady_State_Genetic_Algorithm(seed, num_units, stopping, record, &parallel);
+
+    std::cout << "Reach the best circuit with the steady-state engine:" << std::endl;
+    if (serial_score >= exact && serial.last.stop == TARGET_REACHED && serial.never_worse)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a seed must give the same result on any number of threads
+    std::cout << "Same run on one and on four threads:" << std::endl;
+    if (serial_score == parallel_score && serial.calls == parallel.calls &&
+        serial.last.best_circuit == parallel.last.best_circuit)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // members keep the scores they were evaluated with
+    double evaluated = Circuit_Performance(serial.last.best_circuit, SOLVER, 1e-6, 1000);
+    std::cout << "Score of the best member:" << std::endl;
+    if (std::fabs(evaluated - serial_score) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // stopping criteria count generations of NUM_CHILDREN - 1 children
+    progress_record short_run;
+    stopping_criteria ten;
+    ten.max_generations = 10;
+    Steady_State_Genetic_Algorithm(seed, num_units, ten, record, &short_run);
+
+    std::cout << "Stop after a number of generations:" << std::endl;
+    if (short_run.calls == 10 && short_run.last.stop == MAX_GENERATIONS && short_run.last.generation == 10)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file test18.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/Genetic_Algorithm.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * @brief   What a run reported through its progress callback, generation by generation
+ */
+struct trajectory
+{
+    /** Progress after every generation, in order */
+    std::vector<ga_progress> generations;
+};
+
+/**
+ * @brief   Progress callback recording every generation
+ *
+ * @param   progress        State of the run
+ * @param   user_data       trajectory to fill
+ * @return  bool            always true
+ */
+static bool record(const ga_progress &progress, void *user_data)
+{
+    ((trajectory *)user_data)->generations.push_back(progress);
+    return true;
+}
+
+/**
+ * @brief   Check two runs went through the same generations
+ *
+ * @param   a       One run
+ * @param   b       Another run
+ * @return  bool    true if every generation matches
+ */
+static bool same_generations(const trajectory &a, const trajectory &b)
+{
+    bool same = !a.generations.empty() && a.generations.size() == b.generations.size();
+
+    for (size_t i = 0; same && i < a.generations.size(); i++)
+    {
+        same = a.generations[i].best_score == b.generations[i].best_score &&
+               a.generations[i].best_circuit == b.generations[i].best_circuit &&
+               a.generations[i].diversity == b.generations[i].diversity &&
+               a.generations[i].evaluations == b.generations[i].evaluations;
+    }
+    return same;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long seed = 9;
+    stopping_criteria stopping;
+    stopping.max_generations = 40;
+
+    // the default config holds the parameters of Genetic_Algorithm.h
+    trajectory built_in, configured;
+    double built_in_score = Genetic_Algorithm(seed, num_units, stopping, record, &built_in);
+    double configured_score = Genetic_Algorithm(seed, num_units, ga_config(), stopping, checkpoint_settings(),
+                                                record, &configured);
+
+    std::cout << "Default config runs as the parameters of the build:" << std::endl;
+    if (same_generations(built_in, configured) && built_in_score == configured_score)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a smaller population with other probabilities gives the same result on any number of threads
+    ga_config small;
+    small.parents = 60;
+    small.children = 40;
+    small.crossover_probability = 0.8;
+    small.mutate_probability = 0.05;
+    small.print_interval = 0;
+
+    #ifdef _OPENMP
+      omp_set_num_threads(1);
+    #endif
+    trajectory serial;
+    double serial_score = Genetic_Algorithm(seed, num_units, small, stopping, checkpoint_settings(), record, &serial);
+
+    #ifdef _OPENMP
+      omp_set_num_threads(4);
+    #endif
+    trajectory parallel;
+    double parallel_score = Genetic_Algorithm(seed, num_units, small, stopping, checkpoint_settings(), record,
+                                              &parallel);
+
+    std::cout << "Same run of a config on one and on four threads:" << std::endl;
+    if (same_generations(serial, parallel) && serial_score == parallel_score && serial_score > 0 &&
+        !same_generations(serial, configured))
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // fewer children are fewer circuits to simulate
+    std::cout << "Simulate fewer circuits with fewer children:" << std::endl;
+    if (serial.generations.back().evaluations < configured.generations.back().evaluations)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // without crossover or mutation every child is a copy of a parent the cache holds
+    ga_config copies = small;
+    copies.crossover_probability = 0;
+    copies.mutate_probability = 0;
+    trajectory cloned;
+    Genetic_Algorithm(seed, num_units, copies, stopping, checkpoint_settings(), record, &cloned);
+
+    std::cout << "Breed copies without crossover or mutation:" << std::endl;
+    if (cloned.generations.size() == 40 && cloned.generations.front().evaluations > 0 &&
+        cloned.generations.back().evaluations == cloned.generations.front().evaluations)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // parameters out of range are refused before the run starts
+    ga_config one_parent, certain;
+    one_parent.parents = 1;
+    certain.crossover_probability = 1.5;
+    trajectory refused;
+
+    std::cout << "Refuse parameters out of range:" << std::endl;
+    if (Genetic_Algorithm(seed, num_units, one_parent, stopping, checkpoint_settings(), record, &refused) == 0 &&
+        Genetic_Algorithm(seed, num_units, certain, stopping, checkpoint_settings(), record, &refused) == 0 &&
+        refused.generations.empty())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file test19.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "random_circuits.h"
+
+/**
+ * @brief   Check that no component feeds a component before it
+ *
+ * @param   chromosome      Circuit vector
+ * @param   components      Units of every component, upstream components first
+ * @param   count           Number of components
+ * @return  bool            true if every unit is in one component and every link goes downstream
+ */
+static bool topological(const int *chromosome, const std::uint32_t *components, int count)
+{
+    int component_of[num_units];
+    std::uint32_t covered = 0;
+
+    for (int c = 0; c < count; c++)
+    {
+        if (covered & components[c])
+            return false;
+        covered |= components[c];
+        for (int n = 0; n < num_units; n++)
+            if (components[c] >> n & 1)
+                component_of[n] = c;
+    }
+    if (covered != ((std::uint32_t)1 << num_units) - 1)
+        return false;
+
+    for (int n = 0; n < num_units; n++)
+    {
+        for (int k = 1; k <= 2; k++)
+        {
+            int next = chromosome[2 * n + k];
+            if (next < num_units && component_of[next] < component_of[n])
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int vec1[2 * num_units + 1] = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                                   10, 11, 10, 11, 10, 11, 10, 11};
+    int vec2[2 * num_units + 1] = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11,
+                                   7, 11, 8, 11, 9, 11, 10, 11};
+    // heavy recycle - substitution needs hundreds of sweeps
+    int vec3[2 * num_units + 1] = {1, 9, 5, 5, 11, 0, 7, 10, 2, 3, 7, 1, 8, 2,
+                                   4, 9, 1, 5, 3, 2, 6};
+    // fails Check_Validity: units 1 to 3 and 5 to 9 never reach an outlet so there is no steady state
+    int vec4[2 * num_units + 1] = {0, 10, 4, 2, 3, 3, 1, 1, 2, 11, 5, 6, 1,
+                                   7, 1, 8, 1, 9, 1, 1, 2};
+
+    // a feed-forward circuit is computed in a single pass over its units
+    CCircuit components1(vec1), components2(vec2);
+    components1.Set_Solver(COMPONENTS);
+    components2.Set_Solver(COMPONENTS);
+
+    std::cout << "Component solver on test2 circuits:" << std::endl;
+    if (std::fabs(components1.Evaluate_Circuit(1e-8, 1000) + 979.269) < 0.01 &&
+        std::fabs(components2.Evaluate_Circuit(1e-8, 1000) - 57.7668) < 0.01 &&
+        components1.Last_Unit_Updates() == num_units && components1.Last_Iterations() == 0 &&
+        components2.Last_Unit_Updates() == num_units)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // components come in the order material flows through them
+    std::uint32_t parts[num_units];
+    int count1 = components1.Components(parts);
+    bool ordered = count1 == num_units && topological(vec1, parts, count1);
+    CCircuit recycle(vec3), substitution3(vec3);
+    int count3 = recycle.Components(parts);
+    ordered = ordered && topological(vec3, parts, count3);
+
+    srand(19);
+    std::vector<std::vector<int> > population(200, std::vector<int>(2 * num_units + 1));
+    for (size_t i = 0; i < population.size(); i++)
+    {
+        random_valid_circuit(population[i].data());
+        CCircuit circuit(population[i].data());
+        int count = circuit.Components(parts);
+        ordered = ordered && topological(population[i].data(), parts, count);
+    }
+
+    std::cout << "Strongly connected components in topological order:" << std::endl;
+    if (ordered)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a circuit that is one loop throughout is swept as substitution sweeps it
+    recycle.Set_Solver(COMPONENTS);
+    double substitution_score = substitution3.Evaluate_Circuit(1e-8, 1000);
+    double components_score = recycle.Evaluate_Circuit(1e-8, 1000);
+
+    std::cout << "Component solver on a recycle circuit:" << std::endl;
+    if (std::fabs(substitution_score - components_score) < 0.01 && count3 == 1 &&
+        recycle.Last_Unit_Updates() == substitution3.Last_Unit_Updates())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the steady state is the one substitution finds, with less work
+    bool same = true;
+    long substitution_updates = 0, components_updates = 0;
+    CCircuit scratch;
+    for (size_t i = 0; i < population.size(); i++)
+    {
+        gene_span<int> genes = {population[i].data(), population[i].size()};
+        double full = Evaluate_Genes(genes, scratch, SUBSTITUTION, NULL, 1e-8, 1000);
+        substitution_updates += scratch.Last_Unit_Updates();
+        double split = Evaluate_Genes(genes, scratch, COMPONENTS, NULL, 1e-8, 1000);
+        components_updates += scratch.Last_Unit_Updates();
+
+        same = same && (full == -50000) == (split == -50000) && std::fabs(full - split) < 0.01;
+    }
+
+    std::cout << "Same scores as substitution on random valid circuits:" << std::endl;
+    if (same && components_updates < substitution_updates)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // 32 units in a chain with a loop of two near the end: only the loop is swept
+    const int size = 32;
+    int chain[2 * size + 1];
+    chain[0] = 0;
+    for (int n = 0; n < size; n++)
+    {
+        chain[2 * n + 1] = n + 1;
+        chain[2 * n + 2] = size + 1;
+    }
+    chain[2 * 30 + 2] = 29;
+    CCircuitN<size> chain_substitution(chain), chain_components(chain);
+    chain_components.Set_Solver(COMPONENTS);
+    double chain_full = chain_substitution.Evaluate_Circuit(1e-8, 1000);
+    double chain_split = chain_components.Evaluate_Circuit(1e-8, 1000);
+    int loop_sweeps = chain_components.Last_Iterations();
+
+    std::cout << "Sweep only the loop of a large circuit:" << std::endl;
+    if (chain_components.Check_Validity() && std::fabs(chain_full - chain_split) < 0.01 &&
+        chain_components.Last_Unit_Updates() == size - 2 + 2 * loop_sweeps &&
+        chain_components.Last_Unit_Updates() < chain_substitution.Last_Unit_Updates() / 4)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a loop without a steady state does not converge
+    CCircuit no_steady_state(vec4);
+    no_steady_state.Set_Solver(COMPONENTS);
+
+    std::cout << "Component solver without a steady state:" << std::endl;
+    if (no_steady_state.Evaluate_Circuit() == -50000)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test20.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/CSparseCircuit.h"
+
+/**
+ * @brief   Sparse circuit vector of a circuit vector
+ *
+ * @param   chromosome      Circuit vector
+ * @return  std::vector     The same genes as Index
+ */
+template <class Index>
+static std::vector<Index> sparse_genes(const std::vector<int> &chromosome)
+{
+    return std::vector<Index>(chromosome.begin(), chromosome.end());
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<int> vec1 = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9, 10, 11, 10, 11, 10, 11, 10, 11};
+    std::vector<int> vec2 = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11, 7, 11, 8, 11, 9, 11, 10, 11};
+    // heavy recycle - substitution needs hundreds of sweeps
+    std::vector<int> vec3 = {1, 9, 5, 5, 11, 0, 7, 10, 2, 3, 7, 1, 8, 2, 4, 9, 1, 5, 3, 2, 6};
+
+    CSparseCircuit sparse1(sparse_genes<std::uint32_t>(vec1)), sparse2(sparse_genes<std::uint32_t>(vec2));
+    CSparseCircuit16 sparse3(sparse_genes<std::uint16_t>(vec3));
+    CCircuit circuit3(vec3);
+
+    // a feed-forward circuit settles in one sweep and the next finds nothing changing
+    std::cout << "Sparse circuit on test2 circuits:" << std::endl;
+    if (std::fabs(sparse1.Evaluate_Circuit() + 979.269) < 0.01 && sparse1.Last_Iterations() == 2 &&
+        std::fabs(sparse2.Evaluate_Circuit() - 57.7668) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Gauss-Seidel sweeps on a recycle circuit:" << std::endl;
+    if (std::fabs(sparse3.Evaluate_Circuit(1e-10, 1000) - circuit3.Evaluate_Circuit(1e-8, 1000)) < 0.01 &&
+        sparse3.Last_Iterations() < circuit3.Last_Iterations())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // random circuits with a few mutations, valid or not, are judged and scored as CCircuit does
+    CRandom rng(20);
+    bool same = true;
+    int valid_num = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        std::vector<std::uint32_t> genes;
+        Sparse_Random_Circuit(genes, num_units, &rng, 0.5);
+        for (int m = i % 4; m > 0; m--)
+            Sparse_Mutate(genes, &rng);
+
+        std::vector<int> chromosome(genes.begin(), genes.end());
+        CCircuit circuit(chromosome);
+        CSparseCircuit sparse(genes);
+        bool valid = circuit.Check_Validity();
+
+        same = same && sparse.Check_Validity() == valid;
+        if (valid)
+        {
+            double dense_score = circuit.Evaluate_Circuit(1e-8, 1000);
+            double sparse_score = sparse.Evaluate_Circuit(1e-10, 1000);
+            same = same && (dense_score == -50000 ? sparse_score == -50000 || circuit.Last_Iterations() == 1000
+                                                  : std::fabs(dense_score - sparse_score) < 0.01);
+            valid_num++;
+        }
+    }
+
+    std::cout << "Same validity and scores as CCircuit:" << std::endl;
+    if (same && valid_num > 500 && valid_num < 2000)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // thousands of units, with either width of index
+    std::vector<std::uint16_t> genes16;
+    std::vector<std::uint32_t> genes32;
+    CRandom draw16(7), draw32(7);
+    Sparse_Random_Circuit(genes16, 5000, &draw16, 0.1);
+    Sparse_Random_Circuit(genes32, 5000, &draw32, 0.1);
+    CSparseCircuit16 large16(genes16);
+    CSparseCircuit large32(genes32);
+    double score16 = large16.Evaluate_Circuit();
+
+    std::cout << "Random circuit of 5000 units:" << std::endl;
+    if (large16.Units() == 5000 && large16.Check_Validity() && large32.Check_Validity() && score16 != -50000 &&
+        score16 == large32.Evaluate_Circuit() && large16.Bytes() < large32.Bytes())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // 16-bit indices number the streams of up to 32767 units
+    std::vector<std::uint16_t> too_large(2 * 32768 + 1, 0);
+    CSparseCircuit16 refused;
+
+    std::cout << "Refuse circuits too large for the index:" << std::endl;
+    if (CSparseCircuit16::Max_Units() == 32767 && !refused.Assign(too_large.data(), too_large.size()) &&
+        refused.Units() == 0 && refused.Evaluate_Circuit() == -50000)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // mutation and crossover keep to the genes each position allows, so a short run of
+    // mutations kept when they score better improves a large circuit
+    CRandom operators(3);
+    std::vector<std::uint32_t> best;
+    Sparse_Random_Circuit(best, 300, &operators, 0.1);
+    CSparseCircuit climber(best);
+    double first_score = climber.Evaluate_Circuit();
+    double best_score = first_score;
+    bool allowed = true;
+
+    for (int step = 0; step < 400; step++)
+    {
+        std::vector<std::uint32_t> child = best, other;
+        Sparse_Random_Circuit(other, 300, &operators, 0.1);
+        int swapped = Sparse_Crossover(child, other, &operators);
+        allowed = allowed && swapped < (int)child.size();
+        child = best;
+
+        int gene = Sparse_Mutate(child, &operators);
+        if (gene > 0)
+        {
+            int unit = (gene - 1) / 2;
+            allowed = allowed && (int)child[gene] != unit && child[gene] <= 301 &&
+                      (gene % 2 == 1 ? child[gene] != 301 && child[gene] != child[gene + 1]
+                                     : child[gene] != 300 && child[gene] != child[gene - 1]);
+        }
+
+        climber.Assign(child.data(), child.size());
+        if (!climber.Check_Validity())
+            continue;
+        double score = climber.Evaluate_Circuit();
+        if (score > best_score)
+        {
+            best = child;
+            best_score = score;
+        }
+    }
+
+    std::cout << "Mutation and crossover on a circuit of 300 units:" << std::endl;
+    if (allowed && best_score > first_score)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file test21.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/CCircuitBatch.h"
+#include "../includes/CFitnessCache.h"
+#include "../includes/CPopulation.h"
+#include "../includes/Genetic_Algorithm.h"
+#include "../includes/Genetic_Algorithm_internal.h"
+#include "random_circuits.h"
+
+// screening is compiled out unless Screening is defined, so this test is built with it
+// defined and linked with the build of the genetic algorithm that has it too
+#ifndef Screening
+#error test21 must be built with Screening defined
+#endif
+
+/**
+ * @brief   Best scores a run reported, generation by generation
+ */
+struct best_scores
+{
+    /** Best score and circuit after every generation, in order */
+    std::vector<ga_progress> generations;
+};
+
+/**
+ * @brief   Progress callback recording every generation
+ *
+ * @param   progress        State of the run
+ * @param   user_data       best_scores to fill
+ * @return  bool            always true
+ */
+static bool record(const ga_progress &progress, void *user_data)
+{
+    ((best_scores *)user_data)->generations.push_back(progress);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::vector<int> > population = {
+        {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9, 10, 11, 10, 11, 10, 11, 10, 11},
+        {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11, 7, 11, 8, 11, 9, 11, 10, 11}};
+
+    // random valid circuits, not a multiple of the lanes so the last group is padded
+    srand(3);
+    while (population.size() < 1003)
+    {
+        std::vector<int> chromosome(2 * num_units + 1);
+        random_valid_circuit(chromosome.data());
+        population.push_back(chromosome);
+    }
+
+    CCircuitBatch batch(population);
+    std::vector<double> exact(batch.Size()), screened(batch.Size());
+    batch.Evaluate_Circuits(exact.data(), TOLERANCE, MAX_ITERATIONS);
+    batch.Screen_Circuits(screened.data(), SCREEN_TOLERANCE, MAX_ITERATIONS);
+
+    std::cout << "Screening of test2 circuits:" << std::endl;
+    if (std::fabs(screened[0] + 979.269) < 0.1 && std::fabs(screened[1] - 57.7668) < 0.1)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // single precision may settle a circuit that double precision finds creeping on, but seldom
+    std::cout << "Screened scores are within SCREEN_MARGIN of double precision:" << std::endl;
+    int far = 0, both = 0, disagree = 0, failures = 0;
+    for (size_t i = 0; i < population.size(); i++)
+    {
+        failures += exact[i] == -50000;
+        if ((exact[i] == -50000) != (screened[i] == -50000))
+            disagree++;
+        else if (exact[i] != -50000)
+        {
+            both++;
+            far += std::fabs(screened[i] - exact[i]) > SCREEN_MARGIN;
+        }
+    }
+    if (far == 0 && both > 100 && failures > 0 && disagree < (int)population.size() / 50)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a screened score is found like any other but is not exact until it is replaced
+    CFitnessCache cache(10);
+    circuit_key<num_units> key = CFitnessCache::Make_Key(population[1].data());
+    circuit_key<num_units> other = CFitnessCache::Make_Key(population[0].data());
+    double score = 0;
+
+    cache.Insert_Screened(key, screened[1]);
+    bool found = cache.Find(key, score) && score == screened[1] && !cache.Exact(key) && !cache.Exact(other);
+    double flows[2 * num_units] = {};
+    bool has_flows = cache.Find_Flows(key, flows);
+    cache.Insert(key, exact[1]);
+    found = found && cache.Find(key, score) && score == exact[1] && cache.Exact(key);
+
+    std::cout << "Fitness cache tells screened scores from exact ones:" << std::endl;
+    if (found && !has_flows)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the initial population is chosen on screened scores, the close calls refined
+    CPopulation parents;
+    CFitnessCache parent_cache(CACHE_SIZE);
+    ga_scratch scratch;
+    create_chromosome_set<num_units>(&parents, 50, &parent_cache, 7, NULL, &scratch);
+
+    int wrong = 0;
+    for (int i = 0; i < parents.Size(); i++)
+    {
+        int genes[2 * num_units + 1];
+        parents.Get(i, genes);
+        CCircuit circuit(genes);
+        circuit.Set_Solver(SOLVER);
+        wrong += circuit.Evaluate_Circuit(TOLERANCE, MAX_ITERATIONS) <= 50;
+    }
+
+    std::cout << "Screen, refine and audit the initial population:" << std::endl;
+    if (wrong == 0 && scratch.screening.screened > 0 && scratch.screening.refined > 0 &&
+        scratch.screening.audited > 0 && scratch.screening.audited_flips <= scratch.screening.audited / 10)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the best score of every generation is an exact evaluation of the best circuit
+    best_scores run;
+    stopping_criteria stopping;
+    stopping.max_generations = 100;
+    Genetic_Algorithm(7, num_units, stopping, record, &run);
+
+    int inexact = 0;
+    for (size_t k = 0; k < run.generations.size(); k++)
+    {
+        CCircuit circuit(run.generations[k].best_circuit);
+        circuit.Set_Solver(SOLVER);
+        double exact = circuit.Evaluate_Circuit(TOLERANCE, MAX_ITERATIONS);
+        inexact += std::fabs(run.generations[k].best_score - exact) > 1e-3;
+    }
+
+    std::cout << "Best score of a screened run is exact:" << std::endl;
+    if (run.generations.size() == 100 && inexact == 0 && run.generations.back().best_score > 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file test22.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/CCircuitBatch.h"
+#include "random_circuits.h"
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::vector<int> > population = {
+        {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9, 10, 11, 10, 11, 10, 11, 10, 11},
+        {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11, 7, 11, 8, 11, 9, 11, 10, 11}};
+
+    srand(2);
+    while (population.size() < 41)
+    {
+        std::vector<int> chromosome(2 * num_units + 1);
+        random_valid_circuit(chromosome.data());
+        population.push_back(chromosome);
+    }
+
+    // five scenarios, so the last lane group is padded: the default, two other feeds,
+    // the kinetics and holdup traded against each other, and double the prices
+    std::vector<circuit_scenario> scenarios(5);
+    scenarios[1].feed_conc = 8;
+    scenarios[1].feed_tails = 120;
+    scenarios[2].feed_conc = 14;
+    scenarios[2].feed_tails = 90;
+    scenarios[3].rate_conc = 2 * K_conc;
+    scenarios[3].rate_tails = 2 * K_tails;
+    scenarios[3].volume = V / 2;
+    scenarios[4].conc_price = 200;
+    scenarios[4].tails_cost = 1000;
+
+    const int count = scenarios.size();
+    CCircuitBatch batch(population);
+    std::vector<double> scores(batch.Size() * count);
+    std::vector<double> expected(batch.Size());
+    batch.Evaluate_Scenarios(scenarios, scores.data(), 1e-8, 1000);
+    batch.Evaluate_Circuits(expected.data(), 1e-8, 1000);
+
+    std::cout << "Default scenario scores as Evaluate_Circuits:" << std::endl;
+    int mismatches = 0, failures = 0;
+    for (int c = 0; c < batch.Size(); c++)
+    {
+        failures += expected[c] == -50000;
+        if (scores[c * count] != expected[c])
+            mismatches++;
+    }
+    if (mismatches == 0 && failures > 0 && failures < batch.Size() &&
+        std::fabs(scores[0] + 979.269) < 0.01 && std::fabs(scores[count] - 57.7668) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the constructor feed gives the reference for the other feeds
+    std::cout << "Scenario feeds score as the constructor feed:" << std::endl;
+    mismatches = 0;
+    for (int c = 0; c < batch.Size(); c++)
+    {
+        for (int s = 1; s <= 2; s++)
+        {
+            CCircuit circuit(population[c], 1e-8, 1000, scenarios[s].feed_conc, scenarios[s].feed_tails);
+            if (std::fabs(scores[c * count + s] - circuit.Evaluate_Circuit()) > 1e-9)
+                mismatches++;
+        }
+    }
+    if (mismatches == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // recovery depends on the rate constant times the residence time only, and the
+    // score is linear in the prices
+    std::cout << "Scenario kinetics and prices:" << std::endl;
+    mismatches = 0;
+    for (int c = 0; c < batch.Size(); c++)
+    {
+        double base = scores[c * count];
+        if (base == -50000)
+            continue;
+        if (std::fabs(scores[c * count + 3] - base) > 1e-6 * (1 + std::fabs(base)) ||
+            std::fabs(scores[c * count + 4] - 2 * base) > 1e-9 * (1 + std::fabs(base)))
+            mismatches++;
+    }
+    if (mismatches == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // statistics of known scores: the worst tenth of the weight lies in the lowest score,
+    // which carries an eighth of it
+    std::cout << "Robust statistics of scenario scores:" << std::endl;
+    std::vector<double> known = {10, -50000, 30, 40, 20};
+    std::vector<circuit_scenario> weighted(5);
+    weighted[1].weight = 0.5;
+    weighted[2].weight = 0.5;
+    scenario_statistics statistics = Scenario_Statistics(known.data(), weighted, 0.1);
+    scenario_statistics worst = Scenario_Statistics(known.data(), weighted, 0);
+    scenario_statistics nothing = Scenario_Statistics(NULL, std::vector<circuit_scenario>(), 0.1);
+    double mean = (10 - 25000 + 15 + 40 + 20) / 4.0;
+    double variance = ((10 - mean) * (10 - mean) + 0.5 * (-50000 - mean) * (-50000 - mean) +
+                       0.5 * (30 - mean) * (30 - mean) + (40 - mean) * (40 - mean) + (20 - mean) * (20 - mean)) / 4;
+    if (std::fabs(statistics.mean - mean) < 1e-9 && std::fabs(statistics.std_dev - std::sqrt(variance)) < 1e-6 &&
+        statistics.worst == -50000 && statistics.best == 40 && statistics.tail_mean == -50000 &&
+        statistics.failures == 1 && worst.tail_mean == -50000 && nothing.mean == 0 && nothing.failures == 0 &&
+        Scenario_Statistics(known.data(), weighted, 0.5).tail_mean == (0.5 * -50000 + 1 * 10 + 0.5 * 20) / 2)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the constructor keeps the tolerance and iterations it is given, seen on a circuit
+    // with a recycle that takes a while to settle
+    std::cout << "Evaluate_Circuit uses the constructor tolerance:" << std::endl;
+    size_t recycle = 0;
+    for (size_t i = 2; i < population.size() && recycle == 0; i++)
+    {
+        CCircuit circuit(population[i]);
+        if (circuit.Evaluate_Circuit(1e-8, 1000) != -50000 && circuit.Last_Iterations() > 10)
+            recycle = i;
+    }
+    CCircuit loose(population[recycle], 1e-2, 1000);
+    CCircuit tight(population[recycle], 1e-8, 1000);
+    CCircuit short_run(population[recycle], 1e-8, 2);
+    if (recycle > 0 && loose.Evaluate_Circuit() == CCircuit(population[recycle]).Evaluate_Circuit(1e-2, 1000) &&
+        tight.Evaluate_Circuit() == CCircuit(population[recycle]).Evaluate_Circuit(1e-8, 1000) &&
+        loose.Last_Iterations() < tight.Last_Iterations() && short_run.Evaluate_Circuit() == -50000)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
@@ -1,7 +1,7 @@
 /**
- * @file test1.cpp
+ * @file test3.cpp
  * @author Wan, Ian I
- * @version 0.2
+ * @version 0.3
  * @date 2022-03-25
  * 
  * @copyright Copyright (c) 2022
@@ -11,13 +11,33 @@
 #include <cmath>
 #include "../includes/Genetic_Algorithm.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 int main(int argc, char *argv[])
 {
 
     double exact = 375.495;
-    double score = Genetic_Algorithm();
+    unsigned long seed = 7;
+
+    #ifdef _OPENMP
+      omp_set_num_threads(1);
+    #endif
+    double serial = Genetic_Algorithm(seed);
+
+    #ifdef _OPENMP
+      omp_set_num_threads(4);
+    #endif
+    double parallel = Genetic_Algorithm(seed);
+
+    if (std::fabs(serial - exact) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
 
-    if (std::fabs(score - exact) < 0.01)
+    // a seed must give the same result on any number of threads
+    if (serial == parallel)
         std::cout << "pass" << std::endl;
     else
         std::cout << "fail" << std::endl;
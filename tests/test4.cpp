@@ -0,0 +1,69 @@
+/**
+ * @file test4.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <iostream>
+#include "../includes/CCircuit.h"
+#include "../includes/CFitnessCache.h"
+
+int main(int argc, char *argv[])
+{
+    int vec1[2 * num_units + 1] = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                                   10, 11, 10, 11, 10, 11, 10, 11};
+    int vec2[2 * num_units + 1] = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11,
+                                   7, 11, 8, 11, 9, 11, 10, 11};
+    int vec3[2 * num_units + 1] = {7, 4, 3, 5, 9, 10, 6, 6, 8, 8, 1, 2, 4,
+                                   0, 2, 0, 11, 5, 7, 6, 2};
+
+    CFitnessCache cache(2);
+    double score = 0;
+
+    // a miss leaves the counters consistent and stores nothing
+    std::cout << "Lookup before insert:" << std::endl;
+    if (!cache.Find(vec1, score) && cache.misses == 1 && cache.Size() == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    CCircuit circuit2(vec2);
+    cache.Insert(vec1, -979.269);
+    cache.Insert(vec2, circuit2.Evaluate_Circuit());
+
+    std::cout << "Lookup after insert:" << std::endl;
+    if (cache.Find(vec2, score) && std::fabs(score - 57.7668) < 0.01 && cache.hits == 1)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // vec1 is now the least recently used entry and is evicted first
+    cache.Insert(vec3, 1.0);
+
+    std::cout << "Eviction keeps the cache bounded:" << std::endl;
+    if (cache.Size() == 2 && cache.evictions == 1 && !cache.Find(vec1, score) &&
+        cache.Find(vec2, score) && cache.Find(vec3, score))
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+    // steady-state flows ride along with the score and reading them moves nothing
+    CFitnessCache flows_cache(2);
+    double flows[2 * num_units], stored[2 * num_units];
+    circuit2.Get_Flows(flows);
+    flows_cache.Insert(CFitnessCache::Make_Key(vec2), circuit2.Evaluate_Circuit(), flows);
+    flows_cache.Insert(CFitnessCache::Make_Key(vec2), 57.7668);
+    bool close = flows_cache.Find_Flows(CFitnessCache::Make_Key(vec2), stored);
+    for (int i = 0; i < 2 * num_units; i++)
+        close = close && std::fabs(stored[i] - flows[i]) <= 1e-5 * std::fabs(flows[i]) + 1e-6;
+
+    std::cout << "Flows stored with the score:" << std::endl;
+    if (close && !flows_cache.Find_Flows(CFitnessCache::Make_Key(vec1), stored) && flows_cache.hits == 0 &&
+        flows_cache.misses == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
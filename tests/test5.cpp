@@ -0,0 +1,147 @@
+/**
+ * @file test5.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <iostream>
+#include "../includes/CUnit.h"
+#include "../includes/CCircuit.h"
+
+int main(int argc, char *argv[])
+{
+    int vec1[2 * num_units + 1] = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                                   10, 11, 10, 11, 10, 11, 10, 11};
+    int vec2[2 * num_units + 1] = {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11,
+                                   7, 11, 8, 11, 9, 11, 10, 11};
+    // heavy recycle - substitution needs hundreds of sweeps
+    int vec3[2 * num_units + 1] = {1, 9, 5, 5, 11, 0, 7, 10, 2, 3, 7, 1, 8, 2,
+                                   4, 9, 1, 5, 3, 2, 6};
+    // fails Check_Validity: units 1 to 3 and 5 to 9 never reach an outlet so there is no steady state
+    int vec4[2 * num_units + 1] = {0, 10, 4, 2, 3, 3, 1, 1, 2, 11, 5, 6, 1,
+                                   7, 1, 8, 1, 9, 1, 1, 2};
+    // valid, but the tailings of the feed unit go round units 0, 1, 3, 8 and 2 and never
+    // reach the outlet, so waste piles up and there is no steady state
+    int vec5[2 * num_units + 1] = {3, 9, 1, 6, 3, 0, 4, 2, 8, 3, 7, 4, 11,
+                                   5, 3, 10, 2, 9, 2, 6, 8};
+    // scores about -145, far enough below 50 for an estimate to stop it long before it converges
+    int vec6[2 * num_units + 1] = {5, 8, 5, 9, 2, 6, 11, 2, 7, 2, 3, 3, 9,
+                                   10, 3, 2, 8, 0, 1, 4, 8};
+    // recycle that takes about 250 sweeps to score about -18.6, while the rate its feed rates
+    // settle at swings over three sweeps, so a couple of low rates understate how far it has
+    // still to go
+    int vec7[2 * num_units + 1] = {2, 6, 7, 3, 8, 6, 11, 10, 2, 2, 9, 8, 11,
+                                   0, 11, 4, 11, 1, 9, 5, 1};
+
+    CCircuit newton1(vec1), newton2(vec2), newton3(vec3), newton4(vec4);
+    CCircuit substitution3(vec3);
+    newton1.Set_Solver(NEWTON);
+    newton2.Set_Solver(NEWTON);
+    newton3.Set_Solver(NEWTON);
+    newton4.Set_Solver(NEWTON);
+
+    std::cout << "Newton solver on test2 circuits:" << std::endl;
+    if (std::fabs(newton1.Evaluate_Circuit(1e-8, 1000) + 979.269) < 0.01 &&
+        std::fabs(newton2.Evaluate_Circuit(1e-8, 1000) - 57.7668) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Newton solver on a recycle circuit:" << std::endl;
+    double substitution_score = substitution3.Evaluate_Circuit(1e-8, 1000);
+    double newton_score = newton3.Evaluate_Circuit(1e-8, 1000);
+    if (std::fabs(substitution_score - newton_score) < 0.01 && !newton3.Fell_Back() &&
+        newton3.Last_Iterations() < substitution3.Last_Iterations() / 10)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Newton solver falls back without a steady state:" << std::endl;
+    if (newton4.Evaluate_Circuit() == -50000 && newton4.Fell_Back())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+    // restarting from its own steady state the recycle circuit converges at once
+    double flows[2 * num_units];
+    newton3.Get_Flows(flows);
+    CCircuit warm3(vec3);
+    warm3.Set_Initial_Flows(flows);
+    double warm_score = warm3.Evaluate_Circuit(1e-8, 1000);
+
+    std::cout << "Warm start from a steady state:" << std::endl;
+    if (std::fabs(warm_score - newton_score) < 0.01 && warm3.Last_Iterations() <= 2)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // a threshold only changes the answer for circuits that cannot beat it, and only on an
+    // estimate if asked to
+    CCircuit scratch;
+    double full6 = Evaluate_Genes(gene_span<int>{vec6, 2 * num_units + 1}, scratch);
+    double kept6 = Evaluate_Genes(gene_span<int>{vec6, 2 * num_units + 1}, scratch, SUBSTITUTION, NULL, 1e-6, 1000, 50);
+    bool certain6 = !scratch.Aborted() && kept6 == full6;
+    double estimate6 = Evaluate_Genes(gene_span<int>{vec6, 2 * num_units + 1}, scratch, SUBSTITUTION, NULL, 1e-6, 1000,
+                                      50, true);
+    bool aborted6 = scratch.Aborted() && scratch.Saved_Sweeps() > 0;
+    double full2 = Evaluate_Genes(gene_span<int>{vec2, 2 * num_units + 1}, scratch, NEWTON);
+    double kept2 = Evaluate_Genes(gene_span<int>{vec2, 2 * num_units + 1}, scratch, NEWTON, NULL, 1e-6, 1000, 50, true);
+    bool aborted2 = scratch.Aborted();
+
+    std::cout << "Threshold stops circuits that cannot beat it:" << std::endl;
+    if (certain6 && aborted6 && estimate6 >= full6 && estimate6 <= 50 && !aborted2 && kept2 == full2 && kept2 > 50)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the estimate is only a heuristic; it must still let through a circuit whose rate
+    // oscillates and that only just beats the threshold
+    double full7 = Evaluate_Genes(gene_span<int>{vec7, 2 * num_units + 1}, scratch);
+    bool misjudged7 = false;
+    for (double margin : {1e-4, 1e-2})
+    {
+        double kept7 = Evaluate_Genes(gene_span<int>{vec7, 2 * num_units + 1}, scratch, SUBSTITUTION, NULL, 1e-6, 1000,
+                                      full7 - margin, true);
+        misjudged7 = misjudged7 || scratch.Aborted() || kept7 != full7;
+    }
+    double estimate7 = Evaluate_Genes(gene_span<int>{vec7, 2 * num_units + 1}, scratch, SUBSTITUTION, NULL, 1e-6, 1000,
+                                      full7 + 1, true);
+
+    std::cout << "Threshold lets through a circuit whose rate oscillates:" << std::endl;
+    if (!misjudged7 && scratch.Aborted() && estimate7 >= full7 && estimate7 <= full7 + 1)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    double full5 = Evaluate_Genes(gene_span<int>{vec5, 2 * num_units + 1}, scratch, NEWTON);
+    int full_sweeps5 = scratch.Last_Iterations();
+    double bound5 = Evaluate_Genes(gene_span<int>{vec5, 2 * num_units + 1}, scratch, NEWTON, NULL, 1e-6, 1000, 0);
+
+    std::cout << "Threshold stops a circuit without a steady state at once:" << std::endl;
+    if (full5 == -50000 && full_sweeps5 >= 1000 && bound5 == -50000 && scratch.Aborted() &&
+        scratch.Last_Iterations() == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // order maps each canonical label back to the unit it came from
+    int canonical[2 * num_units + 1], order[num_units];
+    substitution3.Canonical_Form(canonical, order);
+    bool relabelled = order[0] == vec3[0];
+    for (int i = 0; i < num_units; i++)
+        for (int k = 0; k < 2; k++)
+        {
+            int to = canonical[2 * i + 1 + k];
+            int from = vec3[2 * order[i] + 1 + k];
+            relabelled = relabelled && (to >= num_units ? from == to : order[to] == from);
+        }
+
+    std::cout << "Canonical relabelling order:" << std::endl;
+    if (relabelled)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
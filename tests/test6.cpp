@@ -0,0 +1,57 @@
+/**
+ * @file test6.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/CCircuitBatch.h"
+#include "random_circuits.h"
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::vector<int> > population = {
+        {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9, 10, 11, 10, 11, 10, 11, 10, 11},
+        {0, 1, 11, 2, 11, 3, 11, 4, 11, 5, 11, 6, 11, 7, 11, 8, 11, 9, 11, 10, 11}};
+
+    // random valid circuits, an odd number so the last group is padded
+    srand(1);
+    while (population.size() < 203)
+    {
+        std::vector<int> chromosome(2 * num_units + 1);
+        random_valid_circuit(chromosome.data());
+        population.push_back(chromosome);
+    }
+
+    CCircuitBatch batch(population);
+    std::vector<double> scores(batch.Size());
+    batch.Evaluate_Circuits(scores.data(), 1e-8, 1000);
+
+    std::cout << "Batch evaluation of test2 circuits:" << std::endl;
+    if (std::fabs(scores[0] + 979.269) < 0.01 && std::fabs(scores[1] - 57.7668) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    std::cout << "Batch evaluation matches Evaluate_Circuit:" << std::endl;
+    int mismatches = 0, failures = 0;
+    for (size_t i = 0; i < population.size(); i++)
+    {
+        double expected = CCircuit(population[i]).Evaluate_Circuit(1e-8, 1000);
+        failures += expected == -50000;
+        if (std::fabs(scores[i] - expected) > 1e-9)
+            mismatches++;
+    }
+    // the sample must exercise both converging and failing lanes
+    if (mismatches == 0 && failures > 0 && failures < (int)population.size())
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
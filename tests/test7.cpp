@@ -0,0 +1,57 @@
+/**
+ * @file test7.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ * 
+ * @copyright Copyright (c) 2022
+ * 
+ */
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../includes/CCircuit.h"
+#include "../includes/Genetic_Algorithm.h"
+
+int main(int argc, char * argv[])
+{
+    std::vector<int> vec10 = {0, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 8, 9,
+                              10, 11, 10, 11, 10, 11, 10, 11};
+
+    // 4 units in a chain: concentrate to the next unit, tailings to the tailings outlet 5
+    std::vector<int> vec4 = {0, 1, 5, 2, 5, 3, 5, 4, 5};
+
+    // the same chain with the last unit feeding itself
+    std::vector<int> bad4 = {0, 1, 5, 2, 5, 3, 5, 3, 5};
+
+    // sizes outside min_units to max_units are not built in
+    std::vector<int> vec3 = {0, 1, 4, 2, 4, 3, 4};
+
+    // the dispatcher must agree with the default circuit size
+    if (Circuit_Validity(vec10) && Circuit_Performance(vec10, SUBSTITUTION, 1e-8, 1000) ==
+        CCircuit(vec10).Evaluate_Circuit(1e-8, 1000))
+        std::cout << "pass\n";
+    else
+        std::cout << "fail\n";
+
+    // and with the circuit of the size it dispatches to
+    CCircuitN<4> circuit4(vec4);
+    circuit4.Set_Solver(NEWTON);
+    if (Circuit_Validity(vec4) && !Circuit_Validity(bad4) &&
+        Circuit_Performance(vec4, NEWTON) == circuit4.Evaluate_Circuit() && Circuit_Performance(vec4) > 0)
+        std::cout << "pass\n";
+    else
+        std::cout << "fail\n";
+
+    if (!Circuit_Validity(vec3) && Circuit_Performance(vec3) == -50000 &&
+        !Circuit_Validity(std::vector<int>(vec4.begin(), vec4.end() - 1)))
+        std::cout << "pass\n";
+    else
+        std::cout << "fail\n";
+
+    // a small circuit design runs end to end through the runtime size
+    if (Genetic_Algorithm(1, min_units) > 0 && Genetic_Algorithm(1, max_units + 1) == 0)
+        std::cout << "pass\n";
+    else
+        std::cout << "fail\n";
+}
@@ -0,0 +1,56 @@
+/**
+ * @file test8.cpp
+ * @author Wan, Ian I
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <iostream>
+#include "../includes/CCircuit.h"
+#include "../includes/Genetic_Algorithm.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+int main(int argc, char *argv[])
+{
+
+    unsigned long seed = 3;
+    int unit_num = 6;
+    int generations = 100;
+    int interval = 25;
+    double serial[2], parallel[2];
+
+    #ifdef _OPENMP
+      omp_set_num_threads(1);
+    #endif
+    serial[0] = Island_Genetic_Algorithm(seed, unit_num, 4, generations, interval, NUM_MIGRANTS, RING);
+    serial[1] = Island_Genetic_Algorithm(seed, unit_num, 4, generations, interval, NUM_MIGRANTS, ALL_TO_ALL);
+
+    #ifdef _OPENMP
+      omp_set_num_threads(4);
+    #endif
+    parallel[0] = Island_Genetic_Algorithm(seed, unit_num, 4, generations, interval, NUM_MIGRANTS, RING);
+    parallel[1] = Island_Genetic_Algorithm(seed, unit_num, 4, generations, interval, NUM_MIGRANTS, ALL_TO_ALL);
+
+    // every topology finds a working circuit
+    if (serial[0] > 0 && serial[1] > 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // islands exchange migrants in a fixed order, so the thread count does not change the result
+    if (serial[0] == parallel[0] && serial[1] == parallel[1])
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // sizes that are not built in are rejected
+    if (Island_Genetic_Algorithm(seed, max_units + 1) == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}
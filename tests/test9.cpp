@@ -0,0 +1,107 @@
+/**
+ * @file test9.cpp
+ * @author Galena Group
+ * @version 0.1
+ * @date 2022-03-25
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../includes/CRandom.h"
+#include "../includes/CSelection.h"
+
+/**
+ * @brief   Share of draws that select each parent
+ *
+ * @param   selection       Selection after Build
+ * @param   draws           Number of draws
+ * @return  vector          Fraction of the draws that chose each parent, or empty if any draw was out of range
+ */
+static std::vector<double> shares(const CSelection &selection, int draws)
+{
+    std::vector<double> share(selection.Size(), 0);
+
+    for (int i = 0; i < draws; i++)
+    {
+        CRandom rng(9, 1, i);
+        int parent = selection.Select(&rng);
+        if (parent < 0 || parent >= selection.Size())
+            return std::vector<double>();
+        share[parent] += 1.0 / draws;
+    }
+    return share;
+}
+
+int main(int argc, char *argv[])
+{
+    const int draws = 100000;
+    std::vector<double> share;
+
+    // weights 1, 2 and 5 out of 8
+    CSelection roulette(ROULETTE);
+    roulette.Build({10, 20, 50});
+    share = shares(roulette, draws);
+
+    std::cout << "Roulette in proportion to the score:" << std::endl;
+    if (share.size() == 3 && std::fabs(share[0] - 0.125) < 0.01 && std::fabs(share[1] - 0.25) < 0.01 &&
+        std::fabs(share[2] - 0.625) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // shifted to weights 0, 5 and 10; the worst parent is never chosen
+    roulette.Build({-10, -5, 0});
+    share = shares(roulette, draws);
+
+    std::cout << "Roulette with scores that are not positive:" << std::endl;
+    if (share.size() == 3 && share[0] == 0 && std::fabs(share[1] - 1.0 / 3) < 0.01 &&
+        std::fabs(share[2] - 2.0 / 3) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    roulette.Build({-50000, -50000});
+    share = shares(roulette, draws);
+
+    std::cout << "Roulette with equal scores:" << std::endl;
+    if (share.size() == 2 && std::fabs(share[0] - 0.5) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // ranks 2, 3 and 1 out of 6, whatever the scale of the scores
+    CSelection rank(RANK);
+    rank.Build({1, 1e6, -3});
+    share = shares(rank, draws);
+
+    std::cout << "Rank in proportion to the rank:" << std::endl;
+    if (share.size() == 3 && std::fabs(share[0] - 2.0 / 6) < 0.01 && std::fabs(share[1] - 3.0 / 6) < 0.01 &&
+        std::fabs(share[2] - 1.0 / 6) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the best of two draws: the best parent wins 5/9 of the tournaments, the worst 1/9
+    CSelection tournament(TOURNAMENT, 2);
+    tournament.Build({3, 1, 2});
+    share = shares(tournament, draws);
+
+    std::cout << "Tournament of two:" << std::endl;
+    if (share.size() == 3 && std::fabs(share[0] - 5.0 / 9) < 0.01 && std::fabs(share[1] - 1.0 / 9) < 0.01 &&
+        std::fabs(share[2] - 3.0 / 9) < 0.01)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+
+    // the draw of a slot depends only on its stream
+    CRandom first(4, 2, 7), second(4, 2, 7);
+
+    std::cout << "Same stream, same parent:" << std::endl;
+    if (tournament.Select(&first) == tournament.Select(&second) && CSelection().Size() == 0)
+        std::cout << "pass" << std::endl;
+    else
+        std::cout << "fail" << std::endl;
+}